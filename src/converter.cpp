@@ -3,6 +3,7 @@
 #include <vector>
 #include <algorithm> // For std::reverse
 #include <cctype>    // For std::isdigit, std::isalpha, std::toupper
+#include <climits>   // For LLONG_MIN, LLONG_MAX
 
 namespace BaseConverter {
 
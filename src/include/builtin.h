@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <iosfwd>
+#include <cstddef>
 
 // Built-in command handlers
 void builtin_cd(const std::vector<std::string>& args);
@@ -9,25 +11,67 @@ void builtin_pwd(const std::vector<std::string>& args);
 void builtin_echo(const std::vector<std::string>& args);
 void builtin_help(const std::vector<std::string>& args);
 void builtin_list(const std::vector<std::string>& args);
+void builtin_top(const std::vector<std::string>& args);
+void builtin_ptree(const std::vector<std::string>& args);
 void builtin_date(const std::vector<std::string>& args);
 void builtin_dir(const std::vector<std::string>& args);
+void builtin_find(const std::vector<std::string>& args);
 void builtin_path(const std::vector<std::string>& args);
 void builtin_addpath(const std::vector<std::string>& args);
+void builtin_hash(const std::vector<std::string>& args);
 void builtin_mkdir(const std::vector<std::string>& args);
 void builtin_rmdir(const std::vector<std::string>& args);
 void builtin_touch(const std::vector<std::string>& args);
 void builtin_rm(const std::vector<std::string>& args);
 void builtin_cat(const std::vector<std::string>& args);
 void builtin_rem(const std::vector<std::string>& args);
+void builtin_source(const std::vector<std::string>& args);
 void builtin_cls(const std::vector<std::string>& args);
+void builtin_parallel(const std::vector<std::string>& args);
 
 
 
 
+// --- Built-in registry ---
+// Every built-in is one BuiltinInfo entry; dispatch and `help` both read it.
+
+typedef void (*BuiltinHandler)(const std::vector<std::string>& args);
+typedef void (*StreamBuiltinHandler)(const std::vector<std::string>& args, std::istream& in, std::ostream& out);
+
+enum BuiltinFlags : unsigned {
+    BUILTIN_HIDDEN = 1u << 0,   // Not listed by `help`
+};
+
+struct BuiltinInfo {
+    const char* name;
+    BuiltinHandler run;
+    StreamBuiltinHandler stream;   // Set for built-ins that can run as in-process pipeline stages
+    unsigned flags;
+    const char* section;           // `help` heading
+    const char* usage;
+    const char* help;
+    const char* details;           // Extra `help` lines, or nullptr
+};
+
+// One hash probe; nullptr when `name` is not a built-in
+const BuiltinInfo* find_builtin(const std::string& name);
+
+// All entries, in `help` order
+const BuiltinInfo* builtin_table(size_t& count);
+
 // Utility to check and dispatch built-in commands
 bool is_builtin(const std::string& cmd);
 void run_builtin(const std::vector<std::string>& args);
 
+// Built-ins that can run as in-process pipeline stages on their own streams
+bool is_stream_builtin(const std::string& cmd);
+void run_stream_builtin(const std::vector<std::string>& args, std::istream& in, std::ostream& out);
+
+// Exit status of the built-in last run on this thread. Handlers report a
+// failure with set_builtin_status(); callers reset it to 0 before each run.
+void set_builtin_status(int status);
+int builtin_status();
+
 // process_manager.h
 void builtin_pinfo(const std::vector<std::string>& args);
 void builtin_kill(const std::vector<std::string>& args);
@@ -35,7 +79,17 @@ void builtin_stop(const std::vector<std::string>& args);
 void builtin_resume(const std::vector<std::string>& args);
 void builtin_mlist(const std::vector<std::string>& args);
 
+// job_control.h
+void builtin_jobs(const std::vector<std::string>& args);
+void builtin_fg(const std::vector<std::string>& args);
+void builtin_bg(const std::vector<std::string>& args);
+void builtin_wait(const std::vector<std::string>& args);
+void builtin_time(const std::vector<std::string>& args);
+void builtin_run(const std::vector<std::string>& args);
+
 void builtin_monitor(const std::vector<std::string>& args);
 void builtin_stopmonitor(const std::vector<std::string>& args);
+void builtin_events(const std::vector<std::string>& args);
+void builtin_watch(const std::vector<std::string>& args);
 void builtin_monitor_silent(const std::vector<std::string>& args);
 
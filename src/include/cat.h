@@ -0,0 +1,17 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// `cat [-n] [-A] [file|- ...]`: the files (or stdin) one after another.
+//
+// Bytes are passed through untouched, binary files included. A regular
+// file going to a descriptor (the shell's stdout, or a pipe into a program)
+// is handed to the kernel with sendfile(), so its bytes never enter the
+// shell. Everything else is read in 1 MiB blocks. -n numbers every output
+// line, counting on across files; -A shows tabs as ^I, other control bytes
+// as ^X or M-X, and marks each line end with $.
+//
+// Returns the exit status for the built-in: 1 if any file could not be read
+// or sent.
+int run_cat(const std::vector<std::string>& args, std::istream& in, std::ostream& out);
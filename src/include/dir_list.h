@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Directories with at least this many entries are stat'ed by several threads
+const size_t kParallelStatEntries = 100000;
+
+// `dir [-l] [-a] [-S] [-t] [-R] [path ...]`, listed inside the shell.
+//
+// On Linux a directory is read with getdents64 into a 1 MiB buffer, so a
+// few system calls cover thousands of entries, and names go into one shared
+// pool instead of a string each. Nothing is stat'ed unless the listing needs
+// it: -l asks statx for everything, -S and -t only for the size or the
+// modification time, and -R only for entries whose type getdents64 left
+// unknown. Directories of kParallelStatEntries or more are stat'ed by one
+// thread per CPU, each on its own slice. Windows gets sizes and times from
+// FindFirstFileEx itself.
+//
+// Names sort bytewise; -S puts the largest first and -t the newest. Short
+// listings go in columns on a terminal and one per line elsewhere.
+//
+// Returns the exit status for the built-in: 1 if any path could not be read.
+int run_dir(const std::vector<std::string>& args, std::ostream& out);
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Directory reading and stat'ing shared by `dir`/`ls` and `find`.
+
+// getdents64 buffer: one call returns thousands of entries
+const size_t kDentsBuffer = 1 << 20;
+
+// Listings are built up in memory and written in pieces of this size
+const size_t kListingFlush = 64 * 1024;
+
+enum class FileKind : unsigned char { Unknown, Regular, Directory, Symlink, Other };
+
+// What stat (or FindFirstFileEx) said about one file. Until `statted` only
+// the kind may be known, from the directory entry itself.
+struct FileInfo {
+    FileKind kind = FileKind::Unknown;
+    bool statted = false;
+    uint32_t mode = 0;              // st_mode (Windows: file attributes)
+    uint32_t nlink = 0;
+    uint32_t uid = 0;
+    uint32_t gid = 0;
+    uint64_t size = 0;
+    uint64_t blocks = 0;            // 512-byte units
+    int64_t mtime = 0;              // seconds since the epoch
+    uint32_t mtimeNsec = 0;
+};
+
+#ifdef _WIN32
+
+std::wstring to_wide(const std::string& s);
+
+// From the fields WIN32_FIND_DATA and WIN32_FILE_ATTRIBUTE_DATA share
+void fill_file_info(FileInfo& f, DWORD attributes, DWORD sizeHigh, DWORD sizeLow, const FILETIME& written);
+
+#else
+
+FileKind file_kind_of_dtype(unsigned char type);
+void fill_file_info(FileInfo& f, const struct stat& st);
+
+// `name` inside the directory `dirFd`, without following a symlink. statx
+// is asked only for the STATX_* fields in `mask`; fstatat stands in where
+// the kernel has no statx. false (errno set) when it failed.
+bool stat_at(int dirFd, const char* name, unsigned mask, FileInfo& f);
+
+// Reads directories with getdents64 into one buffer, allocated on first use
+// and kept for the next directory
+class DirReader {
+public:
+    // Calls fn(name, kind) for every entry of the open directory `fd`, "."
+    // and ".." included, until fn returns false. Returns 0, or the errno
+    // that ended the read.
+    template <typename Fn>
+    int read(int fd, Fn fn) {
+        if (!buf) buf.reset(new char[kDentsBuffer]);
+        while (true) {
+            long n = syscall(SYS_getdents64, fd, buf.get(), kDentsBuffer);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return errno;
+            if (n == 0) return 0;
+            for (long offset = 0; offset < n;) {
+                const auto* d = reinterpret_cast<const struct dirent64*>(buf.get() + offset);
+                offset += d->d_reclen;
+                if (!fn(d->d_name, file_kind_of_dtype(d->d_type))) return 0;
+            }
+        }
+    }
+
+private:
+    std::unique_ptr<char[]> buf;
+};
+
+#endif
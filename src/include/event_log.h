@@ -0,0 +1,50 @@
+#pragma once
+#include "proc_monitor.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Where the monitor threads put what they see, instead of printing it.
+//
+// log_monitor_event() packs an event into 64 bytes and pushes it onto a
+// lock-free MPSC ring (event_ring.h): one compare-and-swap, no lock and no
+// console write, so a burst of process churn never waits on the terminal
+// or interleaves with a foreground job's output. The ring is drained into
+// a bounded history (the newest 65536 events) by whoever reads it: the
+// prompt, `events`, or a producer that finds the ring full. Events are only
+// lost when the ring is full while someone else is draining it.
+struct MonitorEvent {
+    int64_t when_us;                // system_clock, microseconds since the epoch
+    uint32_t pid;
+    uint32_t ppid;
+    int32_t exit_code;
+    uint8_t type;                   // ProcEvent::Type
+    char name[43];                  // cut to fit, NUL-terminated
+};
+
+// Any thread; never blocks
+void log_monitor_event(const ProcEvent& event);
+
+// Events that were lost to a full ring
+uint64_t monitor_events_dropped();
+
+// Print what the monitor saw since the last call, in the monitor's
+// "[NEW PROCESS] PID: ..." form, unless it is silent. The interactive loop
+// calls this before a prompt.
+void report_monitor_events();
+
+// `events [--since T] [--name PATTERN] [--follow]`
+struct EventQuery {
+    bool hasSince = false;
+    std::chrono::system_clock::time_point since;
+    std::string name;               // wildcard on the process name
+    bool follow = false;            // keep printing new events until a key is pressed
+};
+
+// Returns false (after printing why) on a bad option. T is either an age
+// such as 30s, 5m or 2h, or a time of day such as 14:05 or 14:05:30.
+bool parse_event_query(const std::vector<std::string>& args, EventQuery& query);
+
+// Returns the exit status for the built-in
+int print_events(const EventQuery& query);
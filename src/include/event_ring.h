@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded multi-producer, single-consumer queue without locks.
+//
+// Each slot carries a sequence number saying whose turn it is (Vyukov's
+// bounded queue). A producer claims a slot with one compare-and-swap on
+// `head`, copies its value in and publishes it by bumping the slot's
+// sequence; push() never waits and fails only when the ring is full. Only
+// one thread at a time may pop(). N must be a power of two, and T should be
+// small and trivially copyable.
+template <typename T, size_t N>
+class MpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+    MpscRing() {
+        for (size_t i = 0; i < N; ++i) slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // Any thread. false when the ring is full; the value is not queued.
+    bool push(const T& value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[pos & (N - 1)];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t lag = (intptr_t)seq - (intptr_t)pos;
+            if (lag == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;   // the consumer has not freed this slot yet
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // The single consumer. false when nothing (complete) is queued.
+    bool pop(T& out) {
+        Slot& slot = slots[tail & (N - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != tail + 1) return false;
+        out = slot.value;
+        slot.seq.store(tail + N, std::memory_order_release);
+        ++tail;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) size_t tail = 0;
+    Slot slots[N];
+};
@@ -1,5 +1,22 @@
 #pragma once
 #include "parser.h"
 
-// Execute a parsed command: handle built-in vs external, redirect, background
-void executeCommand(const Command &cmd);
\ No newline at end of file
+// Execute a parsed command: handle built-in vs external, redirect, background.
+// Like every execute* function, returns the exit status (0 in the background).
+int executeCommand(const Command &cmd);
+
+// Run a built-in in the shell itself, with stdout/stderr sent to cmd.outfile if set
+struct BuiltinInfo;
+int executeBuiltin(const BuiltinInfo &builtin, const Command &cmd);
+
+// Execute a pipeline: every stage runs concurrently, connected by kernel pipes
+int executePipeline(const Pipeline &pl);
+
+// Execute a command list, skipping items their '&&' / '||' rules out. Lone
+// built-ins run in the shell itself, so a chain of them starts no process.
+int executeList(const CommandList &list);
+
+// Status of the last list item or script line the shell finished ($? in sh);
+// a bare `exit` exits with it
+int last_status();
+void set_last_status(int status);
@@ -0,0 +1,27 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// `find [-j N] [path ...] [-name PATTERN] [-type f|d|l] [-size [+|-]N[ckMG]]
+// [-mtime [+|-]N]`: every path under the given ones (default: .) that passes
+// all the tests, one per line.
+//
+// The tests read as they do for find(1): -name matches the last component
+// with '*' and '?', -size counts 512-byte blocks unless a unit follows and
+// rounds up, -mtime counts whole days since the last change, and +N means
+// more than N, -N less. Symbolic links are listed, never followed.
+//
+// N walkers (default: one per CPU, at most four per CPU) each own a deque
+// of directories still to be read. A walker takes its newest directory, so
+// it goes depth first and keeps few descriptors open; one that runs dry
+// steals the oldest directory of another walker, usually the top of a large
+// subtree nobody has touched. On POSIX each directory is opened relative to
+// its parent's descriptor and read with getdents64, and an entry is stat'ed
+// relative to it only when its name passes and a test needs more than the
+// name and type. Matches collect in a buffer per walker and go to `out` in
+// 64 KiB pieces, whole lines only; their order is not defined. Once `out`
+// fails (`find / | head`), every walker stops.
+//
+// Returns the exit status for the built-in: 1 if any path could not be read.
+int run_find(const std::vector<std::string>& args, std::ostream& out);
@@ -0,0 +1,48 @@
+#pragma once
+#include "process_manager.h"
+#include <string>
+#include <vector>
+
+// Job control: `jobs`, `fg`, `bg` and `wait`, and who owns the terminal.
+//
+// In an interactive shell on a Linux terminal every pipeline runs in its own
+// process group, and a foreground job gets the terminal while it runs, so
+// Ctrl-C and Ctrl-Z reach the job rather than the shell. Scripts, `-c` and
+// piped input keep their children in the shell's group, as sh does.
+// Exit statuses come from the job table, where the reaper records them.
+
+// Take the terminal and ignore the job-control stops. Called once by an
+// interactive shell; does nothing unless stdin is a terminal.
+void job_control_init();
+
+// Whether pipelines get process groups of their own
+bool job_control_enabled();
+
+#ifndef _WIN32
+// Waits for the job in the foreground, with the terminal handed to it.
+// Returns the exit status of its last process and drops the job. A job
+// stopped by Ctrl-Z stays in the table as a suspended background job:
+// `stopped` is set and the result is 128 + SIGTSTP.
+int wait_foreground(int job, bool& stopped);
+#endif
+
+// `time`: while a sink is set, what every foreground process reaped on this
+// thread cost is added to it (peak memory is the largest of them).
+void collect_foreground_usage(ProcessUsage* sink);
+void record_foreground_usage(const ProcessUsage& usage);
+
+// Print "[N] Done ..." for background jobs that have finished since the last
+// call, then forget them. The interactive loop calls this before a prompt.
+void report_finished_jobs();
+
+// `jobs [-l]`
+int print_jobs(bool showPids);
+
+// `fg [%N]` and `bg [%N]`; 0 picks the newest job
+int foreground_job(int job);
+int background_job(int job);
+
+// `wait [-n] [%N|pid ...]`: returns the exit status as sh does. Stopped jobs
+// are not waited for: a plain `wait` skips them with a warning, and naming
+// one returns 128 + SIGTSTP at once.
+int wait_jobs(const std::vector<std::string>& specs, bool any);
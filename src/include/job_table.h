@@ -0,0 +1,61 @@
+#pragma once
+#include "process_manager.h"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The processes this shell launched, grouped into numbered jobs.
+//
+// Lookups by pid go through a hash map and lookups by job id index a vector,
+// so both are O(1). Job ids are reused the way sh does it: a new job gets
+// one more than the highest id still in use. All members may be called from
+// any thread. Every call holds one plain mutex for a few map operations (a
+// snapshot copies under it); a reader-writer lock would let a busy reader
+// starve the reaper. The wait calls sleep on a condition variable that
+// finish() and remove() signal, so `wait` costs nothing until a job ends.
+class JobTable {
+public:
+    // Returns the job id: `job` itself, or a new one when `job` is 0
+    int add(proc_id pid, const std::string& name, bool background, int job = 0);
+
+    // false when the pid is not in the table
+    bool remove(proc_id pid);
+    bool setStatus(proc_id pid, ProcessStatus status);
+    bool setBackground(proc_id pid, bool background);
+    bool setLimits(proc_id pid, const std::string& limits);
+    // Marks the process Done with its exit status and what it cost
+    bool finish(proc_id pid, int exitStatus, const ProcessUsage& usage = ProcessUsage());
+    bool find(proc_id pid, ProcessInfo& out) const;
+
+    // The processes of one job in launch order; empty if there is no such job
+    std::vector<ProcessInfo> job(int id) const;
+
+    // Every process, ordered by job and then launch order
+    std::vector<ProcessInfo> snapshot() const;
+
+    size_t size() const;
+
+    // Blocks until every one of `pids` is Done or gone from the table
+    void waitDone(const std::vector<proc_id>& pids) const;
+
+    // Blocks until every process of one of `ids` (of every job with a
+    // background process when `ids` is empty) is Done, and returns that
+    // job's id; 0 once none of them is left to wait for. Stopped jobs are
+    // not waited for.
+    int waitAnyDone(const std::vector<int>& ids) const;
+
+private:
+    mutable std::mutex mutex;
+    mutable std::condition_variable changed;
+    std::unordered_map<proc_id, ProcessInfo> byPid;
+    std::vector<std::vector<proc_id>> jobs;   // index = job id; jobs[0] is unused
+};
+
+// The table behind `mlist`, `pinfo` and the process monitor
+JobTable& job_table();
+
+// Parses a job spec such as "%2"; false if `spec` is not one
+bool parse_job_spec(const std::string& spec, int& job);
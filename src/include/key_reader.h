@@ -0,0 +1,28 @@
+#pragma once
+#include <chrono>
+#ifndef _WIN32
+#include <termios.h>
+#endif
+
+// Single keys from the terminal, without Enter or echo, while this is
+// alive (`top`, `events --follow`). Ctrl-C arrives as key 3 rather than as
+// a signal. When stdin is not a terminal, next() only waits out the deadline.
+class KeyReader {
+public:
+    static const int kNone = -1;        // the deadline passed first
+    static const int kClosed = -2;      // the terminal went away
+
+    KeyReader();
+    ~KeyReader();
+    KeyReader(const KeyReader&) = delete;
+    KeyReader& operator=(const KeyReader&) = delete;
+
+    // The next key, or kNone once `deadline` has passed
+    int next(std::chrono::steady_clock::time_point deadline);
+
+private:
+    bool active = false;
+#ifndef _WIN32
+    termios saved{};
+#endif
+};
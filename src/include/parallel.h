@@ -0,0 +1,16 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// parallel [-j N] command [args...] [::: arg...]
+//
+// Runs `command` once per argument, at most N jobs at a time (default: one
+// per CPU, at most eight per CPU). Arguments follow `:::`, or without it are
+// read one per line from `in`. Every {} in the command is replaced by the
+// argument; if there is no {}, the argument is appended.
+//
+// Each job's stdout is buffered and written to `out` in argument order as
+// soon as every earlier job has finished; stderr is not buffered.
+// Returns the number of jobs that failed (0 when all succeeded).
+int run_parallel(const std::vector<std::string>& args, std::istream& in, std::ostream& out);
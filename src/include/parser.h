@@ -1,7 +1,13 @@
 #pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
 #include <string>
+#include <string_view>
 #include <vector>
 
+struct ResourceLimits;
+
 // Structure to hold parsed command
 struct Command {
     std::vector<std::string> argv;  // Tokens: first element is command name
@@ -9,7 +15,108 @@ struct Command {
     std::string infile;             // Input redirection file
     std::string outfile;            // Output redirection file
     bool appendMode = false;
+    std::shared_ptr<const ResourceLimits> limits;   // set by `run`; null: as the shell has them
+};
+
+// A chain of commands connected with '|': stage i's stdout feeds stage i+1's stdin
+struct Pipeline {
+    std::vector<Command> stages;
+    bool background = false;        // True if the last stage ends with '&'
 };
 
 // Parse the input line into a single Command (no pipe support)
-Command parseCommand(const std::string &line);
\ No newline at end of file
+Command parseCommand(const std::string &line);
+
+// Parse the input line into a Pipeline, splitting stages on unquoted '|'
+Pipeline parsePipeline(const std::string &line);
+
+// --- Zero-allocation parsing ---
+//
+// Bump allocator for the views of one parsed line (or a whole script).
+// The first kInline bytes live inside the object, so parsing an ordinary
+// line never touches the heap; memory is only given back by reset().
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocArray(size_t n) {
+        T* p = static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        for (size_t i = 0; i < n; ++i) new (p + i) T();
+        return p;
+    }
+
+    // Forget everything allocated so far; the largest block is kept for reuse
+    void reset();
+
+private:
+    static const size_t kInline = 4096;
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    alignas(std::max_align_t) char inlineBuf[kInline];
+    std::vector<Block> blocks;
+    char* cur = inlineBuf;
+    char* end = inlineBuf + kInline;
+};
+
+// Command whose strings point into the parsed line, or into the arena where
+// quotes had to be removed from a token
+struct CommandView {
+    std::string_view* argv = nullptr;
+    size_t argc = 0;
+    bool background = false;
+    std::string_view infile;
+    std::string_view outfile;
+    bool appendMode = false;
+};
+
+struct PipelineView {
+    CommandView* stages = nullptr;
+    size_t count = 0;
+    bool background = false;
+};
+
+// Parse without allocating: the result stays valid while `line` is alive and
+// until `arena` is reset. Returns false on a syntax error (already reported).
+bool parsePipelineView(std::string_view line, Arena &arena, PipelineView &out);
+
+// Copy a view into owned strings, e.g. right before a command is executed
+Command toCommand(const CommandView &view);
+Pipeline toPipeline(const PipelineView &view);
+
+// --- Command lists ---
+//
+// Pipelines joined by ';', '&', '&&' and '||'; '&' ends a pipeline as ';'
+// does and runs it in the background. A `{ ...; }` group stands in for a
+// pipeline anywhere in a list; it runs in the shell itself, so it cannot be
+// piped, redirected or put in the background. As in sh, '&&' and '||' bind equally and are
+// evaluated left to right, so `a && b || c` runs c when either a or b failed.
+
+struct CommandList;
+
+struct ListItem {
+    enum Connector {
+        ALWAYS,       // First item, or after ';'
+        IF_SUCCESS,   // After '&&'
+        IF_FAILURE,   // After '||'
+    };
+    Connector connector = ALWAYS;
+    Pipeline pipeline;
+    std::shared_ptr<CommandList> group;   // Set for `{ ... }`, in place of pipeline
+};
+
+struct CommandList {
+    std::vector<ListItem> items;
+};
+
+// Parse a whole input line. Returns false on a syntax error, which is printed
+// on stderr or, if `errors` is given, stored there for the caller to report.
+bool parseCommandList(std::string_view line, Arena &arena, CommandList &out, std::string *errors = nullptr);
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Resolves a command name to the absolute path of the program PATH would run,
+// remembering earlier answers like the `hash` table of a POSIX shell.
+// Returns an empty string when the name is not found. Names that already
+// contain a directory separator are returned unchanged and never cached.
+//
+// The whole cache is dropped when PATH changes. PATH directory mtimes are
+// re-read at most once a second; when one has changed, every entry found in
+// that directory or after it is dropped, since a program added earlier in
+// PATH would now win.
+std::string resolve_command(const std::string& name);
+
+// Drops one entry, e.g. when the remembered program has gone away.
+void path_cache_forget(const std::string& name);
+
+// Forgets every remembered location (`hash -r`, `addpath`).
+void path_cache_clear();
+
+// One remembered command
+struct PathCacheEntry {
+    std::string name;
+    std::string path;
+    unsigned long hits;
+};
+
+// Snapshot of the cache, sorted by command name.
+std::vector<PathCacheEntry> path_cache_entries();
@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Compile-time perfect hashing for small, fixed sets of names.
+//
+// build() searches for a seed under which every key lands in its own slot,
+// so a lookup is one hash, one slot read and one string compare. The search
+// runs inside the compiler; a key set with no seed fails the static_assert
+// at the call site instead of degrading at run time.
+namespace perfect_hash {
+
+constexpr uint32_t hash(const char* s, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;   // FNV-1a
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    // Fold the high bits down so the low bits used for the slot see every byte
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+constexpr size_t length(const char* s) {
+    size_t n = 0;
+    while (s[n]) ++n;
+    return n;
+}
+
+static const size_t npos = SIZE_MAX;
+
+// Slots must be a power of two; index + 1 is stored so 0 marks an empty slot
+template <size_t Slots>
+struct Table {
+    static_assert((Slots & (Slots - 1)) == 0, "slot count must be a power of two");
+
+    uint32_t seed = 0;
+    bool ok = false;
+    std::array<uint8_t, Slots> slots{};
+
+    // Index of the only key that can match, or npos. The caller still has to
+    // compare the key itself: unknown names hash to some slot too.
+    size_t lookup(const char* s, size_t len) const {
+        uint8_t v = slots[hash(s, len, seed) & (Slots - 1)];
+        return v ? v - 1 : npos;
+    }
+};
+
+// Entry is any type with a `const char* name` member
+template <size_t Slots, typename Entry, size_t N>
+constexpr Table<Slots> build(const Entry (&entries)[N]) {
+    static_assert(N < 255, "too many keys for 8-bit slot indexes");
+    static_assert(N * 2 <= Slots, "use at least twice as many slots as keys");
+
+    size_t lengths[N] = {};
+    size_t used[N] = {};
+    for (size_t i = 0; i < N; ++i) lengths[i] = length(entries[i].name);
+
+    Table<Slots> table;
+    for (uint32_t seed = 0; seed < 100000; ++seed) {
+        size_t placed = 0;
+        for (; placed < N; ++placed) {
+            size_t slot = hash(entries[placed].name, lengths[placed], seed) & (Slots - 1);
+            if (table.slots[slot]) break;
+            table.slots[slot] = (uint8_t)(placed + 1);
+            used[placed] = slot;
+        }
+        if (placed == N) {
+            table.seed = seed;
+            table.ok = true;
+            return table;
+        }
+        // Collision: undo only the slots this seed filled
+        for (size_t i = 0; i < placed; ++i) table.slots[used[i]] = 0;
+    }
+    return table;
+}
+
+} // namespace perfect_hash
@@ -0,0 +1,75 @@
+#pragma once
+#include "process_manager.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+// A process starting, replacing its image or ending, system-wide
+struct ProcEvent {
+    enum Type : unsigned char {
+        Fork,
+        Exec,
+        Exit,
+        Removed,    // a managed process dropped from the job table (Windows sync thread)
+    } type;
+    proc_id pid = 0;
+    proc_id ppid = 0;               // Fork only
+    int exit_code = -1;             // Exit: exit code or 128 + signal; -1 when unknown
+    std::chrono::system_clock::time_point when;
+    std::string name;               // executable name, when still known
+};
+
+#ifndef _WIN32
+// Where the Linux monitor gets its events from. Windows subscribes to WMI
+// in MonitorProcessCreation instead.
+enum class ProcMonitorBackend {
+    Auto,       // netlink when allowed, else the /proc scan
+    Netlink,    // the kernel's proc connector: every fork, exec and exit as it happens
+    ProcScan,   // diffing /proc snapshots; misses processes shorter than a scan
+};
+
+const char* proc_monitor_backend_name(ProcMonitorBackend backend);
+
+// Watches every process on the system.
+//
+// The proc connector (NETLINK_CONNECTOR, CN_IDX_PROC) pushes an event for
+// each fork, exec and exit with no polling, but subscribing needs
+// CAP_NET_ADMIN. Without it the monitor diffs /proc snapshots by pid and
+// start time. That scan adapts its rate: it halves the interval after a
+// scan that found changes and doubles it after a quiet one, between 10 ms
+// and 1 s, and never scans more often than every 10 scan durations, so it
+// stays near 1 s and below 10% of a CPU.
+class ProcMonitor {
+public:
+    typedef std::function<void(const ProcEvent&)> Sink;
+
+    ProcMonitor() = default;
+    ProcMonitor(const ProcMonitor&) = delete;
+    ProcMonitor& operator=(const ProcMonitor&) = delete;
+    ~ProcMonitor();
+
+    // Sets up the backend; false (after printing why) when it cannot start
+    bool open(ProcMonitorBackend want = ProcMonitorBackend::Auto);
+    ProcMonitorBackend backend() const { return active; }
+
+    // Delivers events to `sink` on this thread until `running` turns false
+    // (noticed within 200 ms)
+    void run(const std::atomic<bool>& running, const Sink& sink);
+
+    // Netlink messages the kernel dropped because we read too slowly
+    unsigned long lost() const { return overruns; }
+
+private:
+    ProcMonitorBackend active = ProcMonitorBackend::Auto;
+    int sock = -1;
+    unsigned long overruns = 0;
+    std::unordered_map<proc_id, std::string> names;   // live pids, to name an exit
+
+    bool openNetlink(bool quiet);
+    bool subscribe(bool listen);
+    void runNetlink(const std::atomic<bool>& running, const Sink& sink);
+    void runScan(const std::atomic<bool>& running, const Sink& sink);
+};
+#endif
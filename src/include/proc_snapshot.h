@@ -0,0 +1,60 @@
+#pragma once
+#include "process_manager.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One process as the system reported it at snapshot time
+struct ProcSample {
+    proc_id pid = 0;
+    proc_id ppid = 0;
+    char state = '?';               // R, S, D, Z, T... ('R' for every process on Windows)
+    int threads = 0;
+    uint64_t cpu_ticks = 0;         // user + system time so far, in proc_ticks_per_second() units
+    uint64_t start_ticks = 0;       // start time since boot, same units
+    uint64_t rss_kb = 0;
+    uint64_t vsize_kb = 0;
+    std::string name;               // executable name (comm)
+    std::string cmdline;            // empty unless asked for, or for kernel threads
+};
+
+struct SnapshotOptions {
+    bool cmdline = false;           // also read each full command line (one more file per pid)
+    unsigned threads = 0;           // readers; 0 picks one per kSnapshotChunk pids, up to the CPU count
+};
+
+// Pids one reader thread takes when the thread count is automatic
+const size_t kSnapshotChunk = 1024;
+
+// Every process on the system, ordered by pid.
+//
+// On Linux the pids come from one pass over /proc, and each process costs
+// an openat() of <pid>/stat relative to an open /proc descriptor (plus
+// <pid>/cmdline when asked) read into a buffer the reader thread reuses:
+// no path strings, streams or per-file allocations. Processes that exit
+// mid-walk are dropped. On Windows this is a Toolhelp snapshot with the CPU
+// and memory figures filled in per process.
+std::vector<ProcSample> take_proc_snapshot(const SnapshotOptions& options = SnapshotOptions());
+
+// The unit of cpu_ticks and start_ticks, per second
+uint64_t proc_ticks_per_second();
+
+// Time since boot in the same units: together with start_ticks it gives a
+// process's age for lifetime CPU percentages
+uint64_t proc_uptime_ticks();
+
+// Physical memory in KiB, for memory percentages
+uint64_t proc_total_memory_kb();
+
+// Shell-style wildcard match ('*' and '?'), e.g. for `--filter name=ssh*`
+bool wildcard_match(const char* pattern, const char* text);
+
+// `list [--sort pid|cpu|mem] [--filter name=PATTERN] [--top N]`
+struct ListOptions {
+    enum Sort { BY_PID, BY_CPU, BY_MEM } sort = BY_PID;
+    std::string name;               // wildcard on the executable name; empty lists everything
+    size_t top = 0;                 // 0: no limit
+};
+
+// Returns false (after printing why) on a bad option
+bool parse_list_options(const std::vector<std::string>& args, ListOptions& options);
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include "parser.h"
+#include "process_manager.h"
+#include "stream_pipe.h"
+
+// A process started by a ProcessLauncher
+struct LaunchedProcess {
+    proc_id pid = 0;
+#ifdef _WIN32
+    HANDLE hProcess = NULL;
+    HANDLE hThread = NULL;
+    std::wstring cmdline;
+#else
+    // Set before launch(): the process group to join. 0 starts a new group
+    // led by the process itself; -1 stays in the shell's.
+    pid_t pgid = -1;
+#endif
+};
+
+// Starts external programs. executeCommand/executePipeline only talk to this
+// interface, so each platform keeps its spawning details in one place.
+class ProcessLauncher {
+public:
+    virtual ~ProcessLauncher() {}
+
+    // Start cmd.argv with `in`/`out` as stdin/stdout (kNoHandle keeps the
+    // shell's own). cmd.infile/cmd.outfile take precedence over the handles.
+    // The launcher does not take ownership of `in`/`out`.
+    virtual bool launch(const Command& cmd, os_handle in, os_handle out, LaunchedProcess& proc) = 0;
+
+    // Block until the process exits and return its exit status (-1 on error)
+    virtual int wait(LaunchedProcess& proc) = 0;
+
+    // Drop any handles still held for the process
+    virtual void release(LaunchedProcess& proc) {}
+};
+
+// The launcher for the platform the shell was built for
+ProcessLauncher& default_launcher();
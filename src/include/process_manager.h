@@ -1,29 +1,92 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
+#ifdef _WIN32
 #include <windows.h>
+typedef DWORD proc_id;
+#else
+#include <sys/types.h>
+typedef pid_t proc_id;
+#endif
 
-extern bool monitor_running;
+extern std::atomic<bool> monitor_running;
 extern bool monitor_silent; 
+
+enum class ProcessStatus : unsigned char {
+    Running,
+    Suspended,
+    Done,       // Exited and reaped; exit_status holds the result
+};
+
+const char* process_status_name(ProcessStatus status);
+
+// What a process cost. Recorded when it is reaped; sampled live while it runs.
+struct ProcessUsage {
+    double user_sec = 0;
+    double sys_sec = 0;
+    long max_rss_kb = 0;            // peak resident set
+    uint64_t read_chars = 0;        // through read()/write(), pipes and terminals included
+    uint64_t write_chars = 0;
+    uint64_t read_bytes = 0;        // what actually reached storage
+    uint64_t write_bytes = 0;
+
+    ProcessUsage& operator+=(const ProcessUsage& o);
+};
+
 struct ProcessInfo {
-    DWORD pid;
-    std::string name;
-    std::string status;
+    proc_id pid;
+    int job_id;                     // `%N`; the stages of a pipeline share one job
+    ProcessStatus status;
     bool is_background; 
+    std::string name;
+    proc_id ppid = 0;               // the shell, which launched it
+    std::string limits;             // what `run` applied before it started; empty if nothing
+    int exit_status = -1;           // Once Done: exit code, or 128 + signal number
+    std::chrono::system_clock::time_point started;
+    std::chrono::system_clock::time_point ended;   // once Done
+    ProcessUsage usage;             // once Done
 };
 
-void list_processes();
+struct ListOptions;
+
+// `list`: every process on the system, sorted, filtered and cut as asked
+void list_processes(const ListOptions& options);
+
+bool stop_process(proc_id pid);
+
+bool resume_process(proc_id pid);
+
+bool kill_process(proc_id pid);
+
+enum class ProcessAction { Kill, Stop, Resume };
+
+// `kill`, `stop` and `resume`. The target is a pid, a %job (one signal to
+// its process group when it has one), `-g PGID` (POSIX), `--tree PID` (the
+// pid and every descendant, frozen first when killing) or a name pattern
+// such as 'ssh*'. Never the shell itself. Returns the built-in's status.
+int act_on_processes(ProcessAction action, const std::vector<std::string>& args);
 
-bool stop_process(DWORD pid);
+// Register a launched process; job 0 starts a new job. Returns the job id.
+#ifdef _WIN32
+int addProcess(DWORD pid, const std::wstring &cmdline, HANDLE hProcess, bool is_background, int job = 0);
+#endif
+int addProcess(proc_id pid, const std::string &cmdline, bool is_background, int job = 0);
 
-bool resume_process(DWORD pid);
+// Drop a process from the managed list once its owner has reaped it
+void removeProcess(proc_id pid);
 
-bool kill_process(DWORD pid);
+// Current usage of a live process (best effort: fields it cannot read stay 0)
+bool sample_process_usage(proc_id pid, ProcessUsage& usage);
 
-void addProcess(DWORD pid, const std::wstring &cmdline, HANDLE hProcess, bool is_background);
+// `mlist`; `mlist --long` adds wall time, CPU, peak memory and I/O
+void print_managed_processes(bool long_format = false);
 
-void print_managed_processes();
+void print_process_info(proc_id pid);
 
-void print_process_info(DWORD pid);
+// `pinfo %N`: every process of job N
+void print_job_info(int job);
 
-void MonitorProcessCreation();
\ No newline at end of file
+void MonitorProcessCreation();
@@ -0,0 +1,30 @@
+#pragma once
+#include "process_manager.h"
+
+// Reaps background children as soon as they exit and records their exit
+// status in the job table (the entry turns Done).
+//
+// On Linux one thread sleeps in epoll_wait on a pidfd per watched child, so
+// an exit is noticed within microseconds and an idle shell never wakes up.
+// Kernels without pidfd_open (before 5.3) get a SIGCHLD self-pipe in the same
+// epoll set instead. Foreground children are never watched: whoever launched
+// them waits for them. On Windows the monitor's sync thread still polls.
+void reaper_watch(proc_id pid);
+
+#ifndef _WIN32
+// A pidfd for `pid` (close-on-exec), or -1 where the kernel has none
+int open_pidfd(proc_id pid);
+
+// waitpid() for one child that also collects what it cost: its I/O counters
+// are read from /proc while it is a zombie, then wait4() supplies the
+// rusage. `options` may hold WNOHANG and WUNTRACED. Returns the pid once it
+// exited (or stopped, with WUNTRACED), 0 if WNOHANG found it running, or -1
+// if it is not (or no longer) ours to reap.
+pid_t wait_child(pid_t pid, int options, int& rawStatus, ProcessUsage& usage);
+
+// Fills the I/O fields of `usage` from /proc/<pid>/io
+void read_io_counters(pid_t pid, ProcessUsage& usage);
+
+// Shell-style status of an exited child: its exit code, or 128 + signal
+int exit_status_of(int rawStatus);
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Command;
+
+// What `run` puts on a command before it starts. Zero/empty fields are left
+// as the shell has them.
+struct ResourceLimits {
+    uint64_t memoryBytes = 0;       // address space (RLIMIT_AS); Windows: committed memory
+    uint64_t cpuSeconds = 0;        // CPU time (RLIMIT_CPU: SIGXCPU, then SIGKILL)
+    uint64_t openFiles = 0;         // descriptors (RLIMIT_NOFILE); POSIX only
+    bool hasNice = false;
+    int nice = 0;                   // -20 (first) .. 19 (last); Windows maps it to a priority class
+    std::vector<int> cpus;          // the CPUs it may run on
+
+    bool empty() const { return !memoryBytes && !cpuSeconds && !openFiles && !hasNice && cpus.empty(); }
+
+    // One line for `pinfo`, e.g. "mem 512M, cpu-time 10s, nice 5, cpus 0-3"
+    std::string describe() const;
+};
+
+// `run [--mem SIZE] [--cpu-time SECS] [--files N] [--nice N] [--cpus LIST] [--] cmd args`
+//
+// Splits the options off `run` and leaves the command they apply to in
+// `out`, with the limits attached and `run`'s redirections and '&' kept.
+// SIZE takes a K, M or G suffix; LIST is like 0-3,6. Returns false (after
+// printing why) on a bad option or a missing command.
+bool parse_run_command(const Command& run, Command& out);
+
+#ifdef _WIN32
+#include <windows.h>
+
+// Applies the limits to a process created suspended: a job object for the
+// memory and CPU time, then its priority class and affinity mask. Open files
+// have no Windows counterpart and are ignored. false (after printing why)
+// when one could not be set.
+bool apply_resource_limits(HANDLE process, const ResourceLimits& limits);
+#else
+// Applies the limits to the calling process. Made for the child between
+// fork and exec, so it only makes system calls: no allocation, no locks, no
+// output. Returns 0, or the errno of the first call that failed and the
+// option it belongs to in `what`.
+int apply_resource_limits(const ResourceLimits& limits, const char*& what);
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+
+// Run a script file (`source <file>`, or an inline `< file` with no command).
+//
+// A script is compiled once into a flat list of command lists with redirections
+// decoded and single built-in lines bound to their handlers, then kept in an
+// LRU keyed by absolute path and checked against the file's mtime and size
+// on every run. If TINYSHELL_CACHE_DIR names a directory, compiled scripts
+// are also written there, so a fresh shell can skip parsing as well.
+//
+// A line that does not parse is compiled too: the script stops there with
+// status 2 and the error, on every run, cached or not.
+// Returns the exit status of the last line, or -1 if the script could not be read.
+int run_script(const std::string &path);
+
@@ -0,0 +1,126 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#ifdef _WIN32
+typedef void* os_handle;   // HANDLE
+static os_handle const kNoHandle = (os_handle)(intptr_t)-1; // INVALID_HANDLE_VALUE
+#else
+typedef int os_handle;     // file descriptor
+static const os_handle kNoHandle = -1;
+#endif
+
+// A reference-counted block of bytes handed between in-process pipeline stages.
+// The producer writes straight into `data` and the consumer reads it in place,
+// so no bytes are copied between two adjacent built-ins.
+struct Chunk {
+    static const size_t kCapacity = 64 * 1024;
+
+    std::unique_ptr<char[]> data{new char[kCapacity]};
+    size_t size = 0;
+};
+typedef std::shared_ptr<Chunk> ChunkPtr;
+
+// Bounded single-producer/single-consumer ring of chunks. Consumed chunks are
+// recycled back to the producer, so a running pipeline allocates at most
+// slots + 2 chunks.
+class ChunkRing {
+public:
+    explicit ChunkRing(size_t slots = 8);
+
+    ChunkPtr acquire();          // Empty chunk for the producer to fill
+    bool push(ChunkPtr chunk);   // Blocks while full; false once the reader is gone
+    ChunkPtr pop();              // Blocks while empty; nullptr at end of stream
+    void recycle(ChunkPtr chunk);
+
+    void closeWrite();           // Producer finished: reader sees end of stream
+    void closeRead();            // Consumer finished: further pushes fail
+
+private:
+    std::mutex mtx;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::vector<ChunkPtr> slots;
+    std::vector<ChunkPtr> freeList;
+    size_t head = 0;
+    size_t count = 0;
+    bool writeClosed = false;
+    bool readClosed = false;
+};
+
+// std::streambuf whose put area is the current chunk of a ChunkRing
+class RingOutBuf : public std::streambuf {
+public:
+    explicit RingOutBuf(std::shared_ptr<ChunkRing> ring);
+    ~RingOutBuf() override;
+    void close();
+    bool forward(ChunkPtr chunk);   // Pass a filled chunk on as-is
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+private:
+    bool flushChunk();
+
+    std::shared_ptr<ChunkRing> ring;
+    ChunkPtr current;
+    bool closed = false;
+};
+
+// std::streambuf whose get area is the chunk most recently popped from a ChunkRing
+class RingInBuf : public std::streambuf {
+public:
+    explicit RingInBuf(std::shared_ptr<ChunkRing> ring);
+    ~RingInBuf() override;
+    void close();
+    bool forwardTo(RingOutBuf& out); // Move every remaining chunk to `out`
+
+protected:
+    int_type underflow() override;
+
+private:
+    std::shared_ptr<ChunkRing> ring;
+    ChunkPtr current;
+    bool closed = false;
+};
+
+// Buffered std::streambuf over an OS pipe or file handle, used where a
+// built-in stage borders an external process. Owns and closes the handle.
+class HandleBuf : public std::streambuf {
+public:
+    HandleBuf(os_handle handle, bool output);
+    ~HandleBuf() override;
+    void close();
+    os_handle native() const { return closed ? kNoHandle : handle; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    int_type underflow() override;
+    int sync() override;
+
+private:
+    bool flushBuffer();
+
+    os_handle handle;
+    bool output;
+    bool closed = false;
+    std::unique_ptr<char[]> buffer{new char[Chunk::kCapacity]};
+};
+
+// Copy everything from `in` to `out` through their stream buffers. Between two
+// rings the chunks themselves are handed on, so nothing is copied at all.
+bool copy_stream(std::istream& in, std::ostream& out);
+
+// The OS handle `out` writes to, after flushing what it has buffered, so a
+// built-in can have the kernel move a whole file there (sendfile, splice).
+// That is a HandleBuf's handle, or the shell's own stdout for std::cout
+// when it is not redirected; kNoHandle for a ring or a std::filebuf.
+os_handle stream_output_handle(std::ostream& out);
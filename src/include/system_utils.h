@@ -6,10 +6,16 @@
 #endif
 
 #include <iostream>
-#include <windows.h>
 #include <vector>
 #include <string>
 #include <unordered_set>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/sysinfo.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#endif
 
 // Danh sách các lệnh hệ thống hỗ trợ
 static const std::unordered_set<std::string> supportedSystemCommands = {
@@ -19,6 +25,7 @@ static const std::unordered_set<std::string> supportedSystemCommands = {
     "diskinfo"
 };
 
+#ifdef _WIN32
 // --- worktime ---
 inline void showWorkTime(const std::vector<std::string>& args)
 {
@@ -87,6 +94,65 @@ inline void showDiskInfo(const std::vector<std::string>& args)
         std::cerr << "Failed to get disk information: " << GetLastError() << std::endl;
     }
 }
+#else
+// --- worktime ---
+inline void showWorkTime(const std::vector<std::string>& args)
+{
+    struct sysinfo info;
+    sysinfo(&info);
+    long seconds = info.uptime;
+    long minutes = (seconds / 60) % 60;
+    long hours = (seconds / 3600) % 24;
+    long days = seconds / 86400;
+
+    std::cout << "System uptime: "
+              << days << " days, "
+              << hours << " hours, "
+              << minutes << " minutes, "
+              << seconds << " seconds"
+              << std::endl;
+}
+
+// --- cpuinfo ---
+inline void showCPUInfo(const std::vector<std::string>& args)
+{
+    std::cout << "CPU Information:" << std::endl;
+    std::cout << "Number of processors: " << sysconf(_SC_NPROCESSORS_ONLN) << std::endl;
+}
+
+// --- meminfo ---
+inline void showMemoryInfo(const std::vector<std::string>& args)
+{
+    struct sysinfo info;
+    sysinfo(&info);
+    unsigned long long unit = info.mem_unit;
+
+    std::cout << "Memory Information:" << std::endl;
+    std::cout << "Total physical memory: " << info.totalram * unit / (1024 * 1024) << " MB" << std::endl;
+    std::cout << "Available physical memory: " << info.freeram * unit / (1024 * 1024) << " MB" << std::endl;
+    std::cout << "Total swap: " << info.totalswap * unit / (1024 * 1024) << " MB" << std::endl;
+    std::cout << "Available swap: " << info.freeswap * unit / (1024 * 1024) << " MB" << std::endl;
+}
+
+// --- diskinfo ---
+inline void showDiskInfo(const std::vector<std::string>& args)
+{
+    std::string mount = args.size() > 1 ? args[1] : "/";
+
+    std::cout << "Checking disk information for " << mount << std::endl;
+
+    struct statvfs vfs;
+    if (statvfs(mount.c_str(), &vfs) == 0) {
+        unsigned long long total = (unsigned long long)vfs.f_blocks * vfs.f_frsize;
+        unsigned long long avail = (unsigned long long)vfs.f_bavail * vfs.f_frsize;
+        std::cout << "Disk Information for " << mount << ":" << std::endl;
+        std::cout << "Total space: " << total / (1024 * 1024 * 1024) << " GB" << std::endl;
+        std::cout << "Free space: " << avail / (1024 * 1024 * 1024) << " GB" << std::endl;
+    } else {
+        perror("diskinfo");
+    }
+}
+#endif
 
 
 #endif // SYSTEM_UTILS_H
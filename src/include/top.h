@@ -0,0 +1,23 @@
+#pragma once
+
+// `top [-d seconds] [-n frames] [-j]`: the busiest processes, refreshed in
+// place until `q`.
+//
+// CPU% is what each process used since the previous frame: the last frame's
+// CPU ticks are kept in a map by pid, so a frame costs one snapshot and one
+// lookup per process. The screen is redrawn by diffing each row against
+// what is already on it and writing only the cells that changed, so the
+// output per frame depends on the screen size and the churn, not on the
+// process count. Keys: c/m/p sort by CPU, memory or pid; j shows only the
+// shell's own jobs; q (or Ctrl-C) quits.
+//
+// When stdout is not a terminal every frame is printed in full, one after
+// the other, as `top -b` does.
+struct TopOptions {
+    double interval = 2.0;          // seconds between frames
+    int frames = 0;                 // 0: until `q`
+    bool jobsOnly = false;          // start with only managed processes shown
+};
+
+// Returns the exit status for the built-in
+int run_top(const TopOptions& options);
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// `watch`: records how a job's processes use the machine over time.
+//
+// One sampler thread serves every watch, waking only when the next one is
+// due. Each watched process keeps its /proc/<pid>/stat and /proc/<pid>/io
+// open for as long as it lives (a process handle on Windows), so a sample
+// is two pread()s and a parse: no path building, no open/close, no
+// allocation. Records are buffered and appended to the watch's file once a
+// second, so dozens of watches at 100 ms cost a few hundred small reads a
+// second and one write per watch. A watch ends by itself when the last of
+// its processes exits.
+//
+// The file is a WatchFileHeader followed by WatchRecords, all in the
+// machine's byte order. Appending to an existing file adds to it.
+struct WatchFileHeader {
+    char magic[4];                  // "TSW1"
+    uint32_t recordSize;            // sizeof(WatchRecord)
+    uint32_t ticksPerSecond;        // unit of cpu_ticks
+    uint32_t intervalUs;            // what the watch that created the file asked for
+};
+
+struct WatchRecord {
+    int64_t when_us;                // system_clock, microseconds since the epoch
+    uint32_t pid;
+    uint32_t threads;               // 0 where unknown (Windows)
+    uint64_t cpu_ticks;             // user + system time so far
+    uint64_t rss_kb;
+    uint64_t read_chars;            // bytes read through any read call
+    uint64_t write_chars;
+    uint64_t read_bytes;            // bytes fetched from storage
+    uint64_t write_bytes;
+};
+
+// Returns the exit status for the built-in:
+//   watch <pid|%job> [--interval T] --out FILE   start sampling (T: 100ms, 2s...)
+//   watch                                         list the running watches
+//   watch --stop <id|all>                         end watches early
+//   watch --summary FILE                          min, percentiles and max per process
+int run_watch(const std::vector<std::string>& args);
@@ -1,21 +1,48 @@
 #include <iostream>
 #include <string>
-#include <windows.h> 
 #include <vector> // Added for std::vector in animateFirework
 #include <thread>
 #include <chrono> // Required for std::this_thread::sleep_for
 #include <cstdlib> // Required for rand() and srand()
 #include <ctime>   // Required for time() to seed srand()
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h> 
+#include <io.h>
 
 #ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
 #define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
 #endif
+#else
+#include <signal.h>
+#include <unistd.h>
+
+// Console attribute bits as in wincon.h, rendered through ANSI escapes below
+typedef unsigned short WORD;
+enum : WORD {
+    FOREGROUND_BLUE = 0x1,
+    FOREGROUND_GREEN = 0x2,
+    FOREGROUND_RED = 0x4,
+    FOREGROUND_INTENSITY = 0x8
+};
+
+static std::string ansi_color(WORD color) {
+    int code = 30 + ((color & FOREGROUND_RED) ? 1 : 0)
+                  + ((color & FOREGROUND_GREEN) ? 2 : 0)
+                  + ((color & FOREGROUND_BLUE) ? 4 : 0);
+    return std::string("\033[") + ((color & FOREGROUND_INTENSITY) ? "1;" : "") + std::to_string(code) + "m";
+}
+#endif
 
 #include "include/parser.h"
 #include "include/execute.h"
 #include "include/process_manager.h"
+#include "include/job_control.h"
+#include "include/event_log.h"
 #include "include/animations.h" // Include for animateFirework definition
 #include "include/history.h" // Added for command history
+#include "include/script.h"
 
 // --- Command History Storage ---
 static std::vector<std::string> command_history;
@@ -37,6 +64,7 @@ void clear_all_command_history() {
 }
 // --- End Command History ---
 
+#ifdef _WIN32
 void print_colored(const std::string& text, WORD color) {
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
     SetConsoleTextAttribute(hConsole, color);
@@ -69,6 +97,29 @@ void blinking_title(const std::string& title, int blink_times = 6, int delay_ms
     print_colored(title, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY);
     std::cout << std::endl;
 }
+#else
+void print_colored(const std::string& text, WORD color) {
+    std::cout << ansi_color(color) << text << "\033[0m";
+}
+
+void blinking_title(const std::string& title, int blink_times = 6, int delay_ms = 300) {
+    for (int i = 0; i < blink_times; ++i) {
+        // Quay về đầu dòng và in lại tại cột 12
+        std::cout << "\r" << std::string(12, ' ');
+        if (i % 2 == 0) {
+            print_colored(title, (WORD)(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY)); // Vàng
+        } else {
+            std::cout << "          "; // In khoảng trắng để "ẩn" chữ
+        }
+        std::cout << std::flush;
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    }
+
+    std::cout << "\r" << std::string(12, ' ');
+    print_colored(title, (WORD)(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY));
+    std::cout << std::endl;
+}
+#endif
 
 void animated_print(const std::string& line, WORD color, int delay_ms = 30) {
     for (char c : line) {
@@ -80,15 +131,24 @@ void animated_print(const std::string& line, WORD color, int delay_ms = 30) {
 
 
 void typewriter_effect(const std::string& message, WORD color = 7, int delay_ms = 30) {
+#ifdef _WIN32
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
     SetConsoleTextAttribute(hConsole, color);
+#else
+    std::cout << ansi_color(color);
+#endif
     for (char c : message) {
         std::cout << c << std::flush;
         std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
     }
+#ifdef _WIN32
     SetConsoleTextAttribute(hConsole, 7); // reset color
+#else
+    std::cout << "\033[0m";
+#endif
 }
 
+#ifdef _WIN32
 HANDLE g_currentProcess = NULL;
 static DWORD g_originalConsoleMode = 0;
 
@@ -112,19 +172,38 @@ BOOL WINAPI ConsoleCtrlHandler(DWORD dwCtrlType) {
     // Nếu không phải tín hiệu liên quan đến Ctrl+C hoặc không có tiến trình foreground
     return FALSE; // Trả về FALSE để shell không bị thoát
 }
+#else
+pid_t g_currentProcess = 0;
+
+void ConsoleCtrlHandler(int) {
+    // The terminal already delivered SIGINT to the foreground child; the shell
+    // only has to survive it. Only async-signal-safe calls are allowed here.
+    static const char msg[] = "\n[Shell] Foreground process terminated by Ctrl-C\n";
+    static const char prompt[] = "\n\033[33mmyShell> \033[0m";
+    if (g_currentProcess) {
+        (void)!write(STDOUT_FILENO, msg, sizeof(msg) - 1);
+    } else {
+        (void)!write(STDOUT_FILENO, prompt, sizeof(prompt) - 1);
+    }
+}
+#endif
 
 void printPrompt() {
     std::cout << "\033[33mmyShell> \033[0m"; // 33 = yellow, 0 = res
 }
 
 void printWelcomeMessage() {
+#ifdef _WIN32
     DWORD pid = GetCurrentProcessId();
+#else
+    pid_t pid = getpid();
+#endif
     print_colored("========================================\n", FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN); // Yellow
     blinking_title("Tiny Shell");
     print_colored("========================================\n", FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN);
 
     animated_print("Welcome to Tiny Shell!", FOREGROUND_GREEN | FOREGROUND_INTENSITY);
-    animated_print("This is a simple shell to interact with the Windows OS.", FOREGROUND_BLUE | FOREGROUND_INTENSITY);
+    animated_print("This is a simple shell to interact with the operating system.", FOREGROUND_BLUE | FOREGROUND_INTENSITY);
     
     std::string pid_msg = "PID of Tiny Shell: " + std::to_string(pid);
     animated_print(pid_msg, FOREGROUND_RED | FOREGROUND_INTENSITY);
@@ -135,7 +214,11 @@ void printWelcomeMessage() {
 }
 
 void printExitMessage() {
+#ifdef _WIN32
     system("cls");
+#else
+    std::cout << "\033[2J\033[H";
+#endif
 
     typewriter_effect("========================================\n", FOREGROUND_RED | FOREGROUND_INTENSITY);
     typewriter_effect("  Thank you for using ", FOREGROUND_GREEN | FOREGROUND_INTENSITY);
@@ -230,11 +313,88 @@ void animateFirework() {
     clearScreen();
 }
 
+// --- Non-interactive modes ---
+
+// The `exit [status]` command when it makes up the whole line, else nullptr
+static const Command* exitCommand(const CommandList& list) {
+    if (list.items.size() != 1 || list.items[0].group) return nullptr;
+    const Pipeline& pl = list.items[0].pipeline;
+    if (pl.stages.size() != 1 || pl.stages[0].argv.empty() || pl.stages[0].argv[0] != "exit") return nullptr;
+    return &pl.stages[0];
+}
+
+// `exit`'s status: its argument, else that of the last command
+static int exitStatus(const Command& exit) {
+    return exit.argv.size() > 1 ? std::atoi(exit.argv[1].c_str()) : last_status();
+}
+
+// Run every line of `in` with no prompt; returns the last command's status
+static int runLines(std::istream& in) {
+    std::string line;
+    Arena lineArena;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        lineArena.reset();
+        CommandList list;
+        if (!parseCommandList(line, lineArena, list)) {
+            set_last_status(2);
+            continue;
+        }
+        if (const Command* exit = exitCommand(list)) return exitStatus(*exit);
+        if (!list.items.empty()) executeList(list);
+    }
+    return last_status();
+}
+
+static bool stdinIsTerminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdin)) != 0;
+#else
+    return isatty(STDIN_FILENO) != 0;
+#endif
+}
+
+static int usage() {
+    std::cerr << "Usage: myShell [-i] [-c commands | script]\n";
+    return 2;
+}
+
 
-int main() {
+int main(int argc, char* argv[]) {
     // Seed random number generator
     srand(time(NULL));
 
+#ifndef _WIN32
+    // A pipeline stage thread writing to a closed pipe gets EPIPE instead
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    // `-c`, a script file, or commands piped in run straight away: no
+    // banner, console set-up or monitor thread. `-i` forces the prompt.
+    int arg = 1;
+    bool interactive = stdinIsTerminal();
+    if (arg < argc && std::string(argv[arg]) == "-i") {
+        interactive = true;
+        ++arg;
+    }
+    if (arg < argc) {
+        std::string mode = argv[arg];
+        if (mode == "-c") {
+            if (arg + 1 >= argc) return usage();
+            std::istringstream commands(argv[arg + 1]);
+            return runLines(commands);
+        }
+        if (mode[0] == '-') return usage();
+        int status = run_script(mode);
+        if (status < 0) {
+            std::cerr << "myShell: cannot read " << mode << "\n";
+            return 127;
+        }
+        return status;
+    }
+    if (!interactive) return runLines(std::cin);
+
+#ifdef _WIN32
     // Bật chế độ xử lý ANSI escape sequences
     HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
     DWORD dwMode = 0;
@@ -247,6 +407,15 @@ int main() {
     
     // Install Ctrl-C/Break handler
     SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+#else
+    // Install Ctrl-C handler; children get the default action back at exec
+    struct sigaction sa = {};
+    sa.sa_handler = ConsoleCtrlHandler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+#endif
+    job_control_init();
 
     // Print the welcome message first
     printWelcomeMessage();
@@ -257,19 +426,28 @@ int main() {
     
 
     std::string line;
+    Arena lineArena;
+    int status = 0;
 
     while (true) {
+        report_finished_jobs();
+        report_monitor_events();
         printPrompt();
 
         // Read input line
         if (!std::getline(std::cin, line)) {
             std::cout << "\n";
-            if (std::cin.eof()) break;
+            if (std::cin.eof()) {
+                status = last_status();
+                break;
+            }
             // Restore cin state
             std::cin.clear();
+#ifdef _WIN32
             // Clear and restore console
             FlushConsoleInputBuffer(hStdin);
             SetConsoleMode(hStdin, g_originalConsoleMode);
+#endif
             continue;
         }
 
@@ -277,8 +455,15 @@ int main() {
 
         if (line.empty()) continue;
 
-        Command cmd = parseCommand(line);
-        if (!cmd.argv.empty() && cmd.argv[0] == "exit") {
+        // Tokenized as views of `line`; only the finished pipelines are copied
+        lineArena.reset();
+        CommandList list;
+        if (!parseCommandList(line, lineArena, list)) {
+            set_last_status(2);
+            continue;
+        }
+        if (const Command* exit = exitCommand(list)) {
+            status = exitStatus(*exit);
             if (monitor_running) { // Check if monitor_running is accessible
                 monitor_running = false;
             }
@@ -292,16 +477,18 @@ int main() {
 
         // Execute command
         // Set current process handle before launching, so handler knows
-        g_currentProcess = NULL; // reset
-        executeCommand(cmd);
+        g_currentProcess = 0; // reset
+        executeList(list);
 
         // If foreground, executeCommand should set g_currentProcess to child handle
         // Wait finishes, so clear it
-        g_currentProcess = NULL;
+        g_currentProcess = 0;
 
+#ifdef _WIN32
         // After execution, flush and restore console
         FlushConsoleInputBuffer(hStdin);
         SetConsoleMode(hStdin, g_originalConsoleMode);
+#endif
     }
 
     if (monitor_running) {
@@ -311,5 +498,5 @@ int main() {
         monitorThread.join();
     }
 
-    return 0;
+    return status;
 }
@@ -1,5 +1,15 @@
 #include "../include/builtin.h"
 #include "../include/process_manager.h"
+#include "../include/job_table.h"
+#include "../include/job_control.h"
+#include "../include/proc_snapshot.h"
+#include "../include/top.h"
+#include "../include/cat.h"
+#include "../include/dir_list.h"
+#include "../include/find.h"
+#include "../include/proc_tree.h"
+#include "../include/event_log.h"
+#include "../include/watch.h"
 #include "../include/execute.h"
 #include "../include/animations.h"
 #include "../include/snake_game.h"
@@ -7,15 +17,13 @@
 #include "../include/history.h"
 #include "../include/calculator.h"
 #include "../include/converter.h"
-#include "../include/location_service.h"
-#include "../include/weather_service.h"
-#include "../include/minesweeper_game.h"
-#include "../include/hangman_game.h"
-#include "../include/cat_animation.h"
+#include "../include/stream_pipe.h"
+#include "../include/path_cache.h"
+#include "../include/perfect_hash.h"
+#include "../include/script.h"
+#include "../include/parallel.h"
 #include <iostream>
 #include <cstdlib>
-#include <direct.h>
-#include <windows.h>
 #include <vector>
 #include <string>
 #include <thread>
@@ -24,6 +32,17 @@
 #include <sstream> // For string streams (diskinfo)
 #include <numeric> // For std::accumulate if joining args
 #include <regex>
+#include <ctime>
+#include <cstring>
+
+#ifdef _WIN32
+#include "../include/location_service.h"
+#include "../include/weather_service.h"
+#include "../include/minesweeper_game.h"
+#include "../include/hangman_game.h"
+#include "../include/cat_animation.h"
+#include <direct.h>
+#include <windows.h>
 #define WIN64_LEAN_AND_MEAN
 #define _WIN64_WINNT 0x0A00
 // For WMI (cpuinfo)
@@ -31,7 +50,20 @@
 #include <Wbemidl.h>
 
 #pragma comment(lib, "wbemuuid.lib")
-
+#else
+#include <unistd.h>
+#include <climits>
+#include <cstdio>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#define _getcwd getcwd
+#define _chdir chdir
+#define _rmdir rmdir
+#define _mkdir(dir) mkdir((dir), 0755)
+#define MAX_PATH PATH_MAX
+#endif
+
+#ifdef _WIN32
 void colored(const std::string& text, WORD color) {
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
     SetConsoleTextAttribute(hConsole, color);
@@ -64,35 +96,64 @@ void blink(const std::string& title, int blink_times = 6, int delay_ms = 300) {
     colored(title, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY);
     std::cout << std::endl;
 }
+#else
+void blink(const std::string& title, int blink_times = 6, int delay_ms = 300) {
+    // Same effect with ANSI escapes: rewrite the current line in place
+    for (int i = 0; i < blink_times; ++i) {
+        std::cout << "\r" << std::string(12, ' ');
+        if (i % 2 == 0) {
+            std::cout << "\033[1;33m" << title << "\033[0m"; // Vàng
+        } else {
+            std::cout << std::string(title.size(), ' ');
+        }
+        std::cout << std::flush;
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    }
+
+    std::cout << "\r" << std::string(12, ' ') << "\033[1;33m" << title << "\033[0m" << std::endl;
+}
+#endif
 
 void builtin_fireworks(const std::vector<std::string>& args) {
     animateFirework(); 
 }
 
+#ifdef _WIN32
 void builtin_snake(const std::vector<std::string>& args) {
     playSnakeGame();
 }
+#else
+void builtin_snake(const std::vector<std::string>& args) {
+    std::cerr << "snake: not available on this platform\n";
+    set_builtin_status(1);
+}
+#endif
 
-void builtin_history(const std::vector<std::string>& args) {
+static void builtin_history(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
     const auto& history = get_command_history();
     if (history.empty()) {
-        std::cout << "No commands in history." << std::endl;
+        out << "No commands in history.\n";
     } else {
         for (size_t i = 0; i < history.size(); ++i) {
-            std::cout << std::setw(4) << i + 1 << "  " << history[i] << std::endl;
+            out << std::setw(4) << i + 1 << "  " << history[i] << "\n";
         }
     }
 }
 
+void builtin_history(const std::vector<std::string>& args) {
+    builtin_history(args, std::cin, std::cout);
+}
+
 void builtin_clear_history(const std::vector<std::string>& args) {
     clear_all_command_history();
     // Message is printed by clear_all_command_history() in main.cpp
 }
 
-void builtin_calculate(const std::vector<std::string>& args) {
+static void builtin_calculate(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
     if (args.size() < 2) {
         std::cerr << "Usage: calculate <expression>" << std::endl;
         std::cerr << "Example: calculate \"3 + 4 * (2 - 1)\"" << std::endl;
+        set_builtin_status(1);
         return;
     }
 
@@ -115,24 +176,31 @@ void builtin_calculate(const std::vector<std::string>& args) {
 
     if (expression_str.empty()) {
          std::cerr << "Expression cannot be empty." << std::endl;
+         set_builtin_status(1);
          return;
     }
 
     try {
         double result = TinyCalculator::calculate_expression(expression_str);
-        std::cout << std::fixed << std::setprecision(6); // Adjust precision as needed
-        std::cout << expression_str << " = " << result << std::endl;
+        out << std::fixed << std::setprecision(6); // Adjust precision as needed
+        out << expression_str << " = " << result << "\n";
     } catch (const std::runtime_error& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        set_builtin_status(1);
     }
 }
 
-void builtin_convert(const std::vector<std::string>& args) {
+void builtin_calculate(const std::vector<std::string>& args) {
+    builtin_calculate(args, std::cin, std::cout);
+}
+
+static void builtin_convert(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
     if (args.size() != 6 || args[2] != "from" || args[4] != "to") {
         std::cerr << "Usage: convert <value> from <base_from> to <base_to>" << std::endl;
         std::cerr << "Example: convert 101 from 2 to 10" << std::endl;
         std::cerr << "Example: convert FF from 16 to 10" << std::endl;
         std::cerr << "Note: Bases must be between 2 and 36." << std::endl;
+        set_builtin_status(1);
         return;
     }
 
@@ -152,18 +220,25 @@ void builtin_convert(const std::vector<std::string>& args) {
     } catch (const std::exception& e) {
         std::cerr << "Error: Invalid base number provided. " << e.what() << std::endl;
         std::cerr << "Bases must be integers between 2 and 36." << std::endl;
+        set_builtin_status(1);
         return;
     }
 
     try {
         std::string result = BaseConverter::convert_base(value_str, base_from, base_to);
-        std::cout << value_str << " (base " << base_from << ") = " 
-                  << result << " (base " << base_to << ")" << std::endl;
+        out << value_str << " (base " << base_from << ") = " 
+                  << result << " (base " << base_to << ")" << "\n";
     } catch (const std::exception& e) { // Catches std::invalid_argument or std::out_of_range
         std::cerr << "Conversion Error: " << e.what() << std::endl;
+        set_builtin_status(1);
     }
 }
 
+void builtin_convert(const std::vector<std::string>& args) {
+    builtin_convert(args, std::cin, std::cout);
+}
+
+#ifdef _WIN32
 void builtin_location(const std::vector<std::string>& args) {
     // Potentially add argument parsing here if you want `location <city>` in the future
     // For now, it just gets the current (placeholder) location.
@@ -268,68 +343,33 @@ void builtin_nyancat(const std::vector<std::string>& args) {
     // play_nyancat_animation handles its own screen clearing and messages
     std::cout << "Nyan Cat animation finished." << std::endl; 
 }
+#else
+void builtin_location(const std::vector<std::string>& args) {
+    std::cerr << "location: not available on this platform\n";
+    set_builtin_status(1);
+}
 
-bool is_builtin(const std::string& cmd) {
-    return cmd == "cd" || cmd == "exit" || cmd == "pwd" || cmd == "echo" ||
-           cmd == "help" || cmd == "list" || cmd == "kill" || cmd == "stop" ||
-           cmd == "resume" || cmd == "date" || cmd == "dir" || cmd == "cls" ||
-           cmd == "path" || cmd == "addpath" || cmd == "mlist" || cmd == "pinfo" || 
-           cmd == "monitor" || cmd == "stopmonitor" || cmd == "monitor_silent" ||
-           cmd == "mkdir" || cmd == "rmdir" || cmd == "touch" || cmd == "rm" || cmd == "cat" || cmd == "REM" ||
-           cmd == "fireworks" || cmd == "snake" ||
-           cmd == "worktime" || cmd == "cpuinfo" || cmd == "meminfo" || cmd == "diskinfo" ||
-           cmd == "history" || cmd == "clear_history" ||
-           cmd == "calculate" || cmd == "convert" || 
-           cmd == "location" || cmd == "weather" ||
-           cmd == "mines" || cmd == "hangman" || cmd == "nyancat";
+void builtin_weather(const std::vector<std::string>& args) {
+    std::cerr << "weather: not available on this platform\n";
+    set_builtin_status(1);
 }
 
-void run_builtin(const std::vector<std::string>& args) {
-    if (args.empty()) return;
-    const std::string& cmd = args[0];
-    if (cmd == "cd") builtin_cd(args);
-    else if (cmd == "exit") builtin_exit(args);
-    else if (cmd == "pwd") builtin_pwd(args);
-    else if (cmd == "echo") builtin_echo(args);
-    else if (cmd == "help") builtin_help(args);
-    else if (cmd == "list") builtin_list(args);
-    else if (cmd == "kill") builtin_kill(args);
-    else if (cmd == "stop") builtin_stop(args);
-    else if (cmd == "resume") builtin_resume(args);
-    else if (cmd == "date") builtin_date(args);
-    else if (cmd == "dir") builtin_dir(args);
-    else if (cmd == "path") builtin_path(args);
-    else if (cmd == "addpath") builtin_addpath(args);
-    else if (cmd == "mlist") builtin_mlist(args);
-    else if (cmd == "pinfo") builtin_pinfo(args);
-    else if (cmd == "monitor") builtin_monitor(args);
-    else if (cmd == "stopmonitor") builtin_stopmonitor(args);
-    else if (cmd == "monitor_silent") builtin_monitor_silent(args);
-    else if (cmd == "mkdir") builtin_mkdir(args); 
-    else if (cmd == "rmdir") builtin_rmdir(args); 
-    else if (cmd == "touch") builtin_touch(args); 
-    else if (cmd == "rm") builtin_rm(args);      
-    else if (cmd == "cat") builtin_cat(args);     
-    else if (cmd == "REM") builtin_rem(args);
-    else if (cmd == "cls") builtin_cls(args); 
-    else if (cmd == "fireworks") builtin_fireworks(args);
-    else if (cmd == "snake") builtin_snake(args);
-    else if (cmd == "worktime") showWorkTime(args);   // Added worktime
-    else if (cmd == "cpuinfo") showCPUInfo(args);    // Added cpuinfo
-    else if (cmd == "meminfo") showMemoryInfo(args);    // Added meminfo
-    else if (cmd == "diskinfo") showDiskInfo(args);  // Added diskinfo
-    else if (cmd == "history") builtin_history(args);         // Added history
-    else if (cmd == "clear_history") builtin_clear_history(args); // Added clear_history
-    else if (cmd == "calculate") builtin_calculate(args); // Added calculate
-    else if (cmd == "convert") builtin_convert(args); // Added convert
-    else if (cmd == "location") builtin_location(args); // Added location
-    else if (cmd == "weather") builtin_weather(args); // Added weather
-    else if (cmd == "mines") builtin_mines(args); // Added Minesweeper
-    else if (cmd == "hangman") builtin_hangman(args); // Added Hangman
-    else if (cmd == "nyancat") builtin_nyancat(args); // Added nyancat
-    else std::cerr << "Unknown command: " << cmd << "\n";
+void builtin_mines(const std::vector<std::string>& args) {
+    std::cerr << "mines: not available on this platform\n";
+    set_builtin_status(1);
+}
+
+void builtin_hangman(const std::vector<std::string>& args) {
+    std::cerr << "hangman: not available on this platform\n";
+    set_builtin_status(1);
 }
 
+void builtin_nyancat(const std::vector<std::string>& args) {
+    std::cerr << "nyancat: not available on this platform\n";
+    set_builtin_status(1);
+}
+#endif
+
 void builtin_cd(const std::vector<std::string>& args) {
     if (args.size() == 1) {
         char cwd[MAX_PATH];
@@ -337,12 +377,14 @@ void builtin_cd(const std::vector<std::string>& args) {
             std::cout << cwd << "\n";
         } else {
             perror("cd");
+            set_builtin_status(1);
         }
         return;
     }
 
     std::string target = args[1];
 
+#ifdef _WIN32
     if (target == "\\") {
         char drive[MAX_PATH];
         if (_getcwd(drive, sizeof(drive))) {
@@ -355,9 +397,11 @@ void builtin_cd(const std::vector<std::string>& args) {
         std::cout << "Note: Changing drives like 'cd D:' has no effect in this shell.\n";
         return;
     }
+#endif
 
     if (_chdir(target.c_str()) != 0) {
         perror("cd");
+        set_builtin_status(1);
     } else {
         char cwd[MAX_PATH];
         if (_getcwd(cwd, sizeof(cwd))) {
@@ -367,7 +411,7 @@ void builtin_cd(const std::vector<std::string>& args) {
 }
 
 void builtin_exit(const std::vector<std::string>& args) {
-    std::exit(0);
+    std::exit(args.size() > 1 ? std::atoi(args[1].c_str()) : last_status());
 }
 
 void builtin_pwd(const std::vector<std::string>& args) {
@@ -376,25 +420,30 @@ void builtin_pwd(const std::vector<std::string>& args) {
         std::cout << cwd << std::endl;
     } else {
         perror("pwd");
+        set_builtin_status(1);
     }
 }
 
-void builtin_echo(const std::vector<std::string>& args) {
+static void builtin_echo(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
     // Bắt đầu từ i=1 để bỏ qua "echo"
     for (size_t i = 1; i < args.size(); ++i) {
 
         // Nếu muốn bỏ dấu "": 
-        std::string out = args[i];
-        if (!out.empty() && out.front() == '"' && out.back() == '"') {
-            out = out.substr(1, out.size() - 2);
+        std::string text = args[i];
+        if (!text.empty() && text.front() == '"' && text.back() == '"') {
+            text = text.substr(1, text.size() - 2);
         }
 
-        std::cout << out;
+        out << text;
         if (i + 1 < args.size()) {
-            std::cout << " ";
+            out << " ";
         }
     }
-    std::cout << std::endl;
+    out << "\n";
+}
+
+void builtin_echo(const std::vector<std::string>& args) {
+    builtin_echo(args, std::cin, std::cout);
 }
 
 void builtin_help(const std::vector<std::string>& args) {
@@ -402,116 +451,276 @@ void builtin_help(const std::vector<std::string>& args) {
     blink("TINY-SHELL INSTRUCTIONS:");
     std::cout << "\n";
 
-    std::cout << "=== File and Directory Commands ===\n";
-    std::cout << "cd <dir>          : Change the current directory to <dir>.\n";
-    std::cout << "pwd               : Print the current working directory.\n";
-    std::cout << "dir               : List the contents of the current directory.\n";
-    std::cout << "mkdir <dir>       : Create a new directory.\n";
-    std::cout << "rmdir <dir>       : Remove an empty directory.\n";
-    std::cout << "touch <file>      : Create or update a file.\n";
-    std::cout << "rm <file>         : Remove a file.\n";
-    std::cout << "cat <file>        : Display the contents of a file.\n";
-    std::cout << "path              : Display the current PATH environment variable.\n";
-    std::cout << "addpath <dir>     : Add <dir> to the PATH environment variable.\n\n";
-
-    std::cout << "=== Process Management Commands ===\n";
-    std::cout << "list              : List all processes currently running on the system.\n";
-    std::cout << "mlist             : List all processes managed by this shell.\n";
-    std::cout << "pinfo <pid>       : Display detailed information about the process with PID <pid>.\n";
-    std::cout << "kill <pid>        : Terminate the process with PID <pid>.\n";
-    std::cout << "stop <pid>        : Suspend the process with PID <pid>.\n";
-    std::cout << "resume <pid>      : Resume the process with PID <pid>.\n\n";
-
-    std::cout << "=== Monitoring Commands ===\n";
-    std::cout << "monitor           : Start monitoring process creation and deletion (normal mode).\n";
-    std::cout << "monitor_silent    : Start monitoring process creation and deletion (silent mode).\n";
-    std::cout << "stopmonitor       : Stop the process monitoring.\n\n";
-
-    std::cout << "=== Shell Utility Commands ===\n";
-    std::cout << "cls               : Clear the console screen.\n"; 
-    std::cout << "echo <text>       : Print <text> to the console.\n";
-    std::cout << "date              : Display the current date and time.\n";
-    std::cout << "exit              : Exit the shell.\n";
-    std::cout << "help              : Display this help message.\n";
-    std::cout << "nyancat           : Display a jumping cat animation.\n";
-    std::cout << "fireworks         : Display an ASCII fireworks animation.\n";
-    std::cout << "snake             : Play the classic Snake game.\n";
-    std::cout << "mines             : Play a game of Minesweeper.\n";
-    std::cout << "hangman           : Play a game of Hangman (guess the word).\n";
-    std::cout << "\n";
-
-    std::cout << "=== System Information Commands ===\n";
-    std::cout << "worktime          : Display system uptime.\n";
-    std::cout << "cpuinfo           : Display CPU information.\n";
-    std::cout << "meminfo           : Display memory usage information.\n";
-    std::cout << "diskinfo          : Display disk usage information for all drives.\n\n";
-
-    std::cout << "=== Command History ===\n";
-    std::cout << "history           : Show the command history.\n";
-    std::cout << "clear_history     : Clear the command history.\n\n";
-
-    std::cout << "=== Calculator ===\n";
-    std::cout << "calculate <expr>  : Evaluate a mathematical expression. Use quotes for expressions with spaces.\n";
-    std::cout << "  Operators:      +, -, *, /, % (modulo), ^ (exponentiation), ! (factorial)\n";
-    std::cout << "  Functions:      sqrt(x), sin(x), cos(x), tan(x), cot(x)\n";
-    std::cout << "                  ln(x), log10(x), log2(x), log8(x), log16(x)\n";
-    std::cout << "  Constants:      pi, e\n";
-    std::cout << "  Unary +/-:      Supported, e.g., -5, -(2+3)\n";
-    std::cout << "  Example:        calculate \"sin(pi/2) + (5! - 100)^2 % 9 - -sqrt(16)\"\n";
-    std::cout << "convert <val> from <b1> to <b2>: Convert number <val> from base <b1> to base <b2>.\n";
-    std::cout << "  Example:        convert 1A from 16 to 10\n";
-    std::cout << "                  convert 255 from 10 to 16\n";
-    std::cout << "                  convert 1011 from 2 to 10\n";
-    std::cout << "  Bases <b1>, <b2> must be integers between 2 and 36.\n";
-    std::cout << "\n";
-
-    std::cout << "=== General Purpose Utilities ===\n";
-    std::cout << "location           : Display the current geographical location (placeholder).\n";
-    std::cout << "weather <city_name>: Displays current weather. \n";
+    size_t count = 0;
+    const BuiltinInfo* table = builtin_table(count);
+    const char* section = nullptr;
+    std::string inProcess;
+    for (size_t i = 0; i < count; ++i) {
+        const BuiltinInfo& b = table[i];
+        if (b.stream) inProcess += std::string(inProcess.empty() ? "" : ", ") + b.name;
+        if (b.flags & BUILTIN_HIDDEN) continue;
+
+        if (!section || std::strcmp(section, b.section) != 0) {
+            if (section) std::cout << "\n";
+            section = b.section;
+            std::cout << "=== " << section << " ===\n";
+        }
+        std::cout << std::left << std::setw(18) << b.usage << std::right << ": " << b.help << "\n";
+        if (b.details) std::cout << b.details;
+    }
     std::cout << "\n";
 
     std::cout << "=== Notes ===\n";
-    std::cout << "- Commands like 'kill', 'stop', and 'resume' require the PID of the target process.\n";
+    std::cout << "- 'kill', 'stop' and 'resume' take a PID, a job id (%1), a process group (-g PGID), a PID and\n"
+                 "  all its descendants (--tree PID) or a name pattern (e.g. sleep*); a pattern never matches\n"
+                 "  the shell, its parents or its own process group.\n";
+    std::cout << "- End a command with '&' to run it in the background; 'jobs', 'fg', 'bg', 'wait' and 'pinfo' take job ids such as %1.\n";
     std::cout << "- Use 'list' to view all system processes and 'mlist' to view processes managed by this shell.\n";
     std::cout << "- The 'monitor_silent' command suppresses output while monitoring processes.\n";
+    std::cout << "- The monitor prints what it saw just before the next prompt; 'events' lists or follows it.\n";
     std::cout << "- Use 'addpath' to temporarily modify the PATH variable for this shell session.\n";
+    std::cout << "- Connect commands with '|' (e.g. 'cat log.txt | sort | uniq'); all stages run at the same time.\n";
+    std::cout << "- " << inProcess << " run inside the shell when used in a pipeline.\n";
+    std::cout << "- Chain commands with ';', '&&' (run if the last one succeeded) and '||' (run if it failed);\n"
+                 "  group them with '{ ...; }', e.g. 'cd build && { make; echo done; } || echo failed'.\n"
+                 "  A group runs in the shell itself: it cannot be piped, redirected or put in the background.\n";
 
     std::cout << "\n--- Process Management ---\n";
 }
 
 void builtin_list(const std::vector<std::string>& args) {
-    list_processes();
+    ListOptions options;
+    if (!parse_list_options(args, options)) {
+        set_builtin_status(1);
+        return;
+    }
+    list_processes(options);
+}
+
+void builtin_top(const std::vector<std::string>& args) {
+    TopOptions options;
+    for (size_t i = 1; i < args.size(); ++i) {
+        char* end = nullptr;
+        if (args[i] == "-j") {
+            options.jobsOnly = true;
+        } else if (args[i] == "-d" && i + 1 < args.size()) {
+            options.interval = std::strtod(args[++i].c_str(), &end);
+            if (*end != '\0' || options.interval < 0.1) end = nullptr;
+        } else if (args[i] == "-n" && i + 1 < args.size()) {
+            options.frames = (int)std::strtol(args[++i].c_str(), &end, 10);
+            if (*end != '\0' || options.frames < 1) end = nullptr;
+        }
+        if (args[i] != "-j" && !end) {
+            std::cerr << "Usage: top [-d seconds (at least 0.1)] [-n frames] [-j]\n";
+            set_builtin_status(1);
+            return;
+        }
+    }
+    set_builtin_status(run_top(options));
+}
+
+void builtin_ptree(const std::vector<std::string>& args) {
+    // The roots: a pid, every process of a %job, or every live managed process
+    std::vector<ProcessInfo> roots;
+    int job;
+    if (args.size() > 2) {
+        std::cerr << "Usage: ptree [pid|%job]\n";
+        set_builtin_status(1);
+        return;
+    } else if (args.size() == 2 && parse_job_spec(args[1], job)) {
+        roots = job_table().job(job);
+        if (roots.empty()) {
+            std::cerr << "ptree: " << args[1] << ": no such job\n";
+            set_builtin_status(1);
+            return;
+        }
+    } else if (args.size() == 2) {
+        char* end;
+        unsigned long pid = std::strtoul(args[1].c_str(), &end, 10);
+        if (*end != '\0' || args[1].empty()) {
+            std::cerr << "ptree: " << args[1] << ": not a pid or job spec\n";
+            set_builtin_status(1);
+            return;
+        }
+        ProcessInfo root{};
+        root.pid = (proc_id)pid;
+        roots.push_back(root);
+    } else {
+        roots = job_table().snapshot();
+    }
+
+    ProcTree tree(take_proc_snapshot());
+    std::ostringstream out;
+    int shownJob = 0;
+    for (const auto& root : roots) {
+        if (tree.find(root.pid) < 0) {
+            if (args.size() == 2 && root.status != ProcessStatus::Done) {
+                std::cerr << "ptree: no process " << root.pid << "\n";
+                set_builtin_status(1);
+            }
+            continue;
+        }
+        if (root.job_id && root.job_id != shownJob) {
+            out << "[%" << root.job_id << "]\n";
+            shownJob = root.job_id;
+        }
+        tree.print(root.pid, out);
+    }
+    if (args.size() == 1 && out.tellp() == 0) out << "No running jobs; use 'ptree <pid>' for any process.\n";
+    std::cout << out.str();
 }
 
 void builtin_kill(const std::vector<std::string>& args) {
-    if (args.size() < 2) { std::cerr << "kill: missing pid\n"; return; }
-    DWORD pid = std::stoul(args[1]);
-    if (!kill_process(pid)) std::cerr << "kill: failed on pid " << pid << "\n";
+    set_builtin_status(act_on_processes(ProcessAction::Kill, args));
 }
 
 void builtin_stop(const std::vector<std::string>& args) {
-    if (args.size() < 2) { std::cerr << "stop: missing pid\n"; return; }
-    DWORD pid = std::stoul(args[1]);
-    if (!stop_process(pid)) std::cerr << "stop: failed on pid " << pid << "\n";
+    set_builtin_status(act_on_processes(ProcessAction::Stop, args));
 }
 
 void builtin_resume(const std::vector<std::string>& args) {
-    if (args.size() < 2) { std::cerr << "resume: missing pid\n"; return; }
-    DWORD pid = std::stoul(args[1]);
-    if (!resume_process(pid)) std::cerr << "resume: failed on pid " << pid << "\n";
+    set_builtin_status(act_on_processes(ProcessAction::Resume, args));
+}
+
+void builtin_jobs(const std::vector<std::string>& args) {
+    bool showPids = args.size() > 1 && args[1] == "-l";
+    set_builtin_status(print_jobs(showPids));
+}
+
+// `fg`/`bg` take an optional %N; without one they pick the newest job
+static bool job_argument(const std::vector<std::string>& args, int& job) {
+    job = 0;
+    if (args.size() < 2) return true;
+    if (parse_job_spec(args[1], job)) return true;
+    std::cerr << args[0] << ": " << args[1] << ": not a job spec (use %N)\n";
+    set_builtin_status(1);
+    return false;
+}
+
+void builtin_fg(const std::vector<std::string>& args) {
+    int job;
+    if (job_argument(args, job)) set_builtin_status(foreground_job(job));
+}
+
+void builtin_bg(const std::vector<std::string>& args) {
+    int job;
+    if (job_argument(args, job)) set_builtin_status(background_job(job));
+}
+
+void builtin_wait(const std::vector<std::string>& args) {
+    bool any = args.size() > 1 && args[1] == "-n";
+    std::vector<std::string> specs(args.begin() + (any ? 2 : 1), args.end());
+    set_builtin_status(wait_jobs(specs, any));
+}
+
+// CPU time of this thread: what a built-in run by `time` itself costs
+static void thread_cpu(double& user, double& sys) {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, userTime;
+    GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &userTime);
+    user = ((ULONGLONG)userTime.dwHighDateTime << 32 | userTime.dwLowDateTime) / 1e7;
+    sys = ((ULONGLONG)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime) / 1e7;
+#else
+    rusage ru;
+    getrusage(RUSAGE_THREAD, &ru);
+    user = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6;
+    sys = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+#endif
+}
+
+static std::string time_text(double seconds) {
+    int minutes = (int)(seconds / 60);
+    std::ostringstream out;
+    out << minutes << "m" << std::fixed << std::setprecision(3) << seconds - minutes * 60 << "s";
+    return out.str();
+}
+
+void builtin_time(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        std::cerr << "Usage: time <command> [args...]\n";
+        set_builtin_status(1);
+        return;
+    }
+    Command cmd;
+    cmd.argv.assign(args.begin() + 1, args.end());
+
+    ProcessUsage children;
+    double user0, sys0, user1, sys1;
+    collect_foreground_usage(&children);
+    thread_cpu(user0, sys0);
+    auto start = std::chrono::steady_clock::now();
+
+    int status = executeCommand(cmd);
+
+    double real = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    thread_cpu(user1, sys1);
+    collect_foreground_usage(nullptr);
+
+    long maxRss = children.max_rss_kb;
+#ifndef _WIN32
+    if (maxRss == 0) {
+        // Nothing was spawned: the command ran inside the shell
+        rusage self;
+        getrusage(RUSAGE_SELF, &self);
+        maxRss = self.ru_maxrss;
+    }
+#endif
+    std::cerr << "\nreal\t" << time_text(real) << "\n"
+              << "user\t" << time_text(children.user_sec + user1 - user0) << "\n"
+              << "sys\t" << time_text(children.sys_sec + sys1 - sys0) << "\n"
+              << "maxrss\t" << maxRss << " KB\n";
+    set_builtin_status(status);
+}
+
+// A line starting with `run` normally never gets here: executeCommand takes
+// it apart itself so that '&' and redirections reach the limited command.
+// This covers callers that only have the words.
+void builtin_run(const std::vector<std::string>& args) {
+    Command cmd;
+    cmd.argv = args;
+    set_builtin_status(executeCommand(cmd));
+}
+
+static void builtin_parallel(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
+    int failed = run_parallel(args, in, out);
+    set_builtin_status(failed > 255 ? 255 : failed);
+}
+
+void builtin_parallel(const std::vector<std::string>& args) {
+    builtin_parallel(args, std::cin, std::cout);
 }
 
 void builtin_date(const std::vector<std::string>& args) {
+#ifdef _WIN32
     SYSTEMTIME st;
     GetLocalTime(&st);
     std::cout << st.wDay << "/" << st.wMonth << "/" << st.wYear
               << " " << st.wHour << ":" << st.wMinute
               << ":" << st.wSecond << std::endl;
+#else
+    time_t now = time(nullptr);
+    struct tm st;
+    localtime_r(&now, &st);
+    std::cout << st.tm_mday << "/" << st.tm_mon + 1 << "/" << st.tm_year + 1900
+              << " " << st.tm_hour << ":" << st.tm_min
+              << ":" << st.tm_sec << std::endl;
+#endif
+}
+
+static void builtin_dir(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
+    set_builtin_status(run_dir(args, out));
 }
 
 void builtin_dir(const std::vector<std::string>& args) {
-    std::string cmd = "dir";
-    system(cmd.c_str());
+    builtin_dir(args, std::cin, std::cout);
+}
+
+static void builtin_find(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
+    set_builtin_status(run_find(args, out));
+}
+
+void builtin_find(const std::vector<std::string>& args) {
+    builtin_find(args, std::cin, std::cout);
 }
 
 void builtin_path(const std::vector<std::string>& args) {
@@ -520,15 +729,58 @@ void builtin_path(const std::vector<std::string>& args) {
 }
 
 void builtin_addpath(const std::vector<std::string>& args) {
-    if (args.size() < 2) { std::cerr << "addpath: missing dir\n"; return; }
-    std::string p = std::getenv("PATH");
+    if (args.size() < 2) { std::cerr << "addpath: missing dir\n"; set_builtin_status(1); return; }
+    const char* current = std::getenv("PATH");
+    std::string p = current ? current : "";
+#ifdef _WIN32
     p += ";" + args[1];
     _putenv_s("PATH", p.c_str());
+#else
+    p += ":" + args[1];
+    setenv("PATH", p.c_str(), 1);
+#endif
+    path_cache_clear();
+}
+
+// hash            : show remembered command locations and how often each was used
+// hash -r         : forget them all
+// hash -l         : list them as name/path pairs
+// hash <name>...  : look the names up now and remember them
+void builtin_hash(const std::vector<std::string>& args) {
+    if (args.size() == 1) {
+        std::vector<PathCacheEntry> list = path_cache_entries();
+        if (list.empty()) {
+            std::cout << "hash: hash table empty\n";
+            return;
+        }
+        std::cout << "hits    command\n";
+        for (const auto& e : list) {
+            std::cout << std::setw(4) << e.hits << "    " << e.path << "\n";
+        }
+        return;
+    }
+    if (args[1] == "-r") {
+        path_cache_clear();
+        return;
+    }
+    if (args[1] == "-l") {
+        for (const auto& e : path_cache_entries()) {
+            std::cout << std::left << std::setw(16) << e.name << std::right << " " << e.path << "\n";
+        }
+        return;
+    }
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (resolve_command(args[i]).empty()) {
+            std::cerr << "hash: " << args[i] << ": not found\n";
+            set_builtin_status(1);
+        }
+    }
 }
 
 void builtin_mkdir(const std::vector<std::string>& args) {
     if (args.size() < 2) {
         std::cerr << "mkdir: missing directory name\n";
+        set_builtin_status(1);
         return;
     }
 
@@ -537,12 +789,14 @@ void builtin_mkdir(const std::vector<std::string>& args) {
         std::cout << "Directory created: " << dirName << "\n";
     } else {
         perror("mkdir");
+        set_builtin_status(1);
     }
 }
 
 void builtin_rmdir(const std::vector<std::string>& args) {
     if (args.size() < 2) {
         std::cerr << "rmdir: missing directory name\n";
+        set_builtin_status(1);
         return;
     }
 
@@ -551,12 +805,14 @@ void builtin_rmdir(const std::vector<std::string>& args) {
         std::cout << "Directory removed: " << dirName << "\n";
     } else {
         perror("rmdir");
+        set_builtin_status(1);
     }
 }
 
 void builtin_touch(const std::vector<std::string>& args) {
     if (args.size() < 2) {
         std::cerr << "touch: missing file name\n";
+        set_builtin_status(1);
         return;
     }
 
@@ -567,16 +823,19 @@ void builtin_touch(const std::vector<std::string>& args) {
         file.close();
     } else {
         std::cerr << "touch: unable to create file " << fileName << "\n";
+        set_builtin_status(1);
     }
 }
 
 void builtin_rm(const std::vector<std::string>& args) {
     if (args.size() < 2) {
         std::cerr << "rm: missing file name\n";
+        set_builtin_status(1);
         return;
     }
 
     const std::string& fileName = args[1];
+#ifdef _WIN32
     std::wstring wideFileName(fileName.begin(), fileName.end()); 
 
     if (DeleteFileW(wideFileName.c_str())) {
@@ -584,30 +843,30 @@ void builtin_rm(const std::vector<std::string>& args) {
     } else {
         DWORD error = GetLastError();
         std::cerr << "rm: failed to remove file " << fileName << " (Error code: " << error << ")\n";
+        set_builtin_status(1);
     }
-}
-
-void builtin_cat(const std::vector<std::string>& args) {
-    if (args.size() < 2) {
-        std::cerr << "cat: missing file name\n";
-        return;
+#else
+    if (unlink(fileName.c_str()) == 0) {
+        std::cout << "File removed: " << fileName << "\n";
+    } else {
+        perror("rm");
+        set_builtin_status(1);
     }
+#endif
+}
 
-    const std::string& fileName = args[1];
-    std::ifstream file(fileName);
-    if (!file.is_open()) {
-        std::cerr << "cat: unable to open file " << fileName << "\n";
-        return;
-    }
+static void builtin_cat(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
+    set_builtin_status(run_cat(args, in, out));
+}
 
-    std::string line;
-    while (std::getline(file, line)) {
-        std::cout << line << "\n";
-    }
-    file.close();
+void builtin_cat(const std::vector<std::string>& args) {
+    builtin_cat(args, std::cin, std::cout);
 }
 
 void builtin_cls(const std::vector<std::string>& args) {
+#ifndef _WIN32
+    std::cout << "\033[2J\033[H" << std::flush;
+#else
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
     if (hConsole == INVALID_HANDLE_VALUE) {
         std::cerr << "cls: Unable to get console handle\n";
@@ -628,21 +887,42 @@ void builtin_cls(const std::vector<std::string>& args) {
     FillConsoleOutputAttribute(hConsole, csbi.wAttributes, consoleSize, topLeft, &charsWritten);
 
     SetConsoleCursorPosition(hConsole, topLeft);
+#endif
 }
 
 void builtin_rem(const std::vector<std::string>& args) {
 }
 
+void builtin_source(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        std::cerr << "source: missing file name\n";
+        set_builtin_status(1);
+        return;
+    }
+    int status = run_script(args[1]);
+    if (status < 0) {
+        std::cerr << "source: cannot read " << args[1] << "\n";
+        status = 1;
+    }
+    set_builtin_status(status);
+}
+
 void builtin_mlist(const std::vector<std::string>& args) {
-    print_managed_processes();
+    print_managed_processes(args.size() > 1 && (args[1] == "--long" || args[1] == "-l"));
 }
 
 void builtin_pinfo(const std::vector<std::string>& args) {
     if (args.size() < 2) {
-        std::cout << "Usage: pinfo <pid>\n";
+        std::cout << "Usage: pinfo <pid|%job>\n";
+        set_builtin_status(1);
         return;
     }
-    DWORD pid = std::stoul(args[1]);
+    int job;
+    if (parse_job_spec(args[1], job)) {
+        print_job_info(job);
+        return;
+    }
+    proc_id pid = std::stoul(args[1]);
     print_process_info(pid);
 }
 
@@ -659,6 +939,19 @@ void builtin_monitor(const std::vector<std::string>& args) {
     monitorThread.detach(); 
 }
 
+void builtin_events(const std::vector<std::string>& args) {
+    EventQuery query;
+    if (!parse_event_query(args, query)) {
+        set_builtin_status(1);
+        return;
+    }
+    set_builtin_status(print_events(query));
+}
+
+void builtin_watch(const std::vector<std::string>& args) {
+    set_builtin_status(run_watch(args));
+}
+
 void builtin_stopmonitor(const std::vector<std::string>& args) {
     monitor_running = false;
     monitor_silent = false; 
@@ -677,5 +970,152 @@ void builtin_monitor_silent(const std::vector<std::string>& args) {
     monitorThread.detach(); 
 }
 
+// --- Registry ---
+// Ordered as `help` lists them. Adding a built-in means adding one line here.
+
+static constexpr BuiltinInfo kBuiltins[] = {
+    {"cd", builtin_cd, nullptr, 0, "File and Directory Commands", "cd <dir>", "Change the current directory to <dir>.", nullptr},
+    {"pwd", builtin_pwd, nullptr, 0, "File and Directory Commands", "pwd", "Print the current working directory.", nullptr},
+    {"dir", builtin_dir, builtin_dir, 0, "File and Directory Commands", "dir [-l] [-a] [-S] [-t] [-R] [path ...]",
+     "List directories (default: the current one) without starting another program.",
+     "  -l long format, -a include dot files, -S largest first, -t newest first, -R recurse.\n"},
+    {"find", builtin_find, builtin_find, 0, "File and Directory Commands", "find [-j N] [path ...] [-name PATTERN] [-type f|d|l] [-size [+|-]N[ckMG]] [-mtime [+|-]N]",
+     "Print every path under the given ones (default: .) that passes all the tests, walking with one thread per CPU (-j).",
+     "  -name matches the last component with * and ?; -size counts 512-byte blocks unless c, k, M or G follows;\n"
+     "  -mtime counts whole days; +N means more than N, -N less. Output order is not defined.\n"},
+    {"mkdir", builtin_mkdir, nullptr, 0, "File and Directory Commands", "mkdir <dir>", "Create a new directory.", nullptr},
+    {"rmdir", builtin_rmdir, nullptr, 0, "File and Directory Commands", "rmdir <dir>", "Remove an empty directory.", nullptr},
+    {"touch", builtin_touch, nullptr, 0, "File and Directory Commands", "touch <file>", "Create or update a file.", nullptr},
+    {"rm", builtin_rm, nullptr, 0, "File and Directory Commands", "rm <file>", "Remove a file.", nullptr},
+    {"cat", builtin_cat, builtin_cat, 0, "File and Directory Commands", "cat [-n] [-A] [file ...]", "Display the contents of files (or stdin), byte for byte.",
+     "  -n numbers the lines; -A shows tabs, control characters and line ends ($).\n"},
+    {"path", builtin_path, nullptr, 0, "File and Directory Commands", "path", "Display the current PATH environment variable.", nullptr},
+    {"addpath", builtin_addpath, nullptr, 0, "File and Directory Commands", "addpath <dir>", "Add <dir> to the PATH environment variable.", nullptr},
+    {"hash", builtin_hash, nullptr, 0, "File and Directory Commands", "hash [-r|-l]", "Show (-l: list, -r: forget) remembered command locations.", nullptr},
+
+    {"list", builtin_list, nullptr, 0, "Process Management Commands", "list [--sort pid|cpu|mem] [--filter name=PATTERN] [--top N]", "List the processes running on the system, optionally sorted by CPU or memory, filtered by name and cut to the first N.", nullptr},
+    {"top", builtin_top, nullptr, 0, "Process Management Commands", "top [-d seconds] [-n frames] [-j]",
+     "Show the busiest processes, refreshed every 2 seconds (-d) until q is pressed or -n frames were shown.",
+     "  Keys: c, m, p sort by CPU, memory or PID; j shows only this shell's jobs (as -j does); q quits.\n"},
+    {"mlist", builtin_mlist, nullptr, 0, "Process Management Commands", "mlist [--long]", "List all processes managed by this shell (--long: with CPU, memory and I/O).", nullptr},
+    {"pinfo", builtin_pinfo, nullptr, 0, "Process Management Commands", "pinfo <pid|%job>", "Display detailed information about a managed process, or every process of a job.", nullptr},
+    {"ptree", builtin_ptree, nullptr, 0, "Process Management Commands", "ptree [pid|%job]", "Show the process tree under <pid> or a job (default: under every running job).", nullptr},
+    {"kill", builtin_kill, nullptr, 0, "Process Management Commands", "kill <pid|%job|-g pgid|--tree pid|'name*'>",
+     "Terminate a process, a whole job, a process group, a process and its descendants, or every process whose name matches.", nullptr},
+    {"stop", builtin_stop, nullptr, 0, "Process Management Commands", "stop <pid|%job|-g pgid|--tree pid|'name*'>", "Suspend processes, chosen as for kill.", nullptr},
+    {"resume", builtin_resume, nullptr, 0, "Process Management Commands", "resume <pid|%job|-g pgid|--tree pid|'name*'>", "Resume processes, chosen as for kill.", nullptr},
+    {"jobs", builtin_jobs, nullptr, 0, "Process Management Commands", "jobs [-l]", "List background and stopped jobs (-l: with their PIDs).", nullptr},
+    {"fg", builtin_fg, nullptr, 0, "Process Management Commands", "fg [%job]", "Continue a job in the foreground and wait for it.", nullptr},
+    {"bg", builtin_bg, nullptr, 0, "Process Management Commands", "bg [%job]", "Continue a stopped job in the background.", nullptr},
+    {"wait", builtin_wait, nullptr, 0, "Process Management Commands", "wait [-n] [%job|pid ...]",
+     "Wait for the given jobs (default: all background jobs); -n returns when any one finishes.",
+     "  The status is that of the last job waited for (with -n: of the job that finished).\n"},
+    {"time", builtin_time, nullptr, 0, "Process Management Commands", "time <command>", "Run <command> and report its wall, user and system time and peak memory.", nullptr},
+    {"run", builtin_run, nullptr, 0, "Process Management Commands", "run [--mem SIZE] [--cpu-time SECS] [--files N] [--nice N] [--cpus LIST] <command>",
+     "Run <command> with resource limits, a nice value or a CPU set; works with '&' and in pipelines.",
+     "  SIZE takes K, M or G (address space); LIST is like 0-3,6. 'pinfo' shows what a job got.\n"},
+    {"parallel", builtin_parallel, builtin_parallel, 0, "Process Management Commands", "parallel -j N cmd {} ::: args",
+     "Run <cmd> once per argument, N at a time; output stays in argument order.",
+     "  Without :::, the arguments are read one per line from standard input.\n"},
+
+    {"monitor", builtin_monitor, nullptr, 0, "Monitoring Commands", "monitor", "Start monitoring process creation and deletion (normal mode).", nullptr},
+    {"monitor_silent", builtin_monitor_silent, nullptr, 0, "Monitoring Commands", "monitor_silent", "Start monitoring process creation and deletion (silent mode).", nullptr},
+    {"events", builtin_events, nullptr, 0, "Monitoring Commands", "events [--since T] [--name PATTERN] [--follow]",
+     "Show the process starts and exits the monitor recorded (--follow: keep showing new ones until a key is pressed).",
+     "  T is an age (30s, 5m, 2h) or a time of day (14:05); PATTERN may use * and ?.\n"},
+    {"watch", builtin_watch, nullptr, 0, "Monitoring Commands", "watch <pid|%job> [--interval T] --out FILE",
+     "Sample a job's CPU, memory, threads and I/O in the background into a binary log until it exits.",
+     "  'watch' lists the running watches, 'watch --stop <id|all>' ends them early and\n"
+     "  'watch --summary FILE' prints min, p50, p90, p99 and max per process. T: 100ms, 2s (default 1s).\n"},
+    {"stopmonitor", builtin_stopmonitor, nullptr, 0, "Monitoring Commands", "stopmonitor", "Stop the process monitoring.", nullptr},
+
+    {"cls", builtin_cls, nullptr, 0, "Shell Utility Commands", "cls", "Clear the console screen.", nullptr},
+    {"echo", builtin_echo, builtin_echo, 0, "Shell Utility Commands", "echo <text>", "Print <text> to the console.", nullptr},
+    {"date", builtin_date, nullptr, 0, "Shell Utility Commands", "date", "Display the current date and time.", nullptr},
+    {"exit", builtin_exit, nullptr, 0, "Shell Utility Commands", "exit [status]", "Exit the shell.", nullptr},
+    {"help", builtin_help, nullptr, 0, "Shell Utility Commands", "help", "Display this help message.", nullptr},
+    {"nyancat", builtin_nyancat, nullptr, 0, "Shell Utility Commands", "nyancat", "Display a jumping cat animation.", nullptr},
+    {"fireworks", builtin_fireworks, nullptr, 0, "Shell Utility Commands", "fireworks", "Display an ASCII fireworks animation.", nullptr},
+    {"snake", builtin_snake, nullptr, 0, "Shell Utility Commands", "snake", "Play the classic Snake game.", nullptr},
+    {"mines", builtin_mines, nullptr, 0, "Shell Utility Commands", "mines", "Play a game of Minesweeper.", nullptr},
+    {"hangman", builtin_hangman, nullptr, 0, "Shell Utility Commands", "hangman", "Play a game of Hangman (guess the word).", nullptr},
+    {"source", builtin_source, nullptr, 0, "Shell Utility Commands", "source <file>", "Run the commands in <file>; scripts are compiled once and cached.", nullptr},
+    {"REM", builtin_rem, nullptr, BUILTIN_HIDDEN, "Shell Utility Commands", "REM <text>", "Comment; the line is ignored.", nullptr},
+
+    {"worktime", showWorkTime, nullptr, 0, "System Information Commands", "worktime", "Display system uptime.", nullptr},
+    {"cpuinfo", showCPUInfo, nullptr, 0, "System Information Commands", "cpuinfo", "Display CPU information.", nullptr},
+    {"meminfo", showMemoryInfo, nullptr, 0, "System Information Commands", "meminfo", "Display memory usage information.", nullptr},
+    {"diskinfo", showDiskInfo, nullptr, 0, "System Information Commands", "diskinfo", "Display disk usage information for all drives.", nullptr},
+
+    {"history", builtin_history, builtin_history, 0, "Command History", "history", "Show the command history.", nullptr},
+    {"clear_history", builtin_clear_history, nullptr, 0, "Command History", "clear_history", "Clear the command history.", nullptr},
+
+    {"calculate", builtin_calculate, builtin_calculate, 0, "Calculator", "calculate <expr>",
+     "Evaluate a mathematical expression. Use quotes for expressions with spaces.",
+     "  Operators:      +, -, *, /, % (modulo), ^ (exponentiation), ! (factorial)\n"
+     "  Functions:      sqrt(x), sin(x), cos(x), tan(x), cot(x)\n"
+     "                  ln(x), log10(x), log2(x), log8(x), log16(x)\n"
+     "  Constants:      pi, e\n"
+     "  Unary +/-:      Supported, e.g., -5, -(2+3)\n"
+     "  Example:        calculate \"sin(pi/2) + (5! - 100)^2 % 9 - -sqrt(16)\"\n"},
+    {"convert", builtin_convert, builtin_convert, 0, "Calculator", "convert <val> from <b1> to <b2>",
+     "Convert number <val> from base <b1> to base <b2>.",
+     "  Example:        convert 1A from 16 to 10\n"
+     "                  convert 255 from 10 to 16\n"
+     "                  convert 1011 from 2 to 10\n"
+     "  Bases <b1>, <b2> must be integers between 2 and 36.\n"},
+
+    {"location", builtin_location, nullptr, 0, "General Purpose Utilities", "location", "Display the current geographical location (placeholder).", nullptr},
+    {"weather", builtin_weather, nullptr, 0, "General Purpose Utilities", "weather <city_name>", "Displays current weather.", nullptr},
+};
+
+static constexpr size_t kBuiltinCount = sizeof(kBuiltins) / sizeof(kBuiltins[0]);
+static constexpr auto kBuiltinHash = perfect_hash::build<256>(kBuiltins);
+static_assert(kBuiltinHash.ok, "no perfect hash seed for the built-in names; raise the slot count");
+
+const BuiltinInfo* find_builtin(const std::string& name) {
+    size_t i = kBuiltinHash.lookup(name.data(), name.size());
+    if (i == perfect_hash::npos || name != kBuiltins[i].name) return nullptr;
+    return &kBuiltins[i];
+}
+
+const BuiltinInfo* builtin_table(size_t& count) {
+    count = kBuiltinCount;
+    return kBuiltins;
+}
+
+static thread_local int builtinStatus = 0;
+
+void set_builtin_status(int status) {
+    builtinStatus = status;
+}
+
+int builtin_status() {
+    return builtinStatus;
+}
+
+bool is_builtin(const std::string& cmd) {
+    return find_builtin(cmd) != nullptr;
+}
 
+void run_builtin(const std::vector<std::string>& args) {
+    if (args.empty()) return;
+    const BuiltinInfo* b = find_builtin(args[0]);
+    if (b) b->run(args);
+    else {
+        std::cerr << "Unknown command: " << args[0] << "\n";
+        set_builtin_status(127);
+    }
+}
+
+bool is_stream_builtin(const std::string& cmd) {
+    const BuiltinInfo* b = find_builtin(cmd);
+    return b && b->stream;
+}
 
+void run_stream_builtin(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
+    if (args.empty()) return;
+    const BuiltinInfo* b = find_builtin(args[0]);
+    if (b && b->stream) b->stream(args, in, out);
+    out.flush();
+}
@@ -0,0 +1,272 @@
+#include "../include/cat.h"
+#include "../include/stream_pipe.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#endif
+
+namespace {
+
+const size_t kBlock = 1 << 20;
+const size_t kFilterFlush = 64 * 1024;
+
+// -n and -A over a byte stream; the line count and whether the next byte
+// starts a line carry over from one block (and one file) to the next
+class LineFilter {
+public:
+    LineFilter(bool number, bool showAll) : number(number), showAll(showAll) {}
+
+    void feed(const char* p, size_t n, std::ostream& out) {
+        const char* end = p + n;
+        while (p < end && out) {
+            if (lineStart && number) {
+                char label[24];
+                int len = std::snprintf(label, sizeof(label), "%6lu\t", ++line);
+                text.append(label, len);
+            }
+            lineStart = false;
+
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            const char* stop = newline ? newline : end;
+            if (showAll) {
+                for (; p < stop; ++p) show((unsigned char)*p);
+            } else {
+                text.append(p, stop);
+                p = stop;
+            }
+            if (newline) {
+                if (showAll) text += '$';
+                text += '\n';
+                lineStart = true;
+                ++p;
+            }
+            if (text.size() >= kFilterFlush) flush(out);
+        }
+        flush(out);
+    }
+
+private:
+    bool number;
+    bool showAll;
+    bool lineStart = true;
+    unsigned long line = 0;
+    std::string text;
+
+    // As cat -A: ^X for control bytes (tab included), ^? for DEL, M- for the high bit
+    void show(unsigned char c) {
+        if (c >= 128) {
+            text += "M-";
+            c -= 128;
+        }
+        if (c < 32) {
+            text += '^';
+            text += (char)(c + 64);
+        } else if (c == 127) {
+            text += "^?";
+        } else {
+            text += (char)c;
+        }
+    }
+
+    void flush(std::ostream& out) {
+        out.write(text.data(), text.size());
+        text.clear();
+    }
+};
+
+class Cat {
+public:
+    Cat(std::ostream& out, bool number, bool showAll)
+        : out(out), filtered(number || showAll), filter(number, showAll) {}
+
+    // false (after printing why) if the file could not be read
+    bool file(const std::string& name);
+
+    void stream(std::istream& in) {
+        if (!filtered) {
+            copy_stream(in, out);
+            return;
+        }
+        // Only what has already arrived, so `tail -f log | cat -n` shows each
+        // line as it comes. A buffer that cannot say how much it holds (stdin
+        // shared with stdio) is read up to the end of the line.
+        std::streambuf* sb = in.rdbuf();
+        char* buf = buffer();
+        while (out && sb->sgetc() != std::streambuf::traits_type::eof()) {
+            size_t n = 0;
+            while (n < kBlock) {
+                std::streamsize avail = sb->in_avail();
+                if (avail > 0) {
+                    n += (size_t)sb->sgetn(buf + n, std::min<std::streamsize>(avail, kBlock - n));
+                } else if (avail == 0 && (n == 0 || buf[n - 1] != '\n')) {
+                    int c = sb->sbumpc();
+                    if (c == std::streambuf::traits_type::eof()) break;
+                    buf[n++] = (char)c;
+                } else {
+                    break;
+                }
+            }
+            filter.feed(buf, n, out);
+        }
+    }
+
+private:
+    std::ostream& out;
+    bool filtered;
+    LineFilter filter;
+    bool sendfileWorks = true;
+    std::unique_ptr<char[]> block;
+
+    char* buffer() {
+        if (!block) block.reset(new char[kBlock]);
+        return block.get();
+    }
+
+    void write(const char* p, size_t n) {
+        if (filtered) filter.feed(p, n, out);
+        else out.write(p, n);
+    }
+
+#ifndef _WIN32
+    bool sendWhole(int fd, off_t size, const std::string& name, bool& ok);
+    bool blocks(int fd, const std::string& name);
+#endif
+};
+
+#ifdef _WIN32
+
+bool Cat::file(const std::string& name) {
+    std::ifstream in(name, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "cat: " << name << ": cannot open\n";
+        return false;
+    }
+    char* buf = buffer();
+    std::streamsize got;
+    while (out && (got = in.rdbuf()->sgetn(buf, kBlock)) > 0) write(buf, (size_t)got);
+    return true;
+}
+
+#else
+
+bool Cat::file(const std::string& name) {
+    int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "cat: " << name << ": " << std::strerror(errno) << "\n";
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    bool ok;
+    if (S_ISDIR(st.st_mode)) {
+        std::cerr << "cat: " << name << ": " << std::strerror(EISDIR) << "\n";
+        ok = false;
+    } else if (!S_ISREG(st.st_mode) || st.st_size == 0 || !sendWhole(fd, st.st_size, name, ok)) {
+        // Pipes, devices, /proc files whose size says nothing, and regular
+        // files the kernel cannot copy for us. No mmap: a file truncated
+        // under the mapping would kill the shell with SIGBUS.
+        ok = blocks(fd, name);
+    }
+    close(fd);
+    return ok;
+}
+
+// Has the kernel copy a regular file straight to the output descriptor.
+// false when that cannot start, so the caller falls back to plain reads;
+// `ok` says whether the file got through.
+bool Cat::sendWhole(int fd, off_t size, const std::string& name, bool& ok) {
+#ifdef __linux__
+    os_handle to = filtered || !sendfileWorks ? kNoHandle : stream_output_handle(out);
+    if (to == kNoHandle) return false;
+    ok = true;
+    off_t offset = 0;
+    while (offset < size) {
+        ssize_t sent = sendfile(to, fd, &offset, (size_t)std::min<off_t>(size - offset, 1 << 30));
+        if (sent > 0) continue;
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent == 0) break;   // the file shrank under us
+        if (offset == 0 && (errno == EINVAL || errno == ENOSYS)) {
+            // Some targets (an O_APPEND file on older kernels) refuse it
+            sendfileWorks = false;
+            return false;
+        }
+        // EPIPE: the reader went away, as when a plain write fails
+        if (errno != EPIPE) {
+            std::cerr << "cat: " << name << ": " << std::strerror(errno) << "\n";
+            ok = false;
+        }
+        out.setstate(std::ios::badbit);
+        break;
+    }
+    return true;
+#else
+    (void)fd; (void)size; (void)name; (void)ok;
+    return false;
+#endif
+}
+
+bool Cat::blocks(int fd, const std::string& name) {
+    char* buf = buffer();
+    while (out) {
+        ssize_t got = read(fd, buf, kBlock);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            std::cerr << "cat: " << name << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+        if (got == 0) break;
+        write(buf, (size_t)got);
+    }
+    return true;
+}
+
+#endif
+
+} // namespace
+
+int run_cat(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
+    bool number = false, showAll = false;
+    size_t first = 1;
+    for (; first < args.size() && args[first].size() > 1 && args[first][0] == '-'; ++first) {
+        if (args[first] == "--") {
+            ++first;
+            break;
+        }
+        for (size_t i = 1; i < args[first].size(); ++i) {
+            char c = args[first][i];
+            if (c == 'n') {
+                number = true;
+            } else if (c == 'A') {
+                showAll = true;
+            } else {
+                std::cerr << "Usage: cat [-n] [-A] [file|- ...]\n";
+                return 1;
+            }
+        }
+    }
+
+    Cat cat(out, number, showAll);
+    if (first == args.size()) {
+        // No file: copy stdin, so cat can sit at the end of a pipeline
+        cat.stream(in);
+        return 0;
+    }
+    int status = 0;
+    for (size_t i = first; i < args.size() && out; ++i) {
+        if (args[i] == "-") cat.stream(in);
+        else if (!cat.file(args[i])) status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,428 @@
+#include "../include/dir_list.h"
+#include "../include/dir_read.h"
+#include "../include/stream_pipe.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <pwd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t kMaxColumnEntries = 10000;   // more than this goes one per line
+
+struct Options {
+    enum Sort { ByName, BySize, ByTime } sort = ByName;
+    bool longFormat = false;
+    bool all = false;
+    bool recursive = false;
+};
+
+struct Entry : FileInfo {
+    uint32_t name = 0;              // offset of the NUL-terminated name in Listing::names
+};
+
+// One directory's entries, or the file operands given on the command line
+struct Listing {
+    std::string path;
+    std::string names;              // every name, NUL-terminated, back to back
+    std::vector<Entry> entries;
+
+    const char* name(const Entry& e) const { return names.data() + e.name; }
+
+    Entry& add(const char* name, size_t len, FileKind kind) {
+        Entry e;
+        e.name = (uint32_t)names.size();
+        e.kind = kind;
+        names.append(name, len);
+        names += '\0';
+        entries.push_back(e);
+        return entries.back();
+    }
+};
+
+bool needsStat(const Options& o, const Entry& e) {
+    return !e.statted && (o.longFormat || o.sort != Options::ByName || (o.recursive && e.kind == FileKind::Unknown));
+}
+
+void complain(const std::string& path, int err) {
+#ifdef _WIN32
+    std::cerr << "dir: cannot access " << path << " (Error code: " << err << ")\n";
+#else
+    std::cerr << "dir: cannot access " << path << ": " << std::strerror(err) << "\n";
+#endif
+}
+
+#ifdef _WIN32
+
+// FindFirstFileEx hands out the size, time and attributes with each name,
+// so nothing needs a second look
+bool readDirectory(const Options& o, Listing& l) {
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileExW(to_wide(l.path + "\\*").c_str(), FindExInfoBasic, &data,
+                                   FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE) {
+        complain(l.path, (int)GetLastError());
+        return false;
+    }
+    do {
+        if (data.cFileName[0] == L'.' && !o.all) continue;
+        char name[MAX_PATH * 3];
+        int len = WideCharToMultiByte(CP_UTF8, 0, data.cFileName, -1, name, sizeof(name), nullptr, nullptr);
+        if (len <= 1) continue;
+        Entry& e = l.add(name, len - 1, FileKind::Unknown);
+        fill_file_info(e, data.dwFileAttributes, data.nFileSizeHigh, data.nFileSizeLow, data.ftLastWriteTime);
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+    return true;
+}
+
+// An operand: false (after printing why) when it does not exist
+bool statOperand(const std::string& path, bool, Entry& e) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(to_wide(path).c_str(), GetFileExInfoStandard, &data)) {
+        complain(path, (int)GetLastError());
+        return false;
+    }
+    fill_file_info(e, data.dwFileAttributes, data.nFileSizeHigh, data.nFileSizeLow, data.ftLastWriteTime);
+    return true;
+}
+
+#else
+
+// getdents64 straight into a 1 MiB buffer: one call returns thousands of
+// entries, with their types on most file systems
+bool readDirectory(const Options& o, Listing& l, int dirFd) {
+    DirReader reader;
+    int err = reader.read(dirFd, [&](const char* name, FileKind kind) {
+        if (name[0] != '.' || o.all) l.add(name, std::strlen(name), kind);
+        return true;
+    });
+    if (err != 0) complain(l.path, err);
+    return err == 0;
+}
+
+void statEntries(const Options& o, Listing& l, int dirFd) {
+    unsigned mask = STATX_TYPE | STATX_MODE;
+    if (o.longFormat) mask = STATX_BASIC_STATS;
+    else if (o.sort == Options::BySize) mask |= STATX_SIZE;
+    else if (o.sort == Options::ByTime) mask |= STATX_MTIME;
+
+    auto statSlice = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Entry& e = l.entries[i];
+            if (needsStat(o, e)) stat_at(dirFd, l.name(e), mask, e);
+        }
+    };
+    size_t n = l.entries.size();
+    size_t threads = n >= kParallelStatEntries ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+    if (threads == 1) {
+        statSlice(0, n);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; ++t) workers.emplace_back(statSlice, n * t / threads, n * (t + 1) / threads);
+    statSlice(0, n / threads);
+    for (auto& w : workers) w.join();
+}
+
+// A symlink named on the command line is followed unless it is to be shown
+// itself (-l), as ls does
+bool statOperand(const std::string& path, bool follow, Entry& e) {
+    struct stat st;
+    if ((!follow || stat(path.c_str(), &st) != 0) && lstat(path.c_str(), &st) != 0) {
+        complain(path, errno);
+        return false;
+    }
+    fill_file_info(e, st);
+    return true;
+}
+
+#endif
+
+void sortEntries(const Options& o, Listing& l) {
+    const char* names = l.names.data();
+    auto byName = [names](const Entry& a, const Entry& b) { return std::strcmp(names + a.name, names + b.name) < 0; };
+    switch (o.sort) {
+        case Options::ByName:
+            std::sort(l.entries.begin(), l.entries.end(), byName);
+            break;
+        case Options::BySize:
+            std::sort(l.entries.begin(), l.entries.end(), [&](const Entry& a, const Entry& b) {
+                return a.size != b.size ? a.size > b.size : byName(a, b);
+            });
+            break;
+        case Options::ByTime:
+            std::sort(l.entries.begin(), l.entries.end(), [&](const Entry& a, const Entry& b) {
+                if (a.mtime != b.mtime) return a.mtime > b.mtime;
+                return a.mtimeNsec != b.mtimeNsec ? a.mtimeNsec > b.mtimeNsec : byName(a, b);
+            });
+            break;
+    }
+}
+
+// Output is built up here and written in large pieces
+class Printer {
+public:
+    explicit Printer(std::ostream& out) : out(out) {
+#ifndef _WIN32
+        os_handle h = stream_output_handle(out);
+        winsize ws;
+        if (h != kNoHandle && isatty(h)) width = ioctl(h, TIOCGWINSZ, &ws) == 0 && ws.ws_col ? ws.ws_col : 80;
+#endif
+    }
+    ~Printer() { flush(); }
+
+    std::string text;
+
+    void maybeFlush() {
+        if (text.size() >= kListingFlush) flush();
+    }
+    void flush() {
+        out.write(text.data(), text.size());
+        text.clear();
+    }
+
+    void listing(const Options& o, const Listing& l, bool total) {
+        if (o.longFormat) longListing(l, total);
+        else if (width && l.entries.size() <= kMaxColumnEntries) columns(l);
+        else {
+            for (const auto& e : l.entries) {
+                text += l.name(e);
+                text += '\n';
+                maybeFlush();
+            }
+        }
+    }
+
+private:
+    std::ostream& out;
+    size_t width = 0;               // terminal columns; 0 when not a terminal
+    std::unordered_map<uint32_t, std::string> users, groups;
+
+    // Down the columns, as ls does: the widest layout that fits the terminal
+    void columns(const Listing& l) {
+        size_t n = l.entries.size();
+        if (n == 0) return;
+        std::vector<size_t> lengths(n);
+        for (size_t i = 0; i < n; ++i) lengths[i] = std::strlen(l.name(l.entries[i]));
+
+        size_t rows = n;
+        std::vector<size_t> widths;
+        for (size_t cols = std::min(n, std::max<size_t>(1, width / 3)); cols > 1; --cols) {
+            size_t r = (n + cols - 1) / cols;
+            std::vector<size_t> w((n + r - 1) / r, 0);
+            for (size_t i = 0; i < n; ++i) w[i / r] = std::max(w[i / r], lengths[i]);
+            size_t total = 0;
+            for (size_t c : w) total += c + 2;
+            if (total - 2 <= width) {
+                rows = r;
+                widths = w;
+                break;
+            }
+        }
+        if (widths.empty()) widths.assign(1, 0);
+
+        for (size_t row = 0; row < rows; ++row) {
+            for (size_t i = row; i < n; i += rows) {
+                text += l.name(l.entries[i]);
+                if (i + rows < n) text.append(widths[i / rows] - lengths[i] + 2, ' ');
+            }
+            text += '\n';
+            maybeFlush();
+        }
+    }
+
+    const std::string& owner(uint32_t id, bool group) {
+        auto& cache = group ? groups : users;
+        auto it = cache.find(id);
+        if (it != cache.end()) return it->second;
+        std::string name;
+#ifndef _WIN32
+        if (group) {
+            if (struct group* g = getgrgid(id)) name = g->gr_name;
+        } else if (struct passwd* p = getpwuid(id)) {
+            name = p->pw_name;
+        }
+        if (name.empty()) name = std::to_string(id);
+#endif
+        return cache[id] = name;
+    }
+
+    static void modeText(const Entry& e, char* m) {
+#ifdef _WIN32
+        std::strcpy(m, e.kind == FileKind::Directory ? "d" : e.kind == FileKind::Symlink ? "l" : "-");
+        std::strcat(m, e.mode & FILE_ATTRIBUTE_READONLY ? "r--r--r--" : "rw-rw-rw-");
+#else
+        uint32_t mode = e.mode;
+        m[0] = S_ISDIR(mode) ? 'd' : S_ISLNK(mode) ? 'l' : S_ISCHR(mode) ? 'c' : S_ISBLK(mode) ? 'b'
+             : S_ISFIFO(mode) ? 'p' : S_ISSOCK(mode) ? 's' : '-';
+        const char* rwx = "rwxrwxrwx";
+        for (int i = 0; i < 9; ++i) m[i + 1] = mode & (0400 >> i) ? rwx[i] : '-';
+        if (mode & S_ISUID) m[3] = mode & S_IXUSR ? 's' : 'S';
+        if (mode & S_ISGID) m[6] = mode & S_IXGRP ? 's' : 'S';
+        if (mode & S_ISVTX) m[9] = mode & S_IXOTH ? 't' : 'T';
+        m[10] = '\0';
+#endif
+    }
+
+    void longListing(const Listing& l, bool total) {
+        size_t linkWidth = 1, userWidth = 0, groupWidth = 0, sizeWidth = 1;
+        uint64_t blocks = 0;
+        for (const auto& e : l.entries) {
+            linkWidth = std::max(linkWidth, std::to_string(e.nlink).size());
+            sizeWidth = std::max(sizeWidth, std::to_string(e.size).size());
+            userWidth = std::max(userWidth, owner(e.uid, false).size());
+            groupWidth = std::max(groupWidth, owner(e.gid, true).size());
+            blocks += e.blocks;
+        }
+        if (total) text += "total " + std::to_string(blocks / 2) + "\n";
+
+        // Within six months: month, day and time; otherwise the year instead of the time
+        std::time_t now = std::time(nullptr);
+        const std::time_t halfYear = 365 * 24 * 3600 / 2;
+        for (const auto& e : l.entries) {
+            char mode[16];
+            modeText(e, mode);
+            char when[32];
+            std::time_t t = (std::time_t)e.mtime;
+            std::tm local;
+#ifdef _WIN32
+            localtime_s(&local, &t);
+#else
+            localtime_r(&t, &local);
+#endif
+            bool recent = t <= now && now - t < halfYear;
+            std::strftime(when, sizeof(when), recent ? "%b %e %H:%M" : "%b %e  %Y", &local);
+
+            char line[256];
+            std::snprintf(line, sizeof(line), "%s %*u %-*s %-*s %*llu %s ", mode, (int)linkWidth, e.nlink,
+                          (int)userWidth, owner(e.uid, false).c_str(), (int)groupWidth, owner(e.gid, true).c_str(),
+                          (int)sizeWidth, (unsigned long long)e.size, when);
+            text += line;
+            text += l.name(e);
+#ifndef _WIN32
+            if (e.kind == FileKind::Symlink) {
+                char target[4096];
+                std::string path = l.path.empty() ? l.name(e) : l.path + "/" + l.name(e);
+                ssize_t len = readlink(path.c_str(), target, sizeof(target));
+                if (len > 0) text.append(" -> ").append(target, len);
+            }
+#endif
+            text += '\n';
+            maybeFlush();
+        }
+    }
+};
+
+// Lists one directory and, with -R, everything under it
+bool listDirectory(const Options& o, const std::string& path, bool header, Printer& p) {
+    Listing l;
+    l.path = path;
+#ifdef _WIN32
+    if (!readDirectory(o, l)) return false;
+#else
+    int dirFd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) {
+        complain(path, errno);
+        return false;
+    }
+    bool read = readDirectory(o, l, dirFd);
+    if (read) statEntries(o, l, dirFd);
+    close(dirFd);
+    if (!read) return false;
+#endif
+    sortEntries(o, l);
+
+    if (header) p.text += path + ":\n";
+    p.listing(o, l, true);
+    if (!o.recursive) return true;
+
+    bool ok = true;
+    for (const auto& e : l.entries) {
+        const char* name = l.name(e);
+        if (e.kind != FileKind::Directory || !std::strcmp(name, ".") || !std::strcmp(name, "..")) continue;
+        p.text += '\n';
+        std::string sub = path == "/" ? "/" + std::string(name) : path + "/" + name;
+        ok = listDirectory(o, sub, true, p) && ok;
+    }
+    return ok;
+}
+
+} // namespace
+
+int run_dir(const std::vector<std::string>& args, std::ostream& out) {
+    Options o;
+    std::vector<std::string> paths;
+    bool options = true;
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& a = args[i];
+        if (options && a == "--") {
+            options = false;
+        } else if (options && a.size() > 1 && a[0] == '-') {
+            for (size_t j = 1; j < a.size(); ++j) {
+                switch (a[j]) {
+                    case 'l': o.longFormat = true; break;
+                    case 'a': o.all = true; break;
+                    case 'S': o.sort = Options::BySize; break;
+                    case 't': o.sort = Options::ByTime; break;
+                    case 'R': o.recursive = true; break;
+                    default:
+                        std::cerr << "Usage: dir [-l] [-a] [-S] [-t] [-R] [path ...]\n";
+                        return 1;
+                }
+            }
+        } else {
+            paths.push_back(a);
+        }
+    }
+    if (paths.empty()) paths.push_back(".");
+
+    // Files named on the command line are listed first, together; then
+    // each directory under its own header
+    Printer p(out);
+    Listing files;
+    std::vector<std::string> dirs;
+    int status = 0;
+    for (const auto& path : paths) {
+        Entry e;
+        if (!statOperand(path, !o.longFormat, e)) {
+            status = 1;
+        } else if (e.kind == FileKind::Directory) {
+            dirs.push_back(path);
+        } else {
+            Entry& added = files.add(path.c_str(), path.size(), e.kind);
+            uint32_t name = added.name;
+            added = e;
+            added.name = name;
+        }
+    }
+    sortEntries(o, files);
+    p.listing(o, files, false);
+
+    bool headers = paths.size() > 1 || o.recursive;
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        if (i > 0 || !files.entries.empty()) p.text += '\n';
+        if (!listDirectory(o, dirs[i], headers, p)) status = 1;
+    }
+    return status;
+}
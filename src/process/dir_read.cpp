@@ -0,0 +1,94 @@
+#include "../include/dir_read.h"
+#include <atomic>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+#ifdef _WIN32
+
+std::wstring to_wide(const std::string& s) {
+    int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), nullptr, 0);
+    std::wstring w(len, 0);
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), &w[0], len);
+    return w;
+}
+
+void fill_file_info(FileInfo& f, DWORD attributes, DWORD sizeHigh, DWORD sizeLow, const FILETIME& written) {
+    f.kind = attributes & FILE_ATTRIBUTE_REPARSE_POINT ? FileKind::Symlink
+           : attributes & FILE_ATTRIBUTE_DIRECTORY     ? FileKind::Directory
+                                                       : FileKind::Regular;
+    f.mode = attributes;
+    f.nlink = 1;
+    f.size = (uint64_t)sizeHigh << 32 | sizeLow;
+    f.blocks = (f.size + 511) / 512;
+    // FILETIME: 100 ns units since 1601
+    uint64_t t = (uint64_t)written.dwHighDateTime << 32 | written.dwLowDateTime;
+    f.mtime = (int64_t)(t / 10000000) - 11644473600LL;
+    f.mtimeNsec = (uint32_t)(t % 10000000) * 100;
+    f.statted = true;
+}
+
+#else
+
+FileKind file_kind_of_dtype(unsigned char type) {
+    switch (type) {
+        case DT_REG: return FileKind::Regular;
+        case DT_DIR: return FileKind::Directory;
+        case DT_LNK: return FileKind::Symlink;
+        case DT_UNKNOWN: return FileKind::Unknown;
+        default: return FileKind::Other;
+    }
+}
+
+static FileKind kindOfMode(uint32_t mode) {
+    return S_ISREG(mode) ? FileKind::Regular
+         : S_ISDIR(mode) ? FileKind::Directory
+         : S_ISLNK(mode) ? FileKind::Symlink
+                         : FileKind::Other;
+}
+
+void fill_file_info(FileInfo& f, const struct stat& st) {
+    f.mode = st.st_mode;
+    f.kind = kindOfMode(st.st_mode);
+    f.nlink = (uint32_t)st.st_nlink;
+    f.uid = st.st_uid;
+    f.gid = st.st_gid;
+    f.size = st.st_size;
+    f.blocks = st.st_blocks;
+    f.mtime = st.st_mtim.tv_sec;
+    f.mtimeNsec = (uint32_t)st.st_mtim.tv_nsec;
+    f.statted = true;
+}
+
+bool stat_at(int dirFd, const char* name, unsigned mask, FileInfo& f) {
+#ifdef STATX_BASIC_STATS
+    static std::atomic<bool> haveStatx(true);
+    if (haveStatx) {
+        struct statx sx;
+        if (statx(dirFd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask, &sx) == 0) {
+            f.mode = sx.stx_mode;
+            f.kind = kindOfMode(sx.stx_mode);
+            f.nlink = sx.stx_nlink;
+            f.uid = sx.stx_uid;
+            f.gid = sx.stx_gid;
+            f.size = sx.stx_size;
+            f.blocks = sx.stx_blocks;
+            f.mtime = sx.stx_mtime.tv_sec;
+            f.mtimeNsec = sx.stx_mtime.tv_nsec;
+            f.statted = true;
+            return true;
+        }
+        if (errno != ENOSYS) return false;
+        haveStatx = false;
+    }
+#else
+    (void)mask;
+#endif
+    struct stat st;
+    if (fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) return false;
+    fill_file_info(f, st);
+    return true;
+}
+
+#endif
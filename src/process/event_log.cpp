@@ -0,0 +1,185 @@
+#include "../include/event_log.h"
+#include "../include/event_ring.h"
+#include "../include/key_reader.h"
+#include "../include/proc_snapshot.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+static_assert(sizeof(MonitorEvent) == 64, "MonitorEvent should fill one cache line");
+
+const size_t kRingSize = 4096;
+const size_t kHistorySize = 65536;
+const auto kFollowPoll = std::chrono::milliseconds(100);
+
+MpscRing<MonitorEvent, kRingSize> ring;
+std::atomic<uint64_t> dropped(0);
+
+// The ring's consumer side: one drainer at a time
+std::mutex drainMutex;
+std::deque<MonitorEvent> history;
+uint64_t historyStart = 0;          // number of events ever pushed out of `history`
+uint64_t reported = 0;              // how far report_monitor_events() got
+
+uint64_t historyEnd() { return historyStart + history.size(); }
+
+void drainLocked() {
+    MonitorEvent e;
+    while (ring.pop(e)) {
+        history.push_back(e);
+        if (history.size() > kHistorySize) {
+            history.pop_front();
+            ++historyStart;
+        }
+    }
+}
+
+// The events from index `from` on; moves `from` past them
+std::vector<MonitorEvent> eventsFrom(uint64_t& from) {
+    std::lock_guard<std::mutex> lock(drainMutex);
+    drainLocked();
+    if (from < historyStart) from = historyStart;
+    std::vector<MonitorEvent> out(history.begin() + (from - historyStart), history.end());
+    from = historyEnd();
+    return out;
+}
+
+std::string timeText(int64_t whenUs) {
+    std::time_t seconds = (std::time_t)(whenUs / 1000000);
+    char buf[16];
+    std::strftime(buf, sizeof(buf), "%H:%M:%S", std::localtime(&seconds));
+    char ms[8];
+    std::snprintf(ms, sizeof(ms), ".%03d", (int)(whenUs / 1000 % 1000));
+    return std::string(buf) + ms;
+}
+
+void printEvent(const MonitorEvent& e) {
+    static const char* const kinds[] = {"start", "exec", "exit", "removed"};
+    std::cout << timeText(e.when_us) << "  " << kinds[e.type] << std::string(8 - std::strlen(kinds[e.type]), ' ')
+              << "PID " << e.pid;
+    if (e.type == ProcEvent::Fork) std::cout << "  PPID " << e.ppid;
+    std::cout << "  " << e.name;
+    if (e.type == ProcEvent::Exit && e.exit_code >= 0) std::cout << "  (status " << e.exit_code << ")";
+    std::cout << "\n";
+}
+
+bool matches(const MonitorEvent& e, const EventQuery& query, int64_t sinceUs) {
+    if (query.hasSince && e.when_us < sinceUs) return false;
+    return query.name.empty() || wildcard_match(query.name.c_str(), e.name);
+}
+
+int64_t microseconds(std::chrono::system_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+}
+
+} // namespace
+
+void log_monitor_event(const ProcEvent& event) {
+    MonitorEvent e;
+    e.when_us = microseconds(event.when);
+    e.pid = (uint32_t)event.pid;
+    e.ppid = (uint32_t)event.ppid;
+    e.exit_code = event.exit_code;
+    e.type = event.type;
+    size_t len = std::min(event.name.size(), sizeof(e.name) - 1);
+    std::memcpy(e.name, event.name.data(), len);
+    e.name[len] = '\0';
+
+    if (ring.push(e)) return;
+    // Full and nobody has read it lately: move it to the history ourselves,
+    // unless a reader is already at it
+    std::unique_lock<std::mutex> lock(drainMutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        drainLocked();
+        if (ring.push(e)) return;
+    }
+    ++dropped;
+}
+
+uint64_t monitor_events_dropped() {
+    return dropped;
+}
+
+void report_monitor_events() {
+    std::vector<MonitorEvent> fresh = eventsFrom(reported);
+    if (monitor_silent) return;
+    static const char* const labels[] = {"[NEW PROCESS]", "[EXEC]", "[TERMINATED PROCESS]", "[AUTO REMOVED]"};
+    for (const auto& e : fresh) {
+        std::cout << labels[e.type] << " PID: " << e.pid << " | Name: " << e.name << "\n";
+    }
+}
+
+bool parse_event_query(const std::vector<std::string>& args, EventQuery& query) {
+    query = EventQuery();
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "--follow" || args[i] == "-f") {
+            query.follow = true;
+        } else if (args[i] == "--name" && i + 1 < args.size()) {
+            query.name = args[++i];
+        } else if (args[i] == "--since" && i + 1 < args.size()) {
+            const std::string& value = args[++i];
+            auto now = std::chrono::system_clock::now();
+            char* end;
+            long n = std::strtol(value.c_str(), &end, 10);
+            int hour, minute, second = 0;
+            char tail;
+            if (end != value.c_str() && n >= 0 && end[0] && !end[1] && std::strchr("smh", *end)) {
+                long unit = *end == 's' ? 1 : *end == 'm' ? 60 : 3600;
+                query.since = now - std::chrono::seconds(n * unit);
+            } else if ((std::sscanf(value.c_str(), "%d:%d%c", &hour, &minute, &tail) == 2 ||
+                        std::sscanf(value.c_str(), "%d:%d:%d%c", &hour, &minute, &second, &tail) == 3) &&
+                       hour >= 0 && hour < 24 && minute >= 0 && minute < 60 && second >= 0 && second < 60) {
+                std::time_t t = std::chrono::system_clock::to_time_t(now);
+                std::tm local = *std::localtime(&t);
+                local.tm_hour = hour;
+                local.tm_min = minute;
+                local.tm_sec = second;
+                local.tm_isdst = -1;
+                query.since = std::chrono::system_clock::from_time_t(std::mktime(&local));
+                if (query.since > now) query.since -= std::chrono::hours(24);   // that time yesterday
+            } else {
+                std::cerr << "events: bad time '" << value << "' (use e.g. 30s, 5m, 2h or 14:05)\n";
+                return false;
+            }
+            query.hasSince = true;
+        } else {
+            std::cerr << "Usage: events [--since T] [--name PATTERN] [--follow]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int print_events(const EventQuery& query) {
+    int64_t sinceUs = query.hasSince ? microseconds(query.since) : 0;
+    uint64_t cursor = 0;
+    size_t shown = 0;
+    for (const auto& e : eventsFrom(cursor)) {
+        if (matches(e, query, sinceUs)) {
+            printEvent(e);
+            ++shown;
+        }
+    }
+    if (!query.follow) {
+        if (shown == 0 && !monitor_running) std::cout << "No events (the monitor is not running; see 'monitor').\n";
+        if (uint64_t lost = monitor_events_dropped()) std::cout << "(" << lost << " events were dropped)\n";
+        return 0;
+    }
+
+    std::cout << "Following; press any key to stop.\n" << std::flush;
+    KeyReader keys;
+    while (keys.next(std::chrono::steady_clock::now() + kFollowPoll) == KeyReader::kNone) {
+        for (const auto& e : eventsFrom(cursor)) {
+            if (matches(e, query, sinceUs)) printEvent(e);
+        }
+        std::cout << std::flush;
+    }
+    return 0;
+}
@@ -1,34 +1,37 @@
 #include "../include/execute.h"
 #include "../include/builtin.h"          
 #include "../include/process_manager.h" 
-#include <windows.h>
+#include "../include/stream_pipe.h"
+#include "../include/process_launcher.h"
+#include "../include/script.h"
+#include "../include/job_control.h"
+#include "../include/job_table.h"
+#include "../include/resource_limits.h"
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <fstream> 
+#include <memory>
+#include <thread>
 #include <fcntl.h>     
 #include <stdio.h>     
 
+#ifdef _WIN32
+#include <windows.h>
+
 extern HANDLE g_currentProcess; // Truy cập biến toàn cục từ main.cpp
 
-// Convert UTF-8 std::string args to a Windows Unicode command line
-static std::wstring joinArgs(const std::vector<std::string>& args) {
-    std::wstring result;
-    for (const auto& arg : args) {
-        if (!result.empty()) result += L' ';
-        int size_needed = MultiByteToWideChar(CP_UTF8, 0, arg.c_str(), (int)arg.size(), NULL, 0);
-        std::wstring warg(size_needed, 0);
-        MultiByteToWideChar(CP_UTF8, 0, arg.c_str(), (int)arg.size(), &warg[0], size_needed);
-        if (warg.find(L' ') != std::wstring::npos) {
-            result += L'"' + warg + L'"';
-        } else {
-            result += warg;
-        }
+static int launchPipeline(const Pipeline &pl);
+
+int executeCommand(const Command &cmd) {
+    // `run [limits] cmd`: the limits travel with the command to the launcher,
+    // so '&', redirections and the job table work as for any other command
+    if (!cmd.argv.empty() && cmd.argv[0] == "run") {
+        Command limited;
+        return parse_run_command(cmd, limited) ? executeCommand(limited) : 1;
     }
-    return result;
-}
 
-void executeCommand(const Command &cmd) {
     // --- Prepare STARTUPINFO and handle inheritance for redirection ---
     STARTUPINFOW si{};
     PROCESS_INFORMATION pi{};
@@ -52,7 +55,7 @@ void executeCommand(const Command &cmd) {
                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
         if (hIn == INVALID_HANDLE_VALUE) {
             std::wcerr << L"Error opening input file: " << winIn << L"\n";
-            return;
+            return 1;
         }
         SetHandleInformation(hIn, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
         si.hStdInput = hIn;
@@ -83,7 +86,7 @@ void executeCommand(const Command &cmd) {
 
         if (hOut == INVALID_HANDLE_VALUE) {
             std::wcerr << L"Error opening output file: " << winOut << L"\n";
-            return;
+            return 1;
         }
 
         // Nếu là append, di chuyển con trỏ về cuối file
@@ -119,14 +122,10 @@ void executeCommand(const Command &cmd) {
         }
 
         // --- Run inline script from input file ---
+        int status = 0;
         if (!cmd.infile.empty()) {
-            std::ifstream infile(cmd.infile);
-            std::string line;
-            while (std::getline(infile, line)) {
-                if (line.empty()) continue;
-                Command subCmd = parseCommand(line);
-                if (!subCmd.argv.empty()) executeCommand(subCmd);
-            }
+            status = run_script(cmd.infile);
+            if (status < 0) status = 1;
         }
 
         // Restore stdout 
@@ -139,67 +138,489 @@ void executeCommand(const Command &cmd) {
         }
 
         if (hIn != INVALID_HANDLE_VALUE) CloseHandle(hIn);
-        return;
+        return status;
     }
 
     //Built-in commands: redirect std::cout/std::cerr using C++ streams
-    if (is_builtin(cmd.argv[0])) {
+    if (const BuiltinInfo* builtin = find_builtin(cmd.argv[0])) {
+        int status = executeBuiltin(*builtin, cmd);
+
+        if (hIn  != INVALID_HANDLE_VALUE) CloseHandle(hIn);
+        if (hOut != INVALID_HANDLE_VALUE) CloseHandle(hOut);
+        return status;
+    }
+
+    if (hIn  != INVALID_HANDLE_VALUE) CloseHandle(hIn);
+    if (hOut != INVALID_HANDLE_VALUE) CloseHandle(hOut);
+
+    //Launch external process 
+    Pipeline single;
+    single.stages.push_back(cmd);
+    single.background = cmd.background;
+    return launchPipeline(single);
+}
+
+// A launched external stage
+struct Child {
+    LaunchedProcess proc;
+    std::string limits;             // `run` limits, for pinfo
+};
+
+// Both ends are created non-inheritable; spawnStage hands out inheritable
+// duplicates only to the child that needs them.
+static bool makeOsPipe(os_handle& readEnd, os_handle& writeEnd) {
+    if (!CreatePipe(&readEnd, &writeEnd, nullptr, 0)) {
+        std::cerr << "Failed to create pipe (Error code: " << GetLastError() << ")\n";
+        return false;
+    }
+    return true;
+}
+
+static void closeOsHandle(os_handle h) {
+    if (h != kNoHandle) CloseHandle(h);
+}
+
+static os_handle dupStdHandle(bool output) {
+    HANDLE dup = kNoHandle;
+    DuplicateHandle(GetCurrentProcess(), GetStdHandle(output ? STD_OUTPUT_HANDLE : STD_INPUT_HANDLE),
+                    GetCurrentProcess(), &dup, 0, FALSE, DUPLICATE_SAME_ACCESS);
+    return dup;
+}
+
+// Spawn one external stage with `in`/`out` as its stdin/stdout (kNoHandle
+// keeps the shell's own); explicit redirections take precedence.
+static bool spawnStage(const Command& stage, os_handle in, os_handle out, const std::vector<os_handle>& pipes, bool pgid, Child& child) {
+    if (stage.argv[0] == "run") {
+        Command limited;
+        return parse_run_command(stage, limited) && spawnStage(limited, in, out, pipes, pgid, child);
+    }
+    if (is_builtin(stage.argv[0])) {
+        std::cerr << "Built-in command cannot be used in a pipeline: " << stage.argv[0] << "\n";
+        return false;
+    }
+    if (stage.limits) child.limits = stage.limits->describe();
+    return default_launcher().launch(stage, in, out, child.proc);
+}
+
+// Returns the exit status of the last child (0 in the background). There is
+// no Ctrl-Z here, so `stopped` is always false.
+static int finishChildren(std::vector<Child>& children, bool background, bool& stopped) {
+    ProcessLauncher& launcher = default_launcher();
+    stopped = false;
+    int job = 0;   // every stage of the pipeline joins the first one's job
+    for (auto& c : children) {
+        job = addProcess(c.proc.pid, c.proc.cmdline, c.proc.hProcess, background, job);
+        if (!c.limits.empty()) job_table().setLimits(c.proc.pid, c.limits);
+        if (background) std::wcout << L"[bg] PID=" << c.proc.pid << L" JOB=%" << job << L"\n";
+    }
+
+    int status = 0;
+    if (!background && !children.empty()) {
+        g_currentProcess = children.back().proc.hProcess;
+        for (auto& c : children) {
+            status = launcher.wait(c.proc);
+            ProcessUsage usage;
+            sample_process_usage(c.proc.pid, usage);   // the launcher still holds its handle
+            record_foreground_usage(usage);
+            removeProcess(c.proc.pid);
+        }
+        g_currentProcess = NULL;
+    }
+    for (auto& c : children) launcher.release(c.proc);
+    return status;
+}
+
+#else // POSIX
+
+#include <unistd.h>
+#include <signal.h>
+
+
+// A launched external (or forked built-in) stage
+struct Child {
+    pid_t pid;
+    std::string cmdline;
+    std::string limits;             // `run` limits, for pinfo
+};
+
+// Human-readable command line for the managed process list
+static std::string joinArgs(const std::vector<std::string>& args) {
+    std::string result;
+    for (const auto& arg : args) {
+        if (!result.empty()) result += ' ';
+        if (arg.find(' ') != std::string::npos) {
+            result += '"' + arg + '"';
+        } else {
+            result += arg;
+        }
+    }
+    return result;
+}
+
+// Both ends are O_CLOEXEC, so every end a child does not dup2 closes at exec
+static bool makeOsPipe(os_handle& readEnd, os_handle& writeEnd) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        perror("pipe");
+        return false;
+    }
+    readEnd = fds[0];
+    writeEnd = fds[1];
+    return true;
+}
+
+static void closeOsHandle(os_handle h) {
+    if (h != kNoHandle) close(h);
+}
+
+static os_handle dupStdHandle(bool output) {
+    return fcntl(output ? STDOUT_FILENO : STDIN_FILENO, F_DUPFD_CLOEXEC, 0);
+}
+
+// Run a non-streaming built-in as a pipeline stage in a forked child so it
+// can use the process-wide std::cout while the other stages run.
+static pid_t forkBuiltin(const Command& stage, int in, int out, const std::vector<os_handle>& pipes, pid_t pgid) {
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = fork();
+    if (pid != 0) {
+        // Both sides set the group, so it is in place whichever runs first
+        if (pid > 0 && pgid >= 0) setpgid(pid, pgid);
+        return pid;
+    }
+
+    if (pgid >= 0) setpgid(0, pgid);
+    signal(SIGPIPE, SIG_DFL);
+    signal(SIGTSTP, SIG_DFL);
+    signal(SIGTTIN, SIG_DFL);
+    signal(SIGTTOU, SIG_DFL);
+    if (in != kNoHandle) dup2(in, STDIN_FILENO);
+    if (out != kNoHandle) dup2(out, STDOUT_FILENO);
+    for (int fd : pipes) close(fd);
+
+    int status = executeCommand(stage);
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(status);
+}
+
+// Spawn one stage with `in`/`out` as its stdin/stdout (kNoHandle keeps the
+// shell's own); explicit redirections in the stage take precedence. `pgid`
+// is the process group to join (0: a new one, -1: the shell's).
+static bool spawnStage(const Command& stage, os_handle in, os_handle out, const std::vector<os_handle>& pipes, pid_t pgid, Child& child) {
+    if (stage.argv[0] == "run") {
+        Command limited;
+        return parse_run_command(stage, limited) && spawnStage(limited, in, out, pipes, pgid, child);
+    }
+    child.cmdline = joinArgs(stage.argv);
+    if (stage.limits) child.limits = stage.limits->describe();
+
+    if (is_builtin(stage.argv[0])) {
+        child.pid = forkBuiltin(stage, in, out, pipes, pgid);
+        return child.pid > 0;
+    }
+
+    LaunchedProcess proc;
+    proc.pgid = pgid;
+    if (!default_launcher().launch(stage, in, out, proc)) return false;
+    child.pid = proc.pid;
+    return true;
+}
+
+// Returns the exit status of the last child (0 in the background). A job
+// stopped by Ctrl-Z stays behind in the background and sets `stopped`.
+static int finishChildren(std::vector<Child>& children, bool background, bool& stopped) {
+    int job = 0;   // every stage of the pipeline joins the first one's job
+    for (const auto& c : children) {
+        job = addProcess(c.pid, c.cmdline, background, job);
+        if (!c.limits.empty()) job_table().setLimits(c.pid, c.limits);
+        if (background) std::cout << "[bg] PID=" << c.pid << " JOB=%" << job << "\n";
+    }
+    stopped = false;
+    if (background || children.empty()) return 0;
+
+    // Forked built-ins are reaped the same way as spawned programs
+    return wait_foreground(job, stopped);
+}
+
+static int launchPipeline(const Pipeline &pl);
+
+int executeCommand(const Command &cmd) {
+    // Handle empty commands (inline script)
+    if (cmd.argv.empty()) {
         std::streambuf* oldCout = nullptr;
-        std::streambuf* oldCerr = nullptr;
         std::ofstream ofs;
         if (!cmd.outfile.empty()) {
-            ofs.open(cmd.outfile, std::ios::out | std::ios::app);
-            if (ofs.is_open()) {
-                oldCout = std::cout.rdbuf(ofs.rdbuf());
-                oldCerr = std::cerr.rdbuf(ofs.rdbuf());
-            } else {
-                std::cerr << "Error: Unable to open output file: " << cmd.outfile << "\n";
+            ofs.open(cmd.outfile, cmd.appendMode ? std::ios::out | std::ios::app : std::ios::out);
+            if (!ofs.is_open()) {
+                std::cerr << "Error opening output file: " << cmd.outfile << "\n";
+                return 1;
             }
+            oldCout = std::cout.rdbuf(ofs.rdbuf());
         }
-        run_builtin(cmd.argv);
+
+        // --- Run inline script from input file ---
+        int status = 0;
+        if (!cmd.infile.empty()) {
+            status = run_script(cmd.infile);
+            if (status < 0) status = 1;
+        }
+
         std::cout.flush();
-        std::cerr.flush();
         if (oldCout) std::cout.rdbuf(oldCout);
-        if (oldCerr) std::cerr.rdbuf(oldCerr);
-        if (ofs.is_open()) ofs.close();
+        return status;
+    }
 
-        if (hIn  != INVALID_HANDLE_VALUE) CloseHandle(hIn);
-        if (hOut != INVALID_HANDLE_VALUE) CloseHandle(hOut);
-        return;
+    // `run [limits] cmd`: the limits travel with the command to the launcher,
+    // so '&', redirections and the job table work as for any other command
+    if (cmd.argv[0] == "run") {
+        Command limited;
+        return parse_run_command(cmd, limited) ? executeCommand(limited) : 1;
+    }
+
+    //Built-in commands: redirect std::cout/std::cerr using C++ streams
+    if (const BuiltinInfo* builtin = find_builtin(cmd.argv[0])) {
+        return executeBuiltin(*builtin, cmd);
     }
 
     //Launch external process 
-    std::wstring cmdline = joinArgs(cmd.argv);
-    LPWSTR cmdline_ptr = const_cast<LPWSTR>(cmdline.c_str());
-    BOOL ok = CreateProcessW(nullptr, cmdline_ptr, nullptr, nullptr,
-                         TRUE, 0, nullptr, nullptr, &si, &pi);
+    Pipeline single;
+    single.stages.push_back(cmd);
+    single.background = cmd.background;
+    return launchPipeline(single);
+}
 
+#endif
 
-    if (hIn  != INVALID_HANDLE_VALUE) CloseHandle(hIn);
-    if (hOut != INVALID_HANDLE_VALUE) CloseHandle(hOut);
+static std::atomic<int> lastStatus{0};
+
+int last_status() {
+    return lastStatus;
+}
+
+void set_last_status(int status) {
+    lastStatus = status;
+}
+
+int executeBuiltin(const BuiltinInfo &builtin, const Command &cmd) {
+    // `cat < file`: whatever the built-in reads from std::cin comes from the file
+    std::streambuf* oldCin = nullptr;
+    std::filebuf ifb;
+    if (!cmd.infile.empty()) {
+        if (!ifb.open(cmd.infile, std::ios::in | std::ios::binary)) {
+            std::cerr << "Error opening input file: " << cmd.infile << "\n";
+            set_last_status(1);
+            return 1;
+        }
+        oldCin = std::cin.rdbuf(&ifb);
+    }
+    std::streambuf* oldCout = nullptr;
+    std::streambuf* oldCerr = nullptr;
+    std::ofstream ofs;
+    if (!cmd.outfile.empty()) {
+        ofs.open(cmd.outfile, std::ios::out | (cmd.appendMode ? std::ios::app : std::ios::trunc));
+        if (ofs.is_open()) {
+            oldCout = std::cout.rdbuf(ofs.rdbuf());
+            oldCerr = std::cerr.rdbuf(ofs.rdbuf());
+        } else {
+            std::cerr << "Error: Unable to open output file: " << cmd.outfile << "\n";
+        }
+    }
+    set_builtin_status(0);
+    builtin.run(cmd.argv);
+    std::cout.flush();
+    std::cerr.flush();
+    if (oldCout) std::cout.rdbuf(oldCout);
+    if (oldCerr) std::cerr.rdbuf(oldCerr);
+    if (oldCin) {
+        std::cin.rdbuf(oldCin);
+        std::cin.clear();
+    }
+    set_last_status(builtin_status());
+    return builtin_status();
+}
+
+// --- In-process pipeline stages ---
+//
+// Streaming built-ins (cat, echo, history, ...) run on worker threads with
+// their own istream/ostream. Two adjacent ones are linked by a ChunkRing, so
+// bytes move between them without a copy; a kernel pipe is only created where
+// a built-in borders an external process.
+
+// One side of the link between stage i and stage i+1
+struct StageLink {
+    std::shared_ptr<ChunkRing> ring;
+    os_handle readEnd = kNoHandle;
+    os_handle writeEnd = kNoHandle;
+};
+
+// A streambuf the stage either owns or borrows (std::cin/std::cout)
+struct StageBuf {
+    std::unique_ptr<std::streambuf> owned;
+    std::streambuf* buf = nullptr;
+
+    void own(std::streambuf* b) { owned.reset(b); buf = b; }
+};
 
-    if (!ok) {
-        std::wcerr << L"Failed to start process: " << cmdline << L"\n";
-        return;
+static void runStreamStage(Command stage, std::shared_ptr<StageBuf> in, std::shared_ptr<StageBuf> out, std::shared_ptr<int> status) {
+    {
+        std::istream is(in->buf);
+        std::ostream os(out->buf);
+        set_builtin_status(0);
+        run_stream_builtin(stage.argv, is, os);
+        *status = builtin_status();
     }
+    // Close the output first so the next stage sees end of stream even if
+    // closing the input has to wait on anything
+    if (out->owned) out->owned.reset(); else out->buf->pubsync();
+    in->owned.reset();
+}
 
-    if (cmd.background) {
-        std::wcout << L"[bg] PID=" << pi.dwProcessId << L"\n";
-        addProcess(pi.dwProcessId, cmdline, pi.hProcess, true);
-        CloseHandle(pi.hThread);
-        CloseHandle(pi.hProcess);
+static bool openStageInput(const Command& stage, const StageLink* link, bool background, StageBuf& in) {
+    if (!stage.infile.empty()) {
+        auto* fb = new std::filebuf;
+        in.own(fb);
+        if (!fb->open(stage.infile, std::ios::in | std::ios::binary)) {
+            std::cerr << "Error opening input file: " << stage.infile << "\n";
+            return false;
+        }
+    } else if (link && link->ring) {
+        in.own(new RingInBuf(link->ring));
+    } else if (link) {
+        in.own(new HandleBuf(link->readEnd, false));
+    } else if (background) {
+        in.own(new HandleBuf(dupStdHandle(false), false));
     } else {
-        // Lưu handle của tiến trình foreground
-        g_currentProcess = pi.hProcess;
+        in.buf = std::cin.rdbuf();
+    }
+    return true;
+}
 
-        addProcess(pi.dwProcessId, cmdline, pi.hProcess, false);
-        WaitForSingleObject(pi.hProcess, INFINITE);
+static bool openStageOutput(const Command& stage, const StageLink* link, bool background, StageBuf& out) {
+    if (!stage.outfile.empty()) {
+        auto* fb = new std::filebuf;
+        out.own(fb);
+        auto mode = std::ios::out | std::ios::binary | (stage.appendMode ? std::ios::app : std::ios::trunc);
+        if (!fb->open(stage.outfile, mode)) {
+            std::cerr << "Error opening output file: " << stage.outfile << "\n";
+            return false;
+        }
+    } else if (link && link->ring) {
+        out.own(new RingOutBuf(link->ring));
+    } else if (link) {
+        out.own(new HandleBuf(link->writeEnd, true));
+    } else if (background) {
+        out.own(new HandleBuf(dupStdHandle(true), true));
+    } else {
+        out.buf = std::cout.rdbuf();
+    }
+    return true;
+}
 
-        // Xóa trạng thái foreground sau khi tiến trình kết thúc
-        g_currentProcess = NULL;
+static int launchPipeline(const Pipeline &pl) {
+    const size_t n = pl.stages.size();
+
+    std::vector<bool> inProcess(n);
+    for (size_t i = 0; i < n; ++i) inProcess[i] = is_stream_builtin(pl.stages[i].argv[0]);
+
+    // links[i] connects stage i to stage i+1
+    std::vector<StageLink> links(n > 0 ? n - 1 : 0);
+    std::vector<os_handle> pipeHandles;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        if (inProcess[i] && inProcess[i + 1]) {
+            links[i].ring = std::make_shared<ChunkRing>();
+        } else if (makeOsPipe(links[i].readEnd, links[i].writeEnd)) {
+            pipeHandles.push_back(links[i].readEnd);
+            pipeHandles.push_back(links[i].writeEnd);
+        } else {
+            for (os_handle h : pipeHandles) closeOsHandle(h);
+            return 1;
+        }
+    }
+
+    // Processes first: forking after the stage threads exist would copy
+    // whatever locks they happen to hold into the child
+    std::vector<Child> children;
+    bool lastSpawned = false;
+#ifdef _WIN32
+    bool pgid = false;   // unused: no process groups
+#else
+    // The first process leads a new group the rest join, so that one
+    // killpg() reaches the whole job: always for a background job, and for
+    // every job under job control. Without it a foreground job stays in the
+    // shell's group, where the terminal's Ctrl-C reaches it.
+    pid_t pgid = job_control_enabled() || pl.background ? 0 : -1;
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        if (inProcess[i]) continue;
+        os_handle in  = (i == 0) ? kNoHandle : links[i - 1].readEnd;
+        os_handle out = (i + 1 == n) ? kNoHandle : links[i].writeEnd;
+        Child child;
+        if (spawnStage(pl.stages[i], in, out, pipeHandles, pgid, child)) {
+            children.push_back(child);
+            lastSpawned = (i + 1 == n);
+#ifndef _WIN32
+            if (pgid == 0) pgid = child.pid;
+#endif
+        }
+    }
+
+    // The children own their ends now; the shell keeps only the ends its
+    // stage threads use (handed to HandleBuf, which closes them)
+    for (size_t i = 0; i + 1 < n; ++i) {
+        if (links[i].ring) continue;
+        if (!inProcess[i]) closeOsHandle(links[i].writeEnd);
+        if (!inProcess[i + 1]) closeOsHandle(links[i].readEnd);
+    }
+
+    // The pipeline's status is its last stage's; a stage that could not
+    // start counts as 127 (not found), one that could not open a file as 1
+    std::cout.flush();
+    std::vector<std::thread> threads;
+    auto lastStageStatus = std::make_shared<int>(1);
+    for (size_t i = 0; i < n; ++i) {
+        if (!inProcess[i]) continue;
+        auto in = std::make_shared<StageBuf>();
+        auto out = std::make_shared<StageBuf>();
+        bool ok = openStageInput(pl.stages[i], i == 0 ? nullptr : &links[i - 1], pl.background, *in);
+        ok = openStageOutput(pl.stages[i], i + 1 == n ? nullptr : &links[i], pl.background, *out) && ok;
+        if (!ok) continue; // dropping the buffers closes this stage's ends
+        auto status = (i + 1 == n) ? lastStageStatus : std::make_shared<int>(1);
+        threads.emplace_back(runStreamStage, pl.stages[i], in, out, status);
+    }
 
-        CloseHandle(pi.hThread);
-        CloseHandle(pi.hProcess);
+    bool stopped;
+    int childStatus = finishChildren(children, pl.background, stopped);
+    for (auto& t : threads) {
+        // A stopped job's stage threads may be blocked on it: let them go too
+        if (pl.background || stopped) t.detach(); else t.join();
     }
+
+    if (pl.background) return 0;
+    if (stopped) return childStatus;
+    if (inProcess[n - 1]) return *lastStageStatus;
+    return lastSpawned ? childStatus : 127;
+}
+
+int executePipeline(const Pipeline &pl) {
+    if (pl.stages.empty()) return 0;
+
+    if (pl.stages.size() == 1) {
+        Command cmd = pl.stages[0];
+        cmd.background = pl.background;
+        return executeCommand(cmd);
+    }
+
+    return launchPipeline(pl);
 }
 
+int executeList(const CommandList &list) {
+    int status = 0;
+    for (const auto& item : list.items) {
+        if (item.connector == ListItem::IF_SUCCESS && status != 0) continue;
+        if (item.connector == ListItem::IF_FAILURE && status == 0) continue;
+        status = item.group ? executeList(*item.group) : executePipeline(item.pipeline);
+        set_last_status(status);
+    }
+    return status;
+}
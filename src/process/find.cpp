@@ -0,0 +1,412 @@
+#include "../include/find.h"
+#include "../include/dir_read.h"
+#include "../include/proc_snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t kMaxWalkersPerCpu = 4;
+
+#ifdef _WIN32
+const char kSeparator = '\\';
+#else
+const char kSeparator = '/';
+#endif
+
+// -size and -mtime: +N more than N, -N less than N, N exactly
+struct Bound {
+    char cmp = 0;
+    int64_t n = 0;
+
+    bool test(int64_t v) const { return cmp == '+' ? v > n : cmp == '-' ? v < n : v == n; }
+};
+
+struct Tests {
+    std::string name;               // empty: any name
+    FileKind type = FileKind::Unknown;  // Unknown: any type
+    bool bySize = false;
+    Bound size;
+    uint64_t sizeUnit = 512;
+    bool byAge = false;
+    Bound days;
+    int64_t now = 0;
+
+    bool named(const char* base) const { return name.empty() || wildcard_match(name.c_str(), base); }
+
+    bool needsStat(const FileInfo& s) const {
+        return !s.statted && (bySize || byAge || (type != FileKind::Unknown && s.kind == FileKind::Unknown));
+    }
+
+    // The tests after -name, on a path that has been statted if it needed to be
+    bool pass(const FileInfo& s) const {
+        if (type != FileKind::Unknown && s.kind != type) return false;
+        if (bySize && !size.test((int64_t)((s.size + sizeUnit - 1) / sizeUnit))) return false;
+        if (byAge) {
+            int64_t age = now - s.mtime;
+            int64_t whole = age >= 0 ? age / 86400 : -((-age + 86399) / 86400);
+            if (!days.test(whole)) return false;
+        }
+        return true;
+    }
+};
+
+std::string join(const std::string& dir, const char* name) {
+    std::string path = dir;
+    if (path.empty() || path.back() != kSeparator) path += kSeparator;
+    path += name;
+    return path;
+}
+
+// The last component, as -name sees a path given on the command line
+std::string baseName(const std::string& path) {
+    size_t end = path.find_last_not_of("/\\");
+    if (end == std::string::npos) return path.substr(0, 1);
+    size_t start = path.find_last_of("/\\", end);
+    start = start == std::string::npos ? 0 : start + 1;
+    return path.substr(start, end + 1 - start);
+}
+
+// A directory that has been opened. Its descriptor stays open while any of
+// its subdirectories still waits to be opened relative to it.
+struct Dir {
+    std::string path;               // as printed
+#ifndef _WIN32
+    int fd = -1;
+
+    ~Dir() {
+        if (fd >= 0) close(fd);
+    }
+#endif
+};
+
+// A directory to read: `name` inside `parent`, or a path from the command line
+struct Task {
+    std::shared_ptr<Dir> parent;
+    std::string name;
+};
+
+struct WorkQueue {
+    std::mutex lock;
+    std::deque<Task> tasks;
+};
+
+class Walker {
+public:
+    Walker(const Tests& tests, std::ostream& out, size_t threads) : tests(tests), out(out), queues(threads) {}
+
+    void root(const std::string& path);
+    bool run();
+
+private:
+    // One per thread; only the owner touches it
+    struct Worker {
+        std::string text;
+        std::vector<Task> found;
+        DirReader dents;
+    };
+
+    const Tests& tests;
+    std::ostream& out;
+    std::vector<WorkQueue> queues;
+    size_t nextRoot = 0;
+    std::atomic<size_t> pending{0};  // directories queued or being read
+    std::atomic<bool> failed{false};
+    std::atomic<bool> stopped{false};  // `out` failed: the reader went away
+    std::mutex outLock;              // `out` and std::cerr
+    std::mutex idleLock;
+    std::condition_variable idle;
+
+    void work(size_t self);
+    bool next(size_t self, Task& t);
+    void read(Worker& w, const Task& t);
+    void push(size_t self, std::vector<Task>& found);
+
+    void emit(Worker& w, const std::string& path) {
+        w.text += path;
+        w.text += '\n';
+        if (w.text.size() >= kListingFlush) flush(w);
+    }
+
+    void flush(Worker& w) {
+        if (w.text.empty()) return;
+        std::lock_guard<std::mutex> lock(outLock);
+        out.write(w.text.data(), w.text.size());
+        w.text.clear();
+        if (!out) stopped = true;
+    }
+
+    void complain(const std::string& path, int err) {
+        failed = true;
+        std::lock_guard<std::mutex> lock(outLock);
+#ifdef _WIN32
+        std::cerr << "find: " << path << " (Error code: " << err << ")\n";
+#else
+        std::cerr << "find: " << path << ": " << std::strerror(err) << "\n";
+#endif
+    }
+};
+
+// A path from the command line is tested like any other, then queued if it
+// is a directory; roots are dealt out to the walkers in turn
+void Walker::root(const std::string& path) {
+    FileInfo s;
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(to_wide(path).c_str(), GetFileExInfoStandard, &data)) {
+        complain(path, (int)GetLastError());
+        return;
+    }
+    fill_file_info(s, data.dwFileAttributes, data.nFileSizeHigh, data.nFileSizeLow, data.ftLastWriteTime);
+#else
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) {
+        complain(path, errno);
+        return;
+    }
+    fill_file_info(s, st);
+#endif
+    if (tests.named(baseName(path).c_str()) && tests.pass(s)) {
+        std::lock_guard<std::mutex> lock(outLock);
+        out << path << '\n';
+        if (!out) stopped = true;
+    }
+    if (s.kind != FileKind::Directory) return;
+    ++pending;
+    queues[nextRoot++ % queues.size()].tasks.push_back(Task{nullptr, path});
+}
+
+bool Walker::run() {
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < queues.size(); ++t) threads.emplace_back(&Walker::work, this, t);
+    work(0);
+    for (auto& t : threads) t.join();
+    return !failed;
+}
+
+void Walker::work(size_t self) {
+    Worker w;
+    Task t;
+    while (!stopped) {
+        if (next(self, t)) {
+            read(w, t);
+            t = Task();   // lets go of the parent, and maybe its descriptor
+            push(self, w.found);
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> lock(idleLock);
+                idle.notify_all();
+            }
+            continue;
+        }
+        // Nothing to take anywhere. Directories may still turn up from a
+        // walker that is reading, so wait a little unless all are done.
+        std::unique_lock<std::mutex> lock(idleLock);
+        if (pending == 0 || stopped) break;
+        idle.wait_for(lock, std::chrono::milliseconds(1));
+    }
+    flush(w);
+}
+
+// Newest from our own deque, otherwise the oldest from somebody else's
+bool Walker::next(size_t self, Task& t) {
+    {
+        WorkQueue& own = queues[self];
+        std::lock_guard<std::mutex> lock(own.lock);
+        if (!own.tasks.empty()) {
+            t = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); ++i) {
+        WorkQueue& victim = queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.lock);
+        if (!victim.tasks.empty()) {
+            t = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Walker::push(size_t self, std::vector<Task>& found) {
+    if (found.empty()) return;
+    pending += found.size();
+    {
+        WorkQueue& own = queues[self];
+        std::lock_guard<std::mutex> lock(own.lock);
+        for (auto& t : found) own.tasks.push_back(std::move(t));
+    }
+    found.clear();
+    if (queues.size() > 1) idle.notify_all();
+}
+
+#ifdef _WIN32
+
+void Walker::read(Worker& w, const Task& t) {
+    auto dir = std::make_shared<Dir>();
+    dir->path = t.parent ? join(t.parent->path, t.name.c_str()) : t.name;
+
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileExW(to_wide(join(dir->path, "*")).c_str(), FindExInfoBasic, &data,
+                                   FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE) {
+        complain(dir->path, (int)GetLastError());
+        return;
+    }
+    do {
+        char name[MAX_PATH * 3];
+        if (WideCharToMultiByte(CP_UTF8, 0, data.cFileName, -1, name, sizeof(name), nullptr, nullptr) <= 1) continue;
+        if (!std::strcmp(name, ".") || !std::strcmp(name, "..")) continue;
+        FileInfo s;
+        fill_file_info(s, data.dwFileAttributes, data.nFileSizeHigh, data.nFileSizeLow, data.ftLastWriteTime);
+        if (tests.named(name) && tests.pass(s)) emit(w, join(dir->path, name));
+        if (s.kind == FileKind::Directory) w.found.push_back(Task{dir, name});
+    } while (!stopped && FindNextFileW(find, &data));
+    FindClose(find);
+}
+
+#else
+
+void Walker::read(Worker& w, const Task& t) {
+    auto dir = std::make_shared<Dir>();
+    if (t.parent) {
+        dir->path = join(t.parent->path, t.name.c_str());
+        dir->fd = openat(t.parent->fd, t.name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    } else {
+        dir->path = t.name;
+        dir->fd = open(t.name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    if (dir->fd < 0) {
+        complain(dir->path, errno);
+        return;
+    }
+
+    int err = w.dents.read(dir->fd, [&](const char* name, FileKind kind) {
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) return true;
+
+        FileInfo s;
+        s.kind = kind;
+        bool named = tests.named(name);
+        // A file system that leaves the type out costs a stat per entry
+        // anyway, since only a directory is descended into
+        if ((named && tests.needsStat(s)) || s.kind == FileKind::Unknown) {
+            if (!stat_at(dir->fd, name, STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME, s)) {
+                complain(join(dir->path, name), errno);
+                return !stopped;
+            }
+        }
+        if (named && tests.pass(s)) emit(w, join(dir->path, name));
+        if (s.kind == FileKind::Directory) w.found.push_back(Task{dir, name});
+        return !stopped;
+    });
+    if (err != 0) complain(dir->path, err);
+}
+
+#endif
+
+bool parseBound(const std::string& text, Bound& b, std::string& unit) {
+    size_t i = 0;
+    if (!text.empty() && (text[0] == '+' || text[0] == '-')) b.cmp = text[i++];
+    if (i >= text.size() || !std::isdigit((unsigned char)text[i])) return false;
+    char* end;
+    b.n = (int64_t)std::strtoull(text.c_str() + i, &end, 10);
+    unit = end;
+    return true;
+}
+
+bool parseTests(const std::vector<std::string>& args, size_t i, Tests& t) {
+    for (; i < args.size(); i += 2) {
+        const std::string& test = args[i];
+        if (i + 1 >= args.size()) return false;
+        const std::string& value = args[i + 1];
+        std::string unit;
+        if (test == "-name") {
+            t.name = value;
+        } else if (test == "-type") {
+            if (value == "f") t.type = FileKind::Regular;
+            else if (value == "d") t.type = FileKind::Directory;
+            else if (value == "l") t.type = FileKind::Symlink;
+            else return false;
+        } else if (test == "-size") {
+            if (!parseBound(value, t.size, unit) || unit.size() > 1) return false;
+            switch (unit.empty() ? 'b' : unit[0]) {
+                case 'b': t.sizeUnit = 512; break;
+                case 'c': t.sizeUnit = 1; break;
+                case 'k': t.sizeUnit = 1024; break;
+                case 'M': t.sizeUnit = 1024 * 1024; break;
+                case 'G': t.sizeUnit = 1024 * 1024 * 1024; break;
+                default: return false;
+            }
+            t.bySize = true;
+        } else if (test == "-mtime") {
+            if (!parseBound(value, t.days, unit) || !unit.empty()) return false;
+            t.byAge = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int run_find(const std::vector<std::string>& args, std::ostream& out) {
+    const char* usage = "Usage: find [-j N] [path ...] [-name PATTERN] [-type f|d|l] [-size [+|-]N[ckMG]] [-mtime [+|-]N]\n";
+    size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+    size_t threads = cpus;
+    size_t i = 1;
+    if (i < args.size() && args[i].compare(0, 2, "-j") == 0) {
+        std::string value = args[i].size() > 2 ? args[i].substr(2) : (i + 1 < args.size() ? args[++i] : "");
+        ++i;
+        // Digits only: stoul would take "-1" as the largest unsigned long
+        threads = value.empty() || value.size() > 9 || value.find_first_not_of("0123456789") != std::string::npos
+                      ? 0
+                      : std::stoul(value);
+        if (threads == 0) {
+            std::cerr << "find: -j needs a positive number\n";
+            return 1;
+        }
+        // More walkers than this only add contention on the deques
+        threads = std::min(threads, kMaxWalkersPerCpu * cpus);
+    }
+
+    std::vector<std::string> roots;
+    for (; i < args.size() && !(args[i].size() > 1 && args[i][0] == '-'); ++i) roots.push_back(args[i]);
+    if (roots.empty()) roots.push_back(".");
+
+    Tests tests;
+    if (!parseTests(args, i, tests)) {
+        std::cerr << usage;
+        return 1;
+    }
+    tests.now = (int64_t)std::time(nullptr);
+
+    Walker walker(tests, out, threads);
+    for (const auto& r : roots) walker.root(r);
+    return walker.run() ? 0 : 1;
+}
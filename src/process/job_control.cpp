@@ -0,0 +1,455 @@
+#include "../include/job_control.h"
+#include "../include/job_table.h"
+#include "../include/reaper.h"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern pid_t g_currentProcess;
+#endif
+
+namespace {
+
+#ifndef _WIN32
+bool enabled = false;
+pid_t shellPgid = 0;
+#endif
+
+thread_local ProcessUsage* usageSink = nullptr;   // set while `time` runs a command
+
+// The table's processes grouped by job, in job order
+std::vector<std::vector<ProcessInfo>> allJobs() {
+    std::vector<std::vector<ProcessInfo>> result;
+    for (const auto& p : job_table().snapshot()) {
+        if (result.empty() || result.back()[0].job_id != p.job_id) result.emplace_back();
+        result.back().push_back(p);
+    }
+    return result;
+}
+
+// What `jobs` lists: anything not running in the foreground right now
+bool isListed(const std::vector<ProcessInfo>& members) {
+    for (const auto& p : members) {
+        if (p.is_background || p.status == ProcessStatus::Suspended) return true;
+    }
+    return false;
+}
+
+// Waiting for a stopped job would never end: nothing continues it meanwhile
+bool anyStopped(const std::vector<ProcessInfo>& members) {
+    for (const auto& p : members) {
+        if (p.status == ProcessStatus::Suspended) return true;
+    }
+    return false;
+}
+
+// `wait`'s status for a job that is stopped, as for one stopped in the foreground
+#ifdef _WIN32
+const int kStoppedStatus = 148;   // 128 + SIGTSTP on Linux
+#else
+const int kStoppedStatus = 128 + SIGTSTP;
+#endif
+
+bool allDone(const std::vector<ProcessInfo>& members) {
+    for (const auto& p : members) {
+        if (p.status != ProcessStatus::Done) return false;
+    }
+    return true;
+}
+
+std::string jobName(const std::vector<ProcessInfo>& members) {
+    std::string name;
+    for (const auto& p : members) name += (name.empty() ? "" : " | ") + p.name;
+    return name;
+}
+
+// A pipeline reports the status of its last stage, as it would in the foreground
+std::string jobState(const std::vector<ProcessInfo>& members) {
+    bool stopped = false;
+    for (const auto& p : members) {
+        if (p.status == ProcessStatus::Running) return "Running";
+        stopped = stopped || p.status == ProcessStatus::Suspended;
+    }
+    if (stopped) return "Stopped";
+    int status = members.back().exit_status;
+    return status == 0 ? "Done" : "Exit " + std::to_string(status);
+}
+
+void forget(const std::vector<ProcessInfo>& members) {
+    for (const auto& p : members) job_table().remove(p.pid);
+}
+
+// The job `fg`/`bg` pick without an argument: the newest one in the background
+int currentJob() {
+    auto jobs = allJobs();
+    for (auto it = jobs.rbegin(); it != jobs.rend(); ++it) {
+        if (isListed(*it)) return it->front().job_id;
+    }
+    return 0;
+}
+
+bool lookup(const char* cmd, int job, std::vector<ProcessInfo>& members) {
+    if (job == 0) job = currentJob();
+    members = job_table().job(job);
+    if (members.empty()) {
+        std::cerr << cmd << ": " << (job == 0 ? std::string("no current job") : "%" + std::to_string(job) + ": no such job") << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Bring back to the background, where the reaper watches it
+void markRunningInBackground(const std::vector<ProcessInfo>& members) {
+    for (const auto& p : members) {
+        if (p.status == ProcessStatus::Done) continue;
+        job_table().setStatus(p.pid, ProcessStatus::Running);
+        if (!p.is_background) {
+            job_table().setBackground(p.pid, true);
+            reaper_watch(p.pid);
+        }
+    }
+}
+
+#ifdef _WIN32
+
+void continueJob(const std::vector<ProcessInfo>& members) {
+    for (const auto& p : members) {
+        if (p.status == ProcessStatus::Suspended) resume_process(p.pid);
+    }
+}
+
+// No reaper on Windows: wait on the process handle and record the exit here
+int awaitProcess(const ProcessInfo& p) {
+    if (p.status == ProcessStatus::Done) return p.exit_status;
+    HANDLE h = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, p.pid);
+    DWORD code = (DWORD)-1;
+    ProcessUsage usage;
+    if (h) {
+        WaitForSingleObject(h, INFINITE);
+        GetExitCodeProcess(h, &code);
+        sample_process_usage(p.pid, usage);   // our handle keeps the numbers around
+        CloseHandle(h);
+    }
+    job_table().finish(p.pid, (int)code, usage);
+    record_foreground_usage(usage);
+    return (int)code;
+}
+
+int awaitAnyJob(const std::vector<int>& ids) {
+    while (true) {
+        std::vector<std::vector<ProcessInfo>> candidates;
+        for (auto& members : allJobs()) {
+            bool wanted = ids.empty() ? isListed(members) : false;
+            for (int id : ids) wanted = wanted || members[0].job_id == id;
+            if (!wanted) continue;
+            if (allDone(members)) return members[0].job_id;
+            candidates.push_back(members);
+        }
+        if (candidates.empty()) return 0;
+
+        std::vector<HANDLE> handles;
+        std::vector<proc_id> pids;
+        for (const auto& members : candidates) {
+            for (const auto& p : members) {
+                if (p.status == ProcessStatus::Done || handles.size() == MAXIMUM_WAIT_OBJECTS) continue;
+                HANDLE h = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, p.pid);
+                if (!h) {
+                    job_table().finish(p.pid, -1);   // gone before we could look
+                    continue;
+                }
+                handles.push_back(h);
+                pids.push_back(p.pid);
+            }
+        }
+        if (!handles.empty()) {
+            DWORD r = WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, INFINITE);
+            if (r < WAIT_OBJECT_0 + handles.size()) {
+                DWORD code = (DWORD)-1;
+                ProcessUsage usage;
+                GetExitCodeProcess(handles[r - WAIT_OBJECT_0], &code);
+                sample_process_usage(pids[r - WAIT_OBJECT_0], usage);
+                job_table().finish(pids[r - WAIT_OBJECT_0], (int)code, usage);
+            }
+        }
+        for (HANDLE h : handles) CloseHandle(h);
+    }
+}
+
+#else
+
+void continueJob(const std::vector<ProcessInfo>& members) {
+    if (enabled) {
+        kill(-members[0].pid, SIGCONT);   // the first stage leads the job's group
+        return;
+    }
+    for (const auto& p : members) {
+        if (p.status != ProcessStatus::Done) kill(p.pid, SIGCONT);
+    }
+}
+
+int awaitProcess(const ProcessInfo& p) {
+    job_table().waitDone({p.pid});
+    ProcessInfo done;
+    if (!job_table().find(p.pid, done)) return p.exit_status;
+    record_foreground_usage(done.usage);
+    return done.exit_status;
+}
+
+int awaitAnyJob(const std::vector<int>& ids) {
+    return job_table().waitAnyDone(ids);
+}
+
+void giveTerminal(pid_t pgid) {
+    if (enabled) tcsetpgrp(STDIN_FILENO, pgid);
+}
+
+// Waits for the job's processes in order, noticing Ctrl-Z
+int waitInForeground(const std::vector<ProcessInfo>& members, bool resume, bool& stopped) {
+    stopped = false;
+    giveTerminal(members[0].pid);
+    // Also wakes a new stage that read the terminal before it was handed over
+    if (resume || enabled) continueJob(members);
+
+    g_currentProcess = members.back().pid;
+    int status = 0;
+    for (const auto& p : members) {
+        if (p.status == ProcessStatus::Done) {
+            status = p.exit_status;
+            continue;
+        }
+        int raw;
+        ProcessUsage usage;
+        pid_t r = wait_child(p.pid, WUNTRACED, raw, usage);
+        if (r == p.pid && WIFSTOPPED(raw)) {
+            stopped = true;
+            break;
+        }
+        if (r == p.pid) {
+            status = exit_status_of(raw);
+            job_table().finish(p.pid, status, usage);
+            record_foreground_usage(usage);
+        } else {
+            status = awaitProcess(p);   // a job that was in the background: the reaper had it
+        }
+    }
+    g_currentProcess = 0;
+    giveTerminal(shellPgid);
+
+    if (!stopped) {
+        forget(members);
+        return status;
+    }
+
+    std::vector<ProcessInfo> now = job_table().job(members[0].job_id);
+    for (const auto& p : now) {
+        if (p.status == ProcessStatus::Done) continue;
+        job_table().setStatus(p.pid, ProcessStatus::Suspended);
+        if (!p.is_background) {
+            job_table().setBackground(p.pid, true);
+            reaper_watch(p.pid);
+        }
+    }
+    std::cout << "\n[" << members[0].job_id << "]  Stopped\t" << jobName(members) << "\n";
+    return 128 + SIGTSTP;
+}
+
+#endif
+
+} // namespace
+
+void collect_foreground_usage(ProcessUsage* sink) {
+    usageSink = sink;
+}
+
+void record_foreground_usage(const ProcessUsage& usage) {
+    if (usageSink) *usageSink += usage;
+}
+
+#ifdef _WIN32
+
+void job_control_init() {}
+
+bool job_control_enabled() {
+    return false;
+}
+
+#else
+
+void job_control_init() {
+    if (!isatty(STDIN_FILENO)) return;
+
+    // Started in the background by another shell: wait to be brought forward
+    while (tcgetpgrp(STDIN_FILENO) != (shellPgid = getpgrp())) kill(-shellPgid, SIGTTIN);
+
+    signal(SIGTSTP, SIG_IGN);
+    signal(SIGTTIN, SIG_IGN);
+    signal(SIGTTOU, SIG_IGN);   // so the shell can take the terminal back
+
+    setpgid(0, 0);   // fails harmlessly when the shell already leads a session
+    shellPgid = getpgrp();
+    tcsetpgrp(STDIN_FILENO, shellPgid);
+    enabled = true;
+}
+
+bool job_control_enabled() {
+    return enabled;
+}
+
+int wait_foreground(int job, bool& stopped) {
+    std::vector<ProcessInfo> members = job_table().job(job);
+    stopped = false;
+    if (members.empty()) return 0;
+    return waitInForeground(members, false, stopped);
+}
+
+#endif
+
+void report_finished_jobs() {
+    std::ostringstream out;
+    for (const auto& members : allJobs()) {
+        bool background = true;
+        for (const auto& p : members) background = background && p.is_background;
+        if (!background || !allDone(members)) continue;
+        out << "[" << members[0].job_id << "] " << jobState(members) << "\t" << jobName(members) << "\n";
+        forget(members);
+    }
+    std::cout << out.str();
+}
+
+int print_jobs(bool showPids) {
+    std::ostringstream out;
+    out << std::left;
+    for (const auto& members : allJobs()) {
+        if (!isListed(members)) continue;
+        std::string state = jobState(members);
+        bool running = state == "Running";
+        if (showPids) {
+            for (size_t i = 0; i < members.size(); ++i) {
+                out << std::setw(6) << (i == 0 ? "[" + std::to_string(members[0].job_id) + "]" : "")
+                    << std::setw(9) << members[i].pid
+                    << std::setw(10) << (members[i].status == ProcessStatus::Done ? jobState({members[i]}) : process_status_name(members[i].status))
+                    << (i > 0 ? "| " : "") << members[i].name
+                    << (running && i + 1 == members.size() ? " &" : "") << "\n";
+            }
+        } else {
+            out << std::setw(6) << ("[" + std::to_string(members[0].job_id) + "]")
+                << std::setw(10) << state << jobName(members) << (running ? " &" : "") << "\n";
+        }
+        // Like the prompt, `jobs` reports a finished job only once
+        if (allDone(members)) forget(members);
+    }
+    std::cout << out.str();
+    return 0;
+}
+
+int foreground_job(int job) {
+    std::vector<ProcessInfo> members;
+    if (!lookup("fg", job, members)) return 1;
+    std::cout << jobName(members) << "\n";
+    std::cout.flush();
+
+    for (const auto& p : members) {
+        if (p.status == ProcessStatus::Done) continue;
+        job_table().setStatus(p.pid, ProcessStatus::Running);
+        job_table().setBackground(p.pid, false);
+    }
+#ifdef _WIN32
+    continueJob(members);
+    int status = 0;
+    for (const auto& p : members) status = awaitProcess(p);
+    forget(members);
+    return status;
+#else
+    bool stopped;
+    return waitInForeground(members, true, stopped);
+#endif
+}
+
+int background_job(int job) {
+    std::vector<ProcessInfo> members;
+    if (!lookup("bg", job, members)) return 1;
+    if (allDone(members)) {
+        std::cerr << "bg: %" << members[0].job_id << ": job has terminated\n";
+        return 1;
+    }
+    markRunningInBackground(members);
+    continueJob(members);
+    std::cout << "[" << members[0].job_id << "] " << jobName(members) << " &\n";
+    return 0;
+}
+
+int wait_jobs(const std::vector<std::string>& specs, bool any) {
+    // Resolve every operand before blocking, so a typo fails at once
+    std::vector<int> ids;
+    std::vector<std::vector<ProcessInfo>> targets;
+    for (const auto& spec : specs) {
+        int job;
+        if (parse_job_spec(spec, job)) {
+            std::vector<ProcessInfo> members = job_table().job(job);
+            if (members.empty()) {
+                std::cerr << "wait: " << spec << ": no such job\n";
+                return 127;
+            }
+            ids.push_back(job);
+            targets.push_back(members);
+            continue;
+        }
+        char* end;
+        long pid = std::strtol(spec.c_str(), &end, 10);
+        ProcessInfo p;
+        if (*end != '\0' || pid <= 0 || !job_table().find((proc_id)pid, p)) {
+            std::cerr << "wait: " << spec << ": not a job or a child of this shell\n";
+            return 127;
+        }
+        ids.push_back(p.job_id);
+        targets.push_back({p});
+    }
+
+    if (any) {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            if (!anyStopped(targets[i])) continue;
+            std::cerr << "wait: " << specs[i] << ": job is stopped\n";
+            return kStoppedStatus;
+        }
+        int job = awaitAnyJob(ids);
+        if (job == 0) return 127;
+        std::vector<ProcessInfo> members = job_table().job(job);
+        if (members.empty()) return 127;
+        forget(members);
+        return members.back().exit_status;
+    }
+
+    if (specs.empty()) {
+        // Every background job; like sh, the status is 0
+        for (auto& members : allJobs()) {
+            if (!isListed(members)) continue;
+            if (anyStopped(members)) {
+                std::cerr << "wait: %" << members[0].job_id << ": job is stopped, not waiting for it\n";
+                continue;
+            }
+            for (const auto& p : members) awaitProcess(p);
+            forget(members);
+        }
+        return 0;
+    }
+
+    int status = 0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (anyStopped(targets[i])) {
+            // It stays a job: `fg` or `bg` can still continue it
+            std::cerr << "wait: " << specs[i] << ": job is stopped\n";
+            status = kStoppedStatus;
+            continue;
+        }
+        for (const auto& p : targets[i]) status = awaitProcess(p);
+        forget(targets[i]);
+    }
+    return status;
+}
@@ -0,0 +1,171 @@
+#include "../include/job_table.h"
+#include <algorithm>
+#include <cstdlib>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+int JobTable::add(proc_id pid, const std::string& name, bool background, int job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (job <= 0 || (size_t)job >= jobs.size() || jobs[job].empty()) {
+        // One more than the highest job still alive; trailing ids are trimmed on removal
+        if (jobs.empty()) jobs.resize(1);
+        job = (int)jobs.size();
+        jobs.emplace_back();
+    }
+
+    auto it = byPid.find(pid);
+    if (it != byPid.end()) {
+        // A recycled pid: whatever held it before is long gone
+        auto& old = jobs[it->second.job_id];
+        old.erase(std::find(old.begin(), old.end(), pid));
+    }
+    ProcessInfo& info = byPid[pid] = ProcessInfo{pid, job, ProcessStatus::Running, background, name};
+#ifdef _WIN32
+    info.ppid = GetCurrentProcessId();
+#else
+    info.ppid = getpid();
+#endif
+    info.started = std::chrono::system_clock::now();
+    jobs[job].push_back(pid);
+    return job;
+}
+
+bool JobTable::remove(proc_id pid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) return false;
+
+    auto& members = jobs[it->second.job_id];
+    members.erase(std::find(members.begin(), members.end(), pid));
+    byPid.erase(it);
+    while (jobs.size() > 1 && jobs.back().empty()) jobs.pop_back();
+    changed.notify_all();
+    return true;
+}
+
+bool JobTable::setStatus(proc_id pid, ProcessStatus status) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) return false;
+    it->second.status = status;
+    return true;
+}
+
+bool JobTable::setBackground(proc_id pid, bool background) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) return false;
+    it->second.is_background = background;
+    return true;
+}
+
+bool JobTable::setLimits(proc_id pid, const std::string& limits) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) return false;
+    it->second.limits = limits;
+    return true;
+}
+
+bool JobTable::finish(proc_id pid, int exitStatus, const ProcessUsage& usage) {
+    auto now = std::chrono::system_clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) return false;
+    it->second.status = ProcessStatus::Done;
+    it->second.exit_status = exitStatus;
+    it->second.ended = now;
+    it->second.usage = usage;
+    changed.notify_all();
+    return true;
+}
+
+bool JobTable::find(proc_id pid, ProcessInfo& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) return false;
+    out = it->second;
+    return true;
+}
+
+std::vector<ProcessInfo> JobTable::job(int id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<ProcessInfo> result;
+    if (id <= 0 || (size_t)id >= jobs.size()) return result;
+    for (proc_id pid : jobs[id]) result.push_back(byPid.at(pid));
+    return result;
+}
+
+std::vector<ProcessInfo> JobTable::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<ProcessInfo> result;
+    result.reserve(byPid.size());
+    for (const auto& members : jobs) {
+        for (proc_id pid : members) result.push_back(byPid.at(pid));
+    }
+    return result;
+}
+
+size_t JobTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return byPid.size();
+}
+
+void JobTable::waitDone(const std::vector<proc_id>& pids) const {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] {
+        for (proc_id pid : pids) {
+            auto it = byPid.find(pid);
+            if (it != byPid.end() && it->second.status != ProcessStatus::Done) return false;
+        }
+        return true;
+    });
+}
+
+int JobTable::waitAnyDone(const std::vector<int>& ids) const {
+    std::unique_lock<std::mutex> lock(mutex);
+    int found = 0;
+    changed.wait(lock, [&] {
+        bool pending = false;
+        auto check = [&](int id) {
+            if (id <= 0 || (size_t)id >= jobs.size() || jobs[id].empty()) return false;
+            bool background = !ids.empty(), done = true, stopped = false;
+            for (proc_id pid : jobs[id]) {
+                const ProcessInfo& p = byPid.at(pid);
+                background = background || p.is_background;
+                done = done && p.status == ProcessStatus::Done;
+                stopped = stopped || p.status == ProcessStatus::Suspended;
+            }
+            // A stopped job ends only after something continues it
+            if (!background || stopped) return false;
+            pending = true;
+            return done;
+        };
+        if (ids.empty()) {
+            for (int id = 1; (size_t)id < jobs.size() && !found; ++id) {
+                if (check(id)) found = id;
+            }
+        } else {
+            for (int id : ids) {
+                if (!found && check(id)) found = id;
+            }
+        }
+        return found != 0 || !pending;
+    });
+    return found;
+}
+
+JobTable& job_table() {
+    static JobTable table;
+    return table;
+}
+
+bool parse_job_spec(const std::string& spec, int& job) {
+    if (spec.size() < 2 || spec[0] != '%') return false;
+    char* end;
+    long n = std::strtol(spec.c_str() + 1, &end, 10);
+    if (*end != '\0' || n <= 0 || n > 1000000) return false;
+    job = (int)n;
+    return true;
+}
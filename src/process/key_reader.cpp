@@ -0,0 +1,54 @@
+#include "../include/key_reader.h"
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <conio.h>
+#include <io.h>
+#include <cstdio>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+KeyReader::KeyReader() {
+#ifndef _WIN32
+    active = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0;
+    if (active) {
+        termios raw = saved;
+        raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+#else
+    active = _isatty(_fileno(stdin)) != 0;
+#endif
+}
+
+KeyReader::~KeyReader() {
+#ifndef _WIN32
+    if (active) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+#endif
+}
+
+int KeyReader::next(std::chrono::steady_clock::time_point deadline) {
+    typedef std::chrono::steady_clock Clock;
+    if (!active) {
+        std::this_thread::sleep_until(deadline);
+        return kNone;
+    }
+#ifdef _WIN32
+    while (Clock::now() < deadline) {
+        if (_kbhit()) return _getch();
+        Sleep(20);
+    }
+    return kNone;
+#else
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    pollfd pfd{STDIN_FILENO, POLLIN, 0};
+    if (left <= 0 || poll(&pfd, 1, (int)left) <= 0) return kNone;
+    unsigned char c;
+    return read(STDIN_FILENO, &c, 1) == 1 ? c : kClosed;
+#endif
+}
@@ -0,0 +1,332 @@
+#include "../include/parallel.h"
+#include "../include/parser.h"
+#include "../include/process_launcher.h"
+#include "../include/process_manager.h"
+#include "../include/reaper.h"
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cerrno>
+#include <cstdio>
+#endif
+
+namespace {
+
+// Jobs are processes that mostly wait; more than this per CPU only costs
+// processes and pipes
+const size_t kMaxJobsPerCpu = 8;
+
+#ifdef _WIN32
+const char* const kNullDevice = "NUL";
+#else
+const char* const kNullDevice = "/dev/null";
+#endif
+
+struct Job {
+    size_t index = 0;            // position of its argument: output order
+    LaunchedProcess proc;
+    std::string output;
+    int status = -1;
+#ifdef _WIN32
+    std::thread reader;          // drains the job's stdout pipe
+#else
+    int outFd = -1;              // read end of the job's stdout, -1 at EOF
+    int pidFd = -1;              // readable once the job exits; -1 if unsupported
+    bool exited = false;
+#endif
+};
+
+// Writes each job's output once every job before it has been written
+class OrderedOutput {
+public:
+    explicit OrderedOutput(std::ostream& o) : out(o) {}
+
+    void finish(size_t index, std::string output) {
+        done[index] = std::move(output);
+        bool wrote = false;
+        for (auto it = done.begin(); it != done.end() && it->first == next; it = done.erase(it), ++next) {
+            out << it->second;
+            wrote = true;
+        }
+        if (wrote) out.flush();
+    }
+
+private:
+    std::ostream& out;
+    std::map<size_t, std::string> done;
+    size_t next = 0;
+};
+
+std::string joinArgs(const std::vector<std::string>& args) {
+    std::string result;
+    for (const auto& arg : args) {
+        if (!result.empty()) result += ' ';
+        result += arg;
+    }
+    return result;
+}
+
+Command buildCommand(const std::vector<std::string>& tmpl, const std::string& arg) {
+    Command cmd;
+    bool replaced = false;
+    for (const auto& token : tmpl) {
+        std::string t = token;
+        for (size_t pos = t.find("{}"); pos != std::string::npos; pos = t.find("{}", pos + arg.size())) {
+            t.replace(pos, 2, arg);
+            replaced = true;
+        }
+        cmd.argv.push_back(t);
+    }
+    if (!replaced) cmd.argv.push_back(arg);
+
+    // Jobs must not compete with `parallel` (or each other) for its stdin
+    cmd.infile = kNullDevice;
+    return cmd;
+}
+
+#ifndef _WIN32
+bool hasExited(pid_t pid) {
+    siginfo_t info{};
+    return waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid;
+}
+#endif
+
+class JobPool {
+public:
+    JobPool(const std::vector<std::string>& tmpl, const std::vector<std::string>& inputs, size_t slots, std::ostream& out)
+        : tmpl(tmpl), inputs(inputs), slots(slots), output(out) {}
+
+    int run() {
+        fill();
+        while (!running.empty()) {
+            waitForEvents();
+            fill();
+        }
+        return failed;
+    }
+
+private:
+    void fill() {
+        while (running.size() < slots && nextInput < inputs.size()) start(nextInput++);
+    }
+
+    void fail(size_t index) {
+        ++failed;
+        output.finish(index, "");
+    }
+
+    // The job is done: its output is complete and its status collected
+    void complete(std::list<Job>::iterator it) {
+        if (it->status != 0) ++failed;
+        removeProcess(it->proc.pid);
+        output.finish(it->index, std::move(it->output));
+        running.erase(it);
+    }
+
+#ifdef _WIN32
+    void start(size_t index) {
+        Command cmd = buildCommand(tmpl, inputs[index]);
+        HANDLE readEnd, writeEnd;
+        if (!CreatePipe(&readEnd, &writeEnd, nullptr, 0)) {
+            std::cerr << "parallel: failed to create pipe (Error code: " << GetLastError() << ")\n";
+            fail(index);
+            return;
+        }
+
+        running.emplace_back();
+        Job& job = running.back();
+        job.index = index;
+        bool ok = launcher.launch(cmd, kNoHandle, writeEnd, job.proc);
+        CloseHandle(writeEnd);
+        if (!ok) {
+            CloseHandle(readEnd);
+            running.pop_back();
+            fail(index);
+            return;
+        }
+        addProcess(job.proc.pid, joinArgs(cmd.argv), false);
+
+        Job* target = &job;
+        job.reader = std::thread([target, readEnd] {
+            char buf[64 * 1024];
+            DWORD got = 0;
+            while (ReadFile(readEnd, buf, sizeof(buf), &got, nullptr) && got > 0) target->output.append(buf, got);
+            CloseHandle(readEnd);
+        });
+    }
+
+    void waitForEvents() {
+        std::vector<HANDLE> handles;
+        std::vector<std::list<Job>::iterator> owners;
+        for (auto it = running.begin(); it != running.end(); ++it) {
+            handles.push_back(it->proc.hProcess);
+            owners.push_back(it);
+        }
+        DWORD r = WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, INFINITE);
+        if (r >= WAIT_OBJECT_0 + handles.size()) return;
+
+        auto it = owners[r - WAIT_OBJECT_0];
+        it->status = launcher.wait(it->proc);
+        it->reader.join();
+        launcher.release(it->proc);
+        complete(it);
+    }
+#else
+    void start(size_t index) {
+        Command cmd = buildCommand(tmpl, inputs[index]);
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0) {
+            perror("parallel: pipe");
+            fail(index);
+            return;
+        }
+
+        running.emplace_back();
+        Job& job = running.back();
+        job.index = index;
+        bool ok = launcher.launch(cmd, kNoHandle, fds[1], job.proc);
+        close(fds[1]);
+        if (!ok) {
+            close(fds[0]);
+            running.pop_back();
+            fail(index);
+            return;
+        }
+        job.outFd = fds[0];
+        job.pidFd = open_pidfd(job.proc.pid);
+        addProcess(job.proc.pid, joinArgs(cmd.argv), false);
+    }
+
+    // Sleep in poll() until some job has output or has exited. Exits are
+    // seen through pidfds; without them (kernels before 5.3) poll wakes up
+    // every few milliseconds to check.
+    void waitForEvents() {
+        std::vector<pollfd> fds;
+        std::vector<std::list<Job>::iterator> owners;
+        bool needTimer = false;
+        for (auto it = running.begin(); it != running.end(); ++it) {
+            if (it->outFd >= 0) {
+                fds.push_back({it->outFd, POLLIN, 0});
+                owners.push_back(it);
+            }
+            if (it->exited) continue;
+            if (it->pidFd >= 0) {
+                fds.push_back({it->pidFd, POLLIN, 0});
+                owners.push_back(it);
+            } else {
+                needTimer = true;
+            }
+        }
+
+        int n = poll(fds.data(), fds.size(), needTimer ? 10 : -1);
+        if (n < 0 && errno != EINTR) {
+            perror("parallel: poll");
+            return;
+        }
+
+        char buf[64 * 1024];
+        for (size_t i = 0; n > 0 && i < fds.size(); ++i) {
+            if (!fds[i].revents) continue;
+            Job& job = *owners[i];
+            if (fds[i].fd == job.outFd) {
+                ssize_t got = read(job.outFd, buf, sizeof(buf));
+                if (got > 0) {
+                    job.output.append(buf, got);
+                } else if (got == 0 || errno != EINTR) {
+                    close(job.outFd);
+                    job.outFd = -1;
+                }
+            } else {
+                reap(job);
+            }
+        }
+
+        for (auto it = running.begin(); it != running.end();) {
+            auto job = it++;
+            if (!job->exited && job->pidFd < 0 && hasExited(job->proc.pid)) reap(*job);
+            if (job->exited && job->outFd < 0) complete(job);
+        }
+    }
+
+    void reap(Job& job) {
+        job.status = launcher.wait(job.proc);   // already exited: does not block
+        job.exited = true;
+        if (job.pidFd >= 0) close(job.pidFd);
+        job.pidFd = -1;
+    }
+#endif
+
+    const std::vector<std::string>& tmpl;
+    const std::vector<std::string>& inputs;
+    size_t slots;
+    OrderedOutput output;
+    ProcessLauncher& launcher = default_launcher();
+    std::list<Job> running;
+    size_t nextInput = 0;
+    int failed = 0;
+};
+
+} // namespace
+
+int run_parallel(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
+    size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+    size_t slots = cpus;
+
+    size_t i = 1;
+    for (; i < args.size() && args[i].size() > 1 && args[i][0] == '-'; ++i) {
+        std::string value;
+        if (args[i] == "-j" && i + 1 < args.size()) value = args[++i];
+        else if (args[i].compare(0, 2, "-j") == 0) value = args[i].substr(2);
+        else {
+            std::cerr << "parallel: unknown option " << args[i] << "\n";
+            return 1;
+        }
+        // Digits only: stoul would take "-1" as the largest unsigned long
+        slots = value.empty() || value.size() > 9 || value.find_first_not_of("0123456789") != std::string::npos
+                    ? 0
+                    : std::stoul(value);
+        if (slots == 0) {
+            std::cerr << "parallel: -j needs a positive number\n";
+            return 1;
+        }
+        slots = std::min(slots, kMaxJobsPerCpu * cpus);
+    }
+#ifdef _WIN32
+    // WaitForMultipleObjects watches at most this many processes
+    if (slots > MAXIMUM_WAIT_OBJECTS) slots = MAXIMUM_WAIT_OBJECTS;
+#endif
+
+    std::vector<std::string> tmpl;
+    for (; i < args.size() && args[i] != ":::"; ++i) tmpl.push_back(args[i]);
+    if (tmpl.empty()) {
+        std::cerr << "Usage: parallel [-j N] command [args...] [::: arg...]\n";
+        return 1;
+    }
+
+    std::vector<std::string> inputs;
+    if (i < args.size()) {
+        inputs.assign(args.begin() + i + 1, args.end());
+    } else {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) inputs.push_back(line);
+        }
+    }
+
+    int failed = JobPool(tmpl, inputs, slots, out).run();
+    if (failed > 0) std::cerr << "parallel: " << failed << " of " << inputs.size() << " jobs failed\n";
+    return failed;
+}
@@ -1,60 +1,336 @@
 #include "../include/parser.h"
-#include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
 
-static std::vector<std::string> splitTokens(const std::string &s) {
-    std::vector<std::string> tokens;
-    bool inQuotes = false;
-    std::string token;
+// --- Arena ---
+
+void* Arena::allocate(size_t bytes, size_t align) {
+    uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(uintptr_t)(align - 1);
+    if (p + bytes > reinterpret_cast<uintptr_t>(end)) {
+        // Out of room: a new block at least twice the last one
+        size_t size = std::max(bytes + align, (blocks.empty() ? kInline : blocks.back().size) * 2);
+        blocks.push_back(Block{std::unique_ptr<char[]>(new char[size]), size});
+        cur = blocks.back().data.get();
+        end = cur + size;
+        p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    cur = reinterpret_cast<char*>(p + bytes);
+    return reinterpret_cast<void*>(p);
+}
+
+void Arena::reset() {
+    if (blocks.empty()) {
+        cur = inlineBuf;
+        end = inlineBuf + kInline;
+        return;
+    }
+    // The newest block is the largest; a script that once needed it will again
+    if (blocks.size() > 1) blocks.erase(blocks.begin(), blocks.end() - 1);
+    cur = blocks.back().data.get();
+    end = cur + blocks.back().size;
+}
+
+// --- Tokenizer ---
+
+static bool isSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+// Next whitespace-separated token of `s` starting at `pos`. Double quotes
+// group words and are dropped, so only a token that contained quotes is
+// copied (into the arena); every other token is a view of `s` itself.
+// Returns false at the end of `s`. With no arena the token is only measured.
+static bool nextToken(std::string_view s, size_t &pos, Arena *arena, std::string_view &token) {
+    while (pos < s.size() && isSpace(s[pos])) ++pos;
+    if (pos >= s.size()) return false;
 
-    for (size_t i = 0; i < s.size(); ++i) {
-        char c = s[i];
+    size_t start = pos;
+    size_t quotes = 0;
+    bool inQuotes = false;
+    for (; pos < s.size(); ++pos) {
+        char c = s[pos];
         if (c == '"') {
             inQuotes = !inQuotes;
-        } else if (std::isspace(static_cast<unsigned char>(c)) && !inQuotes) {
-            if (!token.empty()) {
-                tokens.push_back(token);
-                token.clear();
-            }
-        } else {
-            token.push_back(c);
+            ++quotes;
+        } else if (!inQuotes && isSpace(c)) {
+            break;
         }
     }
 
-    if (!token.empty()) {
-        tokens.push_back(token);
+    std::string_view raw = s.substr(start, pos - start);
+    if (quotes == 0 || !arena) {
+        token = raw.substr(0, raw.size() - quotes);
+        return true;
     }
 
-    return tokens;
+    char *out = arena->allocArray<char>(raw.size() - quotes);
+    size_t n = 0;
+    for (char c : raw) {
+        if (c != '"') out[n++] = c;
+    }
+    token = std::string_view(out, n);
+    return true;
 }
 
+static void parseStage(std::string_view text, Arena &arena, CommandView &cmd) {
+    // Size the token array first so argv is one allocation
+    size_t count = 0;
+    size_t pos = 0;
+    std::string_view token;
+    while (nextToken(text, pos, nullptr, token)) {
+        if (!token.empty()) ++count;
+    }
 
-Command parseCommand(const std::string &line) {
-    Command cmd;
-    auto tokens = splitTokens(line);
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        const std::string &t = tokens[i];
+    std::string_view *tokens = arena.allocArray<std::string_view>(count);
+    size_t n = 0;
+    pos = 0;
+    while (nextToken(text, pos, &arena, token)) {
+        // `""` on its own is no token at all
+        if (!token.empty()) tokens[n++] = token;
+    }
+
+    // Redirections are taken out of the same array, leaving argv in place
+    cmd = CommandView{};
+    cmd.argv = tokens;
+    for (size_t i = 0; i < n; ++i) {
+        std::string_view t = tokens[i];
 
-        if (t == "&" && i == tokens.size() - 1) {
+        if (t == "&" && i == n - 1) {
             cmd.background = true;
         }
-        else if (t == ">>" && i + 1 < tokens.size()) {
+        else if (t == ">>" && i + 1 < n) {
             cmd.outfile = tokens[++i];
             cmd.appendMode = true;
         }
-        else if (t == ">" && i + 1 < tokens.size()) {
+        else if (t == ">" && i + 1 < n) {
             cmd.outfile = tokens[++i];
             cmd.appendMode = false;
         }
-        else if (t == "<" && i + 1 < tokens.size()) {
+        else if (t == "<" && i + 1 < n) {
             cmd.infile = tokens[++i];
         }
         else {
-            cmd.argv.push_back(t);
+            tokens[cmd.argc++] = t;
         }
     }
+}
+
+// Where the stage starting at `start` ends: the next '|' that is not inside double quotes
+static size_t stageEnd(std::string_view line, size_t start) {
+    bool inQuotes = false;
+    for (size_t i = start; i < line.size(); ++i) {
+        if (line[i] == '"') inQuotes = !inQuotes;
+        else if (line[i] == '|' && !inQuotes) return i;
+    }
+    return line.size();
+}
+
+// Reports a syntax error on stderr, or hands it to the caller through `sink`
+static bool syntaxError(std::string *sink, const std::string &msg) {
+    if (sink) *sink = msg;
+    else std::cerr << "Syntax error: " << msg << "\n";
+    return false;
+}
+
+static bool parsePipelineView(std::string_view line, Arena &arena, PipelineView &out, std::string *errors) {
+    out = PipelineView{};
+
+    size_t count = 1;
+    for (size_t end = stageEnd(line, 0); end < line.size(); end = stageEnd(line, end + 1)) ++count;
+
+    CommandView *stages = arena.allocArray<CommandView>(count);
+    size_t start = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t end = stageEnd(line, start);
+        parseStage(line.substr(start, end - start), arena, stages[i]);
+        if (count > 1 && stages[i].argc == 0) {
+            // Stage such as "a | | b" or a trailing '|': nothing to run
+            return syntaxError(errors, "empty command in pipeline");
+        }
+        start = end + 1;
+    }
+
+    // Only a trailing '&' on the last stage backgrounds the whole pipeline
+    out.stages = stages;
+    out.count = count;
+    out.background = stages[count - 1].background;
+    for (size_t i = 0; i < count; ++i) stages[i].background = false;
+    return true;
+}
+
+bool parsePipelineView(std::string_view line, Arena &arena, PipelineView &out) {
+    return parsePipelineView(line, arena, out, nullptr);
+}
+
+// --- Owned commands ---
+
+Command toCommand(const CommandView &view) {
+    Command cmd;
+    cmd.argv.reserve(view.argc);
+    for (size_t i = 0; i < view.argc; ++i) cmd.argv.emplace_back(view.argv[i]);
+    cmd.background = view.background;
+    cmd.infile = std::string(view.infile);
+    cmd.outfile = std::string(view.outfile);
+    cmd.appendMode = view.appendMode;
     return cmd;
-}
\ No newline at end of file
+}
+
+Pipeline toPipeline(const PipelineView &view) {
+    Pipeline pl;
+    pl.stages.reserve(view.count);
+    for (size_t i = 0; i < view.count; ++i) pl.stages.push_back(toCommand(view.stages[i]));
+    pl.background = view.background;
+    return pl;
+}
+
+Command parseCommand(const std::string &line) {
+    Arena arena;
+    CommandView view;
+    parseStage(line, arena, view);
+    return toCommand(view);
+}
+
+Pipeline parsePipeline(const std::string &line) {
+    Arena arena;
+    PipelineView view;
+    if (!parsePipelineView(line, arena, view)) return Pipeline{};
+    return toPipeline(view);
+}
+
+// --- Command lists ---
+
+namespace {
+
+class ListParser {
+public:
+    ListParser(std::string_view line, Arena &arena, std::string *errors) : line(line), arena(arena), errors(errors) {}
+
+    bool parse(CommandList &out) {
+        return parseList(out, false);
+    }
+
+private:
+    std::string_view line;
+    Arena &arena;
+    std::string *errors;
+    size_t pos = 0;
+
+    void skipSpace() {
+        while (pos < line.size() && isSpace(line[pos])) ++pos;
+    }
+
+    bool startsWith(std::string_view op) const {
+        return line.substr(pos, op.size()) == op;
+    }
+
+    // '{' and '}' are only special as whole words where a command may start
+    bool atBrace(char brace) const {
+        if (pos >= line.size() || line[pos] != brace) return false;
+        if (pos + 1 == line.size() || isSpace(line[pos + 1])) return true;
+        char next = line[pos + 1];
+        return brace == '}' && (next == ';' || next == '&' || next == '|');
+    }
+
+    bool error(const std::string &msg) {
+        return syntaxError(errors, msg);
+    }
+
+    bool unexpected() {
+        if (pos >= line.size()) return error("unexpected end of line");
+        size_t n = (startsWith("&&") || startsWith("||")) ? 2 : 1;
+        return error("unexpected '" + std::string(line.substr(pos, n)) + "'");
+    }
+
+    // End of the pipeline starting at `pos`: the next ';', '&', '&&' or '||'
+    // outside quotes
+    size_t pipelineEnd() const {
+        bool inQuotes = false;
+        for (size_t i = pos; i < line.size(); ++i) {
+            char c = line[i];
+            if (c == '"') inQuotes = !inQuotes;
+            else if (inQuotes) continue;
+            else if (c == ';' || c == '&') return i;
+            else if (c == '|' && i + 1 < line.size() && line[i + 1] == '|') return i;
+        }
+        return line.size();
+    }
+
+    bool parseList(CommandList &out, bool inGroup) {
+        ListItem::Connector connector = ListItem::ALWAYS;
+        std::string_view op;
+        while (true) {
+            skipSpace();
+            bool end = pos >= line.size() || (inGroup && atBrace('}'));
+            if (end) {
+                // A trailing ';' is fine; a trailing '&&' or '||' is not
+                if (connector != ListItem::ALWAYS) return error("missing command after '" + std::string(op) + "'");
+                if (inGroup && out.items.empty()) return error("empty { } group");
+                return true;
+            }
+
+            ListItem item;
+            item.connector = connector;
+            if (!parseItem(item)) return false;
+
+            skipSpace();
+            // A lone '&' ends the item as ';' does, and runs it in the background
+            bool background = pos < line.size() && line[pos] == '&' && !startsWith("&&");
+            if (item.group && pos < line.size()) {
+                // Groups run inside the shell, on its own stdin and stdout
+                char c = line[pos];
+                if ((c == '|' && !startsWith("||")) || c == '<' || c == '>') {
+                    return error("a { } group cannot be piped or redirected");
+                }
+                if (background) return error("a { } group cannot run in the background");
+            }
+            if (background) item.pipeline.background = true;
+            out.items.push_back(std::move(item));
+            if (pos >= line.size() || (inGroup && atBrace('}'))) return true;
+
+            if (startsWith("&&")) connector = ListItem::IF_SUCCESS;
+            else if (startsWith("||")) connector = ListItem::IF_FAILURE;
+            else if (line[pos] == ';' || background) connector = ListItem::ALWAYS;
+            else return unexpected();
+            op = line.substr(pos, connector == ListItem::ALWAYS ? 1 : 2);
+            pos += op.size();
+            if (background) {
+                // `a &; b` was the only way to write this once; still take it
+                skipSpace();
+                if (pos < line.size() && line[pos] == ';') ++pos;
+            }
+        }
+    }
+
+    bool parseItem(ListItem &item) {
+        if (atBrace('{')) {
+            ++pos;
+            auto group = std::make_shared<CommandList>();
+            if (!parseList(*group, true)) return false;
+            if (!atBrace('}')) return error("missing '}' (a group ends with '; }')");
+            ++pos;
+            item.group = group;
+            return true;
+        }
+
+        char c = line[pos];
+        if (c == ';' || c == '&' || c == '|' || atBrace('}')) return unexpected();
+
+        size_t end = pipelineEnd();
+        PipelineView view;
+        if (!parsePipelineView(line.substr(pos, end - pos), arena, view, errors)) return false;
+        pos = end;
+        item.pipeline = toPipeline(view);
+        return true;
+    }
+};
+
+} // namespace
+
+bool parseCommandList(std::string_view line, Arena &arena, CommandList &out, std::string *errors) {
+    out = CommandList{};
+    return ListParser(line, arena, errors).parse(out);
+}
@@ -0,0 +1,206 @@
+#include "../include/path_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <cctype>
+static const char kPathSeparator = ';';
+#else
+#include <unistd.h>
+static const char kPathSeparator = ':';
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+const Clock::duration kRecheckInterval = std::chrono::seconds(1);
+
+struct DirState {
+    std::string path;
+    bool exists = false;
+#ifdef _WIN32
+    time_t mtime = 0;
+#else
+    struct timespec mtime = {0, 0};
+#endif
+};
+
+struct Entry {
+    std::string path;
+    size_t dirIndex;     // position in PATH where it was found
+    unsigned long hits;
+};
+
+std::mutex cacheMutex;
+bool loaded = false;
+std::string pathSnapshot;             // PATH the cache was built for
+std::vector<DirState> dirs;
+std::unordered_map<std::string, Entry> entries;
+Clock::time_point lastCheck;
+
+// Returns true when the directory looks different from last time
+bool refreshDir(DirState& dir) {
+    struct stat st;
+    bool exists = stat(dir.path.c_str(), &st) == 0;
+#ifdef _WIN32
+    time_t mtime = exists ? st.st_mtime : 0;
+    bool changed = exists != dir.exists || mtime != dir.mtime;
+#else
+    struct timespec mtime = exists ? st.st_mtim : timespec{0, 0};
+    bool changed = exists != dir.exists || mtime.tv_sec != dir.mtime.tv_sec ||
+                   mtime.tv_nsec != dir.mtime.tv_nsec;
+#endif
+    dir.exists = exists;
+    dir.mtime = mtime;
+    return changed;
+}
+
+void loadPath(const char* path) {
+    pathSnapshot = path ? path : "";
+    dirs.clear();
+    entries.clear();
+
+    size_t start = 0;
+    while (start <= pathSnapshot.size()) {
+        size_t end = pathSnapshot.find(kPathSeparator, start);
+        if (end == std::string::npos) end = pathSnapshot.size();
+        DirState dir;
+        dir.path = pathSnapshot.substr(start, end - start);
+        if (dir.path.empty()) dir.path = "."; // an empty PATH entry means the current directory
+        refreshDir(dir);
+        dirs.push_back(dir);
+        start = end + 1;
+    }
+    loaded = true;
+    lastCheck = Clock::now();
+}
+
+// Drop every entry that a change in dirs[i] could have shadowed or removed
+void recheckDirs() {
+    size_t firstChanged = dirs.size();
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        if (refreshDir(dirs[i]) && firstChanged == dirs.size()) firstChanged = i;
+    }
+    if (firstChanged == dirs.size()) return;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.dirIndex >= firstChanged) it = entries.erase(it); else ++it;
+    }
+}
+
+bool isAbsolute(const std::string& dir) {
+#ifdef _WIN32
+    return dir.size() >= 3 && std::isalpha((unsigned char)dir[0]) && dir[1] == ':' &&
+           (dir[2] == '\\' || dir[2] == '/');
+#else
+    return !dir.empty() && dir[0] == '/';
+#endif
+}
+
+bool isProgram(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+#ifdef _WIN32
+    return true;
+#else
+    return access(path.c_str(), X_OK) == 0;
+#endif
+}
+
+bool findIn(const DirState& dir, const std::string& name, std::string& found) {
+    if (!dir.exists) return false;
+#ifdef _WIN32
+    std::string base = dir.path;
+    if (base.back() != '\\' && base.back() != '/') base += '\\';
+    base += name;
+
+    // Same order CreateProcess uses: the name as given, then PATHEXT
+    if (name.find('.') != std::string::npos && isProgram(base)) {
+        found = base;
+        return true;
+    }
+    const char* pathext = std::getenv("PATHEXT");
+    std::string exts = pathext ? pathext : ".COM;.EXE;.BAT;.CMD";
+    size_t start = 0;
+    while (start < exts.size()) {
+        size_t end = exts.find(';', start);
+        if (end == std::string::npos) end = exts.size();
+        std::string candidate = base + exts.substr(start, end - start);
+        if (end > start && isProgram(candidate)) {
+            found = candidate;
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+#else
+    std::string candidate = dir.path;
+    if (candidate.back() != '/') candidate += '/';
+    candidate += name;
+    if (!isProgram(candidate)) return false;
+    found = candidate;
+    return true;
+#endif
+}
+
+} // namespace
+
+std::string resolve_command(const std::string& name) {
+    if (name.empty()) return "";
+#ifdef _WIN32
+    if (name.find_first_of("\\/:") != std::string::npos) return name;
+#else
+    if (name.find('/') != std::string::npos) return name;
+#endif
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    const char* path = std::getenv("PATH");
+    if (!loaded || pathSnapshot != (path ? path : "")) loadPath(path);
+
+    Clock::time_point now = Clock::now();
+    if (now - lastCheck >= kRecheckInterval) {
+        recheckDirs();
+        lastCheck = now;
+    }
+
+    auto it = entries.find(name);
+    if (it != entries.end()) {
+        ++it->second.hits;
+        return it->second.path;
+    }
+
+    std::string found;
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        if (!findIn(dirs[i], name, found)) continue;
+        // Relative PATH entries depend on the current directory; never remember them
+        if (isAbsolute(dirs[i].path)) entries[name] = Entry{found, i, 1};
+        return found;
+    }
+    return "";
+}
+
+void path_cache_forget(const std::string& name) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    entries.erase(name);
+}
+
+void path_cache_clear() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    loaded = false;
+    dirs.clear();
+    entries.clear();
+}
+
+std::vector<PathCacheEntry> path_cache_entries() {
+    std::vector<PathCacheEntry> list;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (const auto& e : entries) list.push_back({e.first, e.second.path, e.second.hits});
+    }
+    std::sort(list.begin(), list.end(),
+              [](const PathCacheEntry& a, const PathCacheEntry& b) { return a.name < b.name; });
+    return list;
+}
@@ -0,0 +1,273 @@
+#include "../include/proc_monitor.h"
+
+#ifndef _WIN32
+
+#include "../include/proc_snapshot.h"
+#include "../include/reaper.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const auto kMinScanInterval = std::chrono::milliseconds(10);
+const auto kMaxScanInterval = std::chrono::milliseconds(1000);
+const auto kStopCheck = std::chrono::milliseconds(200);
+
+ProcEvent makeEvent(ProcEvent::Type type, proc_id pid) {
+    ProcEvent e;
+    e.type = type;
+    e.pid = pid;
+    e.when = std::chrono::system_clock::now();
+    return e;
+}
+
+#ifdef __linux__
+std::string readComm(proc_id pid) {
+    char path[32], buf[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/comm", (int)pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::string();
+    ssize_t n = read(fd, buf, sizeof(buf));
+    close(fd);
+    while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == '\0')) --n;
+    return n > 0 ? std::string(buf, n) : std::string();
+}
+#endif
+
+} // namespace
+
+const char* proc_monitor_backend_name(ProcMonitorBackend backend) {
+    switch (backend) {
+        case ProcMonitorBackend::Netlink: return "netlink proc connector";
+        case ProcMonitorBackend::ProcScan: return "/proc scan";
+        default: return "auto";
+    }
+}
+
+ProcMonitor::~ProcMonitor() {
+    if (sock >= 0) {
+        subscribe(false);
+        close(sock);
+    }
+}
+
+bool ProcMonitor::open(ProcMonitorBackend want) {
+    if (want != ProcMonitorBackend::ProcScan && openNetlink(want == ProcMonitorBackend::Auto)) {
+        active = ProcMonitorBackend::Netlink;
+        return true;
+    }
+    if (want == ProcMonitorBackend::Netlink) return false;
+    if (access("/proc/self/stat", R_OK) != 0) {
+        perror("monitor: /proc");
+        return false;
+    }
+    active = ProcMonitorBackend::ProcScan;
+    return true;
+}
+
+bool ProcMonitor::openNetlink(bool quiet) {
+#ifdef __linux__
+    sock = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (sock < 0) {
+        if (!quiet) perror("monitor: netlink socket");
+        return false;
+    }
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    if (bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0 || !subscribe(true)) {
+        // EPERM without CAP_NET_ADMIN
+        if (!quiet) perror("monitor: proc connector");
+        close(sock);
+        sock = -1;
+        return false;
+    }
+    // A fork storm outruns the default buffer; the forced size needs privilege
+    int size = 8 << 20;
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0) {
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    return true;
+#else
+    if (!quiet) std::fprintf(stderr, "monitor: the proc connector needs Linux\n");
+    return false;
+#endif
+}
+
+bool ProcMonitor::subscribe(bool listen) {
+#ifdef __linux__
+    alignas(nlmsghdr) char buf[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+    nlmsghdr* header = (nlmsghdr*)buf;
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+    header->nlmsg_pid = getpid();
+    cn_msg* msg = (cn_msg*)NLMSG_DATA(header);
+    msg->id.idx = CN_IDX_PROC;
+    msg->id.val = CN_VAL_PROC;
+    msg->len = sizeof(proc_cn_mcast_op);
+    proc_cn_mcast_op op = listen ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE;
+    std::memcpy(msg->data, &op, sizeof(op));
+    return send(sock, header, header->nlmsg_len, 0) == (ssize_t)header->nlmsg_len;
+#else
+    (void)listen;
+    return false;
+#endif
+}
+
+void ProcMonitor::run(const std::atomic<bool>& running, const Sink& sink) {
+    if (active == ProcMonitorBackend::Netlink) runNetlink(running, sink);
+    else if (active == ProcMonitorBackend::ProcScan) runScan(running, sink);
+}
+
+void ProcMonitor::runNetlink(const std::atomic<bool>& running, const Sink& sink) {
+#ifdef __linux__
+    // Processes that were already there, so that their exits have names
+    names.clear();
+    for (const auto& p : take_proc_snapshot()) names.emplace(p.pid, p.name);
+
+    alignas(nlmsghdr) char buf[16384];
+    while (running) {
+        pollfd pfd{sock, POLLIN, 0};
+        if (poll(&pfd, 1, (int)kStopCheck.count()) <= 0) continue;
+        ssize_t got = recv(sock, buf, sizeof(buf), 0);
+        if (got < 0) {
+            if (errno == ENOBUFS) ++overruns;   // events were dropped; carry on
+            continue;
+        }
+
+        int len = (int)got;
+        for (nlmsghdr* header = (nlmsghdr*)buf; NLMSG_OK(header, len); header = NLMSG_NEXT(header, len)) {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) continue;
+            cn_msg* msg = (cn_msg*)NLMSG_DATA(header);
+            if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC) continue;
+            const proc_event* ev = (const proc_event*)msg->data;
+
+            switch (ev->what) {
+                case proc_event::PROC_EVENT_FORK: {
+                    const auto& fork = ev->event_data.fork;
+                    if (fork.child_pid != fork.child_tgid) break;   // a new thread
+                    ProcEvent e = makeEvent(ProcEvent::Fork, fork.child_tgid);
+                    e.ppid = fork.parent_tgid;
+                    auto parent = names.find(e.ppid);
+                    if (parent != names.end()) e.name = parent->second;   // a fork runs its parent's image
+                    names[e.pid] = e.name;
+                    sink(e);
+                    break;
+                }
+                case proc_event::PROC_EVENT_EXEC: {
+                    ProcEvent e = makeEvent(ProcEvent::Exec, ev->event_data.exec.process_tgid);
+                    e.name = readComm(e.pid);
+                    names[e.pid] = e.name;
+                    sink(e);
+                    break;
+                }
+                case proc_event::PROC_EVENT_COMM: {
+                    const auto& comm = ev->event_data.comm;
+                    if (comm.process_pid == comm.process_tgid) names[comm.process_tgid] = comm.comm;
+                    break;
+                }
+                case proc_event::PROC_EVENT_EXIT: {
+                    const auto& exit = ev->event_data.exit;
+                    if (exit.process_pid != exit.process_tgid) break;
+                    ProcEvent e = makeEvent(ProcEvent::Exit, exit.process_tgid);
+                    e.exit_code = exit_status_of((int)exit.exit_code);
+                    auto known = names.find(e.pid);
+                    if (known != names.end()) {
+                        e.name = std::move(known->second);
+                        names.erase(known);
+                    }
+                    sink(e);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+#else
+    (void)running;
+    (void)sink;
+#endif
+}
+
+void ProcMonitor::runScan(const std::atomic<bool>& running, const Sink& sink) {
+    struct Seen {
+        uint64_t start_ticks;
+        std::string name;
+    };
+    SnapshotOptions options;
+    options.threads = 1;   // this runs all the time; keep it to one core
+
+    std::unordered_map<proc_id, Seen> before;
+    for (auto& p : take_proc_snapshot(options)) before.emplace(p.pid, Seen{p.start_ticks, std::move(p.name)});
+
+    Clock::duration interval = kMaxScanInterval;
+    while (running) {
+        auto wake = Clock::now() + interval;
+        while (running && Clock::now() < wake) {
+            std::this_thread::sleep_for(std::min<Clock::duration>(kStopCheck, wake - Clock::now()));
+        }
+        if (!running) break;
+
+        auto scanStart = Clock::now();
+        std::vector<ProcSample> procs = take_proc_snapshot(options);
+        Clock::duration cost = Clock::now() - scanStart;
+
+        std::unordered_map<proc_id, Seen> now;
+        now.reserve(procs.size());
+        size_t changes = 0;
+        for (auto& p : procs) {
+            auto old = before.find(p.pid);
+            // A pid with a new start time was reused: the old one ended first
+            bool reused = old != before.end() && old->second.start_ticks != p.start_ticks;
+            if (reused) {
+                ProcEvent e = makeEvent(ProcEvent::Exit, p.pid);
+                e.name = old->second.name;
+                sink(e);
+            }
+            if (old == before.end() || reused) {
+                ProcEvent e = makeEvent(ProcEvent::Fork, p.pid);
+                e.ppid = p.ppid;
+                e.name = p.name;
+                sink(e);
+                ++changes;
+            } else if (old->second.name != p.name) {
+                ProcEvent e = makeEvent(ProcEvent::Exec, p.pid);
+                e.name = p.name;
+                sink(e);
+                ++changes;
+            }
+            if (old != before.end()) before.erase(old);
+            now.emplace(p.pid, Seen{p.start_ticks, std::move(p.name)});
+        }
+        // What is left was not seen this time
+        for (auto& gone : before) {
+            ProcEvent e = makeEvent(ProcEvent::Exit, gone.first);
+            e.name = std::move(gone.second.name);
+            sink(e);
+            ++changes;
+        }
+        before.swap(now);
+
+        interval = changes ? interval / 2 : interval * 2;
+        interval = std::max<Clock::duration>(interval, std::max<Clock::duration>(kMinScanInterval, cost * 10));
+        interval = std::min<Clock::duration>(interval, kMaxScanInterval);
+    }
+}
+
+#endif
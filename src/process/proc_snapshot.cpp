@@ -0,0 +1,282 @@
+#include "../include/proc_snapshot.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <tlhelp32.h>
+#include <psapi.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+namespace {
+
+uint64_t fileTimeTicks(const FILETIME& t) {
+    return (uint64_t)t.dwHighDateTime << 32 | t.dwLowDateTime;
+}
+
+std::string utf8(const wchar_t* text) {
+    int len = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    std::string out(len > 0 ? len - 1 : 0, '\0');
+    if (len > 1) WideCharToMultiByte(CP_UTF8, 0, text, -1, &out[0], len, nullptr, nullptr);
+    return out;
+}
+
+} // namespace
+
+// Command lines live in each process's PEB and are not read here
+std::vector<ProcSample> take_proc_snapshot(const SnapshotOptions&) {
+    std::vector<ProcSample> result;
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return result;
+
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    uint64_t boot = fileTimeTicks(now) - proc_uptime_ticks();
+
+    PROCESSENTRY32W pe;
+    pe.dwSize = sizeof(pe);
+    for (BOOL ok = Process32FirstW(snapshot, &pe); ok; ok = Process32NextW(snapshot, &pe)) {
+        ProcSample s;
+        s.pid = pe.th32ProcessID;
+        s.ppid = pe.th32ParentProcessID;
+        s.state = 'R';
+        s.threads = (int)pe.cntThreads;
+        s.name = utf8(pe.szExeFile);
+
+        HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pe.th32ProcessID);
+        if (h) {
+            FILETIME created, exited, kernel, user;
+            if (GetProcessTimes(h, &created, &exited, &kernel, &user)) {
+                s.cpu_ticks = fileTimeTicks(kernel) + fileTimeTicks(user);
+                uint64_t c = fileTimeTicks(created);
+                s.start_ticks = c > boot ? c - boot : 0;
+            }
+            PROCESS_MEMORY_COUNTERS mem;
+            if (GetProcessMemoryInfo(h, &mem, sizeof(mem))) {
+                s.rss_kb = mem.WorkingSetSize / 1024;
+                s.vsize_kb = mem.PagefileUsage / 1024;
+            }
+            CloseHandle(h);
+        }
+        result.push_back(std::move(s));
+    }
+    CloseHandle(snapshot);
+
+    std::sort(result.begin(), result.end(), [](const ProcSample& a, const ProcSample& b) { return a.pid < b.pid; });
+    return result;
+}
+
+uint64_t proc_ticks_per_second() {
+    return 10000000;   // FILETIME: 100 ns units
+}
+
+uint64_t proc_uptime_ticks() {
+    return GetTickCount64() * 10000;
+}
+
+uint64_t proc_total_memory_kb() {
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? status.ullTotalPhys / 1024 : 0;
+}
+
+#else
+
+namespace {
+
+const size_t kBufferSize = 4096;   // /proc/<pid>/stat is well under 1 KiB; longer command lines are cut
+
+// Reads a /proc file relative to the open /proc directory; -1 if it is gone
+ssize_t readAt(int procFd, const char* path, char* buf, size_t size) {
+    int fd = openat(procFd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    size_t total = 0;
+    ssize_t n;
+    while (total + 1 < size && (n = read(fd, buf + total, size - 1 - total)) > 0) total += n;
+    close(fd);
+    buf[total] = '\0';
+    return (ssize_t)total;
+}
+
+// Fields of /proc/<pid>/stat after the name, numbered as in proc(5)
+bool parseStat(char* buf, ssize_t len, ProcSample& s, uint64_t pageKb) {
+    char* open = std::strchr(buf, '(');
+    char* close = std::strrchr(buf, ')');   // the name itself may contain ')'
+    if (!open || !close || close < open || close + 2 >= buf + len) return false;
+    s.name.assign(open + 1, close - open - 1);
+
+    char* p = close + 2;
+    s.state = *p;
+    p += 1;
+    uint64_t utime = 0;
+    for (int field = 4; field <= 24; ++field) {
+        uint64_t value = std::strtoull(p, &p, 10);
+        switch (field) {
+            case 4:  s.ppid = (proc_id)value; break;
+            case 14: utime = value; break;
+            case 15: s.cpu_ticks = utime + value; break;
+            case 20: s.threads = (int)value; break;
+            case 22: s.start_ticks = value; break;
+            case 23: s.vsize_kb = value / 1024; break;
+            case 24: s.rss_kb = value * pageKb; break;
+        }
+    }
+    return true;
+}
+
+bool readProcess(int procFd, proc_id pid, bool cmdline, char* buf, uint64_t pageKb, ProcSample& s) {
+    char path[32];
+    std::snprintf(path, sizeof(path), "%d/stat", (int)pid);
+    ssize_t len = readAt(procFd, path, buf, kBufferSize);
+    if (len <= 0 || !parseStat(buf, len, s, pageKb)) return false;
+    s.pid = pid;
+
+    if (cmdline) {
+        std::snprintf(path, sizeof(path), "%d/cmdline", (int)pid);
+        len = readAt(procFd, path, buf, kBufferSize);
+        while (len > 0 && buf[len - 1] == '\0') --len;
+        for (ssize_t i = 0; i < len; ++i) {
+            if ((unsigned char)buf[i] < ' ') buf[i] = ' ';   // argument separators, stray newlines
+        }
+        if (len > 0) s.cmdline.assign(buf, len);
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<ProcSample> take_proc_snapshot(const SnapshotOptions& options) {
+    std::vector<ProcSample> result;
+    int procFd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procFd < 0) return result;
+
+    // fdopendir takes over a duplicate; procFd stays ours for the openat()s
+    std::vector<proc_id> pids;
+    if (DIR* dir = fdopendir(fcntl(procFd, F_DUPFD_CLOEXEC, 0))) {
+        while (struct dirent* entry = readdir(dir)) {
+            char* end;
+            long pid = std::strtol(entry->d_name, &end, 10);
+            if (*end == '\0' && pid > 0) pids.push_back((proc_id)pid);
+        }
+        closedir(dir);
+    }
+    std::sort(pids.begin(), pids.end());
+
+    size_t readers = options.threads;
+    if (readers == 0) {
+        size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+        readers = std::min(cpus, (pids.size() + kSnapshotChunk - 1) / kSnapshotChunk);
+    }
+    readers = std::max<size_t>(1, std::min(readers, pids.size()));
+
+    // Each reader fills its own slice of `result` with its own buffer
+    result.resize(pids.size());
+    uint64_t pageKb = sysconf(_SC_PAGESIZE) / 1024;
+    auto readSlice = [&](size_t begin, size_t end) {
+        char buf[kBufferSize];
+        for (size_t i = begin; i < end; ++i) {
+            if (!readProcess(procFd, pids[i], options.cmdline, buf, pageKb, result[i])) result[i].pid = 0;
+        }
+    };
+    std::vector<std::thread> threads;
+    size_t per = (pids.size() + readers - 1) / std::max<size_t>(readers, 1);
+    for (size_t begin = per; begin < pids.size(); begin += per) {
+        threads.emplace_back(readSlice, begin, std::min(begin + per, pids.size()));
+    }
+    readSlice(0, std::min(per, pids.size()));
+    for (auto& t : threads) t.join();
+    close(procFd);
+
+    // Exited between the directory walk and the read
+    result.erase(std::remove_if(result.begin(), result.end(), [](const ProcSample& s) { return s.pid == 0; }),
+                 result.end());
+    return result;
+}
+
+uint64_t proc_ticks_per_second() {
+    static const uint64_t ticks = sysconf(_SC_CLK_TCK);
+    return ticks;
+}
+
+uint64_t proc_uptime_ticks() {
+    double seconds = 0;
+    if (FILE* f = std::fopen("/proc/uptime", "r")) {
+        if (std::fscanf(f, "%lf", &seconds) != 1) seconds = 0;
+        std::fclose(f);
+    }
+    return (uint64_t)(seconds * proc_ticks_per_second());
+}
+
+uint64_t proc_total_memory_kb() {
+    return (uint64_t)sysconf(_SC_PHYS_PAGES) * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+#endif
+
+bool wildcard_match(const char* pattern, const char* text) {
+    // Greedy with one backtrack point: the last '*' seen
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*text) {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = text;
+        } else if (*pattern == '?' || *pattern == *text) {
+            ++pattern;
+            ++text;
+        } else if (star) {
+            pattern = star + 1;
+            text = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') ++pattern;
+    return *pattern == '\0';
+}
+
+bool parse_list_options(const std::vector<std::string>& args, ListOptions& options) {
+    options = ListOptions();
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& opt = args[i];
+        if (i + 1 >= args.size() || (opt != "--sort" && opt != "--filter" && opt != "--top")) {
+            std::cerr << "Usage: list [--sort pid|cpu|mem] [--filter name=PATTERN] [--top N]\n";
+            return false;
+        }
+        const std::string& value = args[++i];
+        if (opt == "--sort") {
+            if (value == "pid") options.sort = ListOptions::BY_PID;
+            else if (value == "cpu") options.sort = ListOptions::BY_CPU;
+            else if (value == "mem") options.sort = ListOptions::BY_MEM;
+            else {
+                std::cerr << "list: unknown sort key '" << value << "' (use pid, cpu or mem)\n";
+                return false;
+            }
+        } else if (opt == "--filter") {
+            if (value.compare(0, 5, "name=") != 0) {
+                std::cerr << "list: unknown filter '" << value << "' (use name=PATTERN)\n";
+                return false;
+            }
+            options.name = value.substr(5);
+        } else {
+            char* end;
+            long n = std::strtol(value.c_str(), &end, 10);
+            if (*end != '\0' || n <= 0) {
+                std::cerr << "list: --top needs a positive number\n";
+                return false;
+            }
+            options.top = (size_t)n;
+        }
+    }
+    return true;
+}
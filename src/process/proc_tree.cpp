@@ -0,0 +1,76 @@
+#include "../include/proc_tree.h"
+
+ProcTree::ProcTree(std::vector<ProcSample> snapshot) : procs(std::move(snapshot)) {
+    int n = (int)procs.size();
+    byPid.reserve(n);
+    for (int i = 0; i < n; ++i) byPid.emplace(procs[i].pid, i);
+
+    // Count each parent's children, turn the counts into offsets, then drop
+    // every process into its parent's run. The snapshot is ordered by pid,
+    // so each run is too.
+    parent.assign(n, -1);
+    first.assign(n + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        auto it = byPid.find(procs[i].ppid);
+        // pid 0 on Windows names itself as its parent
+        if (it != byPid.end() && it->second != i) {
+            parent[i] = it->second;
+            ++first[it->second + 1];
+        }
+    }
+    for (int i = 0; i < n; ++i) first[i + 1] += first[i];
+    children.resize(first[n]);
+    std::vector<int> fill(first.begin(), first.end() - 1);
+    for (int i = 0; i < n; ++i) {
+        if (parent[i] >= 0) children[fill[parent[i]]++] = i;
+    }
+    children.push_back(-1);   // childrenBegin() of the last run may point one past the end
+}
+
+int ProcTree::find(proc_id pid) const {
+    auto it = byPid.find(pid);
+    return it == byPid.end() ? -1 : it->second;
+}
+
+std::vector<proc_id> ProcTree::subtree(proc_id root) const {
+    std::vector<proc_id> pids;
+    int start = find(root);
+    if (start < 0) return pids;
+
+    // Breadth first over the flat child runs; `seen` guards against a
+    // parent link loop from a recycled pid on Windows
+    std::vector<bool> seen(procs.size());
+    std::vector<int> queue{start};
+    seen[start] = true;
+    for (size_t next = 0; next < queue.size(); ++next) {
+        int i = queue[next];
+        pids.push_back(procs[i].pid);
+        for (const int* c = childrenBegin(i); c != childrenEnd(i); ++c) {
+            if (!seen[*c]) {
+                seen[*c] = true;
+                queue.push_back(*c);
+            }
+        }
+    }
+    return pids;
+}
+
+void ProcTree::print(proc_id root, std::ostream& out) const {
+    int start = find(root);
+    if (start < 0) return;
+    std::vector<bool> seen(procs.size());
+    seen[start] = true;
+    out << procs[start].pid << " " << procs[start].name << "\n";
+    printBranch(start, "", seen, out);
+}
+
+void ProcTree::printBranch(int index, const std::string& prefix, std::vector<bool>& seen, std::ostream& out) const {
+    for (const int* c = childrenBegin(index); c != childrenEnd(index); ++c) {
+        if (seen[*c]) continue;
+        seen[*c] = true;
+        bool last = c + 1 == childrenEnd(index);
+        const ProcSample& p = procs[*c];
+        out << prefix << (last ? "`-- " : "|-- ") << p.pid << " " << p.name << "\n";
+        printBranch(*c, prefix + (last ? "    " : "|   "), seen, out);
+    }
+}
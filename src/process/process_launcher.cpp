@@ -0,0 +1,443 @@
+#include "../include/process_launcher.h"
+#include "../include/path_cache.h"
+#include "../include/resource_limits.h"
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <cctype>
+#else
+#include <spawn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <cerrno>
+
+#ifndef CLOSE_RANGE_CLOEXEC
+#define CLOSE_RANGE_CLOEXEC (1U << 2)
+#endif
+
+extern char **environ;
+#endif
+
+#ifdef _WIN32
+
+// Quote arguments with spaces and convert the whole line to UTF-16 in one
+// call, instead of one MultiByteToWideChar round trip per argument.
+static std::wstring buildCommandLine(const std::vector<std::string>& args) {
+    std::string line;
+    for (const auto& arg : args) {
+        if (!line.empty()) line += ' ';
+        if (arg.find(' ') != std::string::npos) {
+            line += '"' + arg + '"';
+        } else {
+            line += arg;
+        }
+    }
+    int len = MultiByteToWideChar(CP_UTF8, 0, line.c_str(), (int)line.size(), NULL, 0);
+    std::wstring wline(len, 0);
+    MultiByteToWideChar(CP_UTF8, 0, line.c_str(), (int)line.size(), &wline[0], len);
+    return wline;
+}
+
+static std::wstring toWide(const std::string& s) {
+    int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), nullptr, 0);
+    std::wstring w(len, 0);
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), &w[0], len);
+    return w;
+}
+
+static HANDLE inheritable(HANDLE h) {
+    HANDLE dup = INVALID_HANDLE_VALUE;
+    DuplicateHandle(GetCurrentProcess(), h, GetCurrentProcess(), &dup, 0, TRUE, DUPLICATE_SAME_ACCESS);
+    return dup;
+}
+
+class CreateProcessLauncher : public ProcessLauncher {
+public:
+    bool launch(const Command& cmd, os_handle in, os_handle out, LaunchedProcess& proc) override {
+        SECURITY_ATTRIBUTES sa{};
+        sa.nLength = sizeof(sa);
+        sa.bInheritHandle = TRUE;
+
+        // Every handle the child sees is an inheritable duplicate made for it
+        // alone; the shell's own pipe ends stay non-inheritable.
+        STARTUPINFOW si{};
+        si.cb = sizeof(si);
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput  = inheritable(in != kNoHandle ? in : GetStdHandle(STD_INPUT_HANDLE));
+        si.hStdOutput = inheritable(out != kNoHandle ? out : GetStdHandle(STD_OUTPUT_HANDLE));
+        si.hStdError  = inheritable(GetStdHandle(STD_ERROR_HANDLE));
+
+        if (!cmd.infile.empty()) {
+            HANDLE hIn = CreateFileW(toWide(cmd.infile).c_str(), GENERIC_READ, FILE_SHARE_READ, &sa,
+                                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (hIn == INVALID_HANDLE_VALUE) {
+                std::cerr << "Error opening input file: " << cmd.infile << "\n";
+            } else {
+                CloseHandle(si.hStdInput);
+                si.hStdInput = hIn;
+            }
+        }
+        if (!cmd.outfile.empty()) {
+            HANDLE hOut = CreateFileW(toWide(cmd.outfile).c_str(),
+                                      cmd.appendMode ? FILE_APPEND_DATA : GENERIC_WRITE,
+                                      FILE_SHARE_READ | FILE_SHARE_WRITE, &sa,
+                                      cmd.appendMode ? OPEN_ALWAYS : CREATE_ALWAYS,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (hOut == INVALID_HANDLE_VALUE) {
+                std::cerr << "Error opening output file: " << cmd.outfile << "\n";
+            } else {
+                if (cmd.appendMode) SetFilePointer(hOut, 0, NULL, FILE_END);
+                CloseHandle(si.hStdOutput);
+                CloseHandle(si.hStdError);
+                si.hStdOutput = hOut;
+                si.hStdError = inheritable(hOut);
+            }
+        }
+
+        // Hand CreateProcess the hashed path of .exe/.com programs so it does
+        // not search PATH again; scripts still go through its own lookup
+        std::string program = resolve_command(cmd.argv[0]);
+        std::wstring application;
+        if (program.size() > 4) {
+            std::string ext = program.substr(program.size() - 4);
+            for (auto& c : ext) c = (char)tolower((unsigned char)c);
+            if (ext == ".exe" || ext == ".com") application = toWide(program);
+        }
+
+        proc.cmdline = buildCommandLine(cmd.argv);
+        PROCESS_INFORMATION pi{};
+        // `run` limits go on before the first instruction: start it suspended
+        DWORD flags = cmd.limits ? CREATE_SUSPENDED : 0;
+        BOOL ok = CreateProcessW(application.empty() ? nullptr : application.c_str(), &proc.cmdline[0],
+                                 nullptr, nullptr, TRUE, flags, nullptr, nullptr, &si, &pi);
+
+        // The child owns its copies now; keeping them open would block EOF
+        CloseHandle(si.hStdInput);
+        CloseHandle(si.hStdOutput);
+        CloseHandle(si.hStdError);
+
+        if (!ok) {
+            if (!application.empty()) path_cache_forget(cmd.argv[0]);
+            std::wcerr << L"Failed to start process: " << proc.cmdline << L"\n";
+            return false;
+        }
+        if (cmd.limits) {
+            if (!apply_resource_limits(pi.hProcess, *cmd.limits)) {
+                TerminateProcess(pi.hProcess, 1);
+                CloseHandle(pi.hThread);
+                CloseHandle(pi.hProcess);
+                return false;
+            }
+            ResumeThread(pi.hThread);
+        }
+        proc.pid = pi.dwProcessId;
+        proc.hProcess = pi.hProcess;
+        proc.hThread = pi.hThread;
+        return true;
+    }
+
+    int wait(LaunchedProcess& proc) override {
+        if (!proc.hProcess) return -1;
+        WaitForSingleObject(proc.hProcess, INFINITE);
+        DWORD code = 0;
+        if (!GetExitCodeProcess(proc.hProcess, &code)) return -1;
+        return (int)code;
+    }
+
+    void release(LaunchedProcess& proc) override {
+        if (proc.hThread) CloseHandle(proc.hThread);
+        if (proc.hProcess) CloseHandle(proc.hProcess);
+        proc.hThread = proc.hProcess = NULL;
+    }
+};
+
+ProcessLauncher& default_launcher() {
+    static CreateProcessLauncher launcher;
+    return launcher;
+}
+
+#else // POSIX
+
+// argv as one allocation: the pointer array followed by the strings it
+// points into, so a launch costs a single malloc however many arguments.
+class PackedArgv {
+public:
+    explicit PackedArgv(const std::vector<std::string>& args) {
+        size_t pointers = (args.size() + 1) * sizeof(char*);
+        size_t bytes = pointers;
+        for (const auto& arg : args) bytes += arg.size() + 1;
+
+        block.reset(new char[bytes]);
+        char** argv = reinterpret_cast<char**>(block.get());
+        char* text = block.get() + pointers;
+        for (size_t i = 0; i < args.size(); ++i) {
+            argv[i] = text;
+            std::memcpy(text, args[i].c_str(), args[i].size() + 1);
+            text += args[i].size() + 1;
+        }
+        argv[args.size()] = nullptr;
+    }
+
+    char* const* get() const { return reinterpret_cast<char* const*>(block.get()); }
+
+private:
+    std::unique_ptr<char[]> block;
+};
+
+// The '<' and '>' files of a command, opened by the shell itself before
+// anything is started: a missing file is reported by name, and an ENOENT
+// from the launch can only mean the program. Close-on-exec, so only the
+// child's copies on stdin/stdout outlive the exec.
+struct Redirections {
+    int in = -1;
+    int out = -1;
+
+    Redirections() = default;
+    Redirections(const Redirections&) = delete;
+    Redirections& operator=(const Redirections&) = delete;
+
+    ~Redirections() {
+        if (in >= 0) close(in);
+        if (out >= 0) close(out);
+    }
+
+    // false (after printing why) at the first file that cannot be opened; as
+    // in sh, a failed '<' leaves the '>' file untouched
+    bool open(const Command& cmd) {
+        if (!cmd.infile.empty()) {
+            in = ::open(cmd.infile.c_str(), O_RDONLY | O_CLOEXEC);
+            if (in < 0) {
+                std::cerr << "Error opening input file: " << cmd.infile << " (" << std::strerror(errno) << ")\n";
+                return false;
+            }
+        }
+        if (!cmd.outfile.empty()) {
+            int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (cmd.appendMode ? O_APPEND : O_TRUNC);
+            out = ::open(cmd.outfile.c_str(), flags, 0644);
+            if (out < 0) {
+                std::cerr << "Error opening output file: " << cmd.outfile << " (" << std::strerror(errno) << ")\n";
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// posix_spawn on glibc clones with CLONE_VM | CLONE_VFORK: the parent's
+// page tables are never copied and the call returns once the child has
+// exec'd, which is what makes it cheaper than fork + exec for a big shell.
+class PosixSpawnLauncher : public ProcessLauncher {
+public:
+    PosixSpawnLauncher() {
+        initAttr(attr);
+    }
+
+    ~PosixSpawnLauncher() override {
+        posix_spawnattr_destroy(&attr);
+    }
+
+    bool launch(const Command& cmd, os_handle in, os_handle out, LaunchedProcess& proc) override {
+        if (cmd.limits) return launchLimited(cmd, in, out, proc);
+
+        Redirections files;
+        if (!files.open(cmd)) return false;
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+
+        if (files.in >= 0) {
+            posix_spawn_file_actions_adddup2(&actions, files.in, STDIN_FILENO);
+        } else if (in != kNoHandle) {
+            posix_spawn_file_actions_adddup2(&actions, in, STDIN_FILENO);
+        }
+
+        if (files.out >= 0) {
+            posix_spawn_file_actions_adddup2(&actions, files.out, STDOUT_FILENO);
+            posix_spawn_file_actions_adddup2(&actions, files.out, STDERR_FILENO);
+        } else if (out != kNoHandle) {
+            posix_spawn_file_actions_adddup2(&actions, out, STDOUT_FILENO);
+        }
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+        // Only stdio crosses into the child: one close_range() in the child
+        // drops everything else, whether or not it was opened with O_CLOEXEC
+        posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+#endif
+
+        // Job control: the child joins its process group before it execs
+        posix_spawnattr_t grouped;
+        posix_spawnattr_t* use = &attr;
+        if (proc.pgid >= 0) {
+            initAttr(grouped);
+            posix_spawnattr_setpgroup(&grouped, proc.pgid);
+            posix_spawnattr_setflags(&grouped, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+            use = &grouped;
+        }
+
+        // Look the program up once through the hash table instead of letting
+        // posix_spawnp try every PATH directory on every launch
+        PackedArgv argv(cmd.argv);
+        std::string program = resolve_command(cmd.argv[0]);
+        int err = program.empty() ? ENOENT
+                                  : posix_spawn(&proc.pid, program.c_str(), &actions, use, argv.get(), environ);
+        if (err == ENOENT && program != cmd.argv[0]) {
+            // The remembered program has gone away since it was hashed (the
+            // redirections are open already, so the exec is what failed)
+            path_cache_forget(cmd.argv[0]);
+            program = resolve_command(cmd.argv[0]);
+            if (!program.empty()) err = posix_spawn(&proc.pid, program.c_str(), &actions, use, argv.get(), environ);
+        }
+        posix_spawn_file_actions_destroy(&actions);
+        if (use != &attr) posix_spawnattr_destroy(use);
+
+        if (err != 0) {
+            std::cerr << "Failed to start process: " << cmd.argv[0] << " (" << std::strerror(err) << ")\n";
+            return false;
+        }
+        return true;
+    }
+
+    int wait(LaunchedProcess& proc) override {
+        int status;
+        pid_t r;
+        while ((r = waitpid(proc.pid, &status, 0)) < 0 && errno == EINTR) {}
+        if (r < 0) return -1;
+        if (WIFEXITED(status)) return WEXITSTATUS(status);
+        if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+        return -1;
+    }
+
+private:
+    posix_spawnattr_t attr;
+
+    // Why the child of launchLimited() gave up before exec
+    // Only plain values cross the pipe: the parent tells from `step` which
+    // of its own strings to name. `option` is set for Limit and points at a
+    // string literal in apply_resource_limits(), static storage that sits at
+    // the same address in both processes.
+    struct ChildError {
+        enum Step { Exec, Infile, Outfile, Limit };
+        int err;
+        Step step;
+        const char* option;
+    };
+
+    // posix_spawn cannot set rlimits, a nice value or an affinity mask in the
+    // child, so a command with `run` limits takes fork + exec. Everything is
+    // allocated and the redirections are opened before the fork; the child
+    // only makes system calls, stops at the first that fails, and a
+    // close-on-exec pipe brings back the errno of whatever failed (and reads
+    // as empty once the exec succeeds).
+    bool launchLimited(const Command& cmd, os_handle in, os_handle out, LaunchedProcess& proc) {
+        PackedArgv argv(cmd.argv);
+        std::string program = resolve_command(cmd.argv[0]);
+        if (program.empty()) {
+            std::cerr << "Failed to start process: " << cmd.argv[0] << " (" << std::strerror(ENOENT) << ")\n";
+            return false;
+        }
+        Redirections files;
+        if (!files.open(cmd)) return false;
+        int report[2];
+        if (pipe2(report, O_CLOEXEC) != 0) {
+            perror("pipe");
+            return false;
+        }
+
+        std::cout.flush();
+        std::cerr.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            ChildError failure = {0, ChildError::Exec, nullptr};
+            if (proc.pgid >= 0) setpgid(0, proc.pgid);
+            struct sigaction dfl = {};
+            dfl.sa_handler = SIG_DFL;
+            for (int sig : {SIGPIPE, SIGTSTP, SIGTTIN, SIGTTOU}) sigaction(sig, &dfl, nullptr);
+
+            if (files.in >= 0) {
+                if (dup2(files.in, STDIN_FILENO) < 0) failure = {errno, ChildError::Infile, nullptr};
+            } else if (in != kNoHandle) {
+                dup2(in, STDIN_FILENO);
+            }
+            if (files.out >= 0) {
+                if (failure.err == 0 && (dup2(files.out, STDOUT_FILENO) < 0 || dup2(files.out, STDERR_FILENO) < 0)) {
+                    failure = {errno, ChildError::Outfile, nullptr};
+                }
+            } else if (out != kNoHandle) {
+                dup2(out, STDOUT_FILENO);
+            }
+            if (files.in > STDERR_FILENO) close(files.in);
+            if (files.out > STDERR_FILENO) close(files.out);
+#ifdef SYS_close_range
+            // As addclosefrom_np does for posix_spawn, but the report pipe
+            // has to stay open until the exec itself
+            syscall(SYS_close_range, STDERR_FILENO + 1, ~0U, CLOSE_RANGE_CLOEXEC);
+#endif
+            if (failure.err == 0) {
+                failure.err = apply_resource_limits(*cmd.limits, failure.option);
+                if (failure.err != 0) failure.step = ChildError::Limit;
+            }
+            if (failure.err == 0) {
+                execve(program.c_str(), argv.get(), environ);
+                failure = {errno, ChildError::Exec, nullptr};
+            }
+            ssize_t ignored = write(report[1], &failure, sizeof(failure));
+            (void)ignored;
+            _exit(127);
+        }
+
+        close(report[1]);
+        if (pid < 0) {
+            perror("fork");
+            close(report[0]);
+            return false;
+        }
+        // Both sides set the group, so it is in place whichever runs first
+        if (proc.pgid >= 0) setpgid(pid, proc.pgid == 0 ? pid : proc.pgid);
+
+        ChildError failure;
+        ssize_t n;
+        while ((n = read(report[0], &failure, sizeof(failure))) < 0 && errno == EINTR) {}
+        close(report[0]);
+        if (n == (ssize_t)sizeof(failure)) {
+            while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {}
+            std::string what = failure.step == ChildError::Infile  ? cmd.infile
+                             : failure.step == ChildError::Outfile ? cmd.outfile
+                             : failure.step == ChildError::Limit   ? failure.option
+                                                                   : "";
+            if (failure.step == ChildError::Exec && failure.err == ENOENT) path_cache_forget(cmd.argv[0]);
+            std::cerr << "Failed to start process: " << cmd.argv[0] << " ("
+                      << (what.empty() ? "" : what + ": ") << std::strerror(failure.err) << ")\n";
+            return false;
+        }
+        proc.pid = pid;
+        return true;
+    }
+
+    static void initAttr(posix_spawnattr_t& a) {
+        posix_spawnattr_init(&a);
+
+        // The shell ignores SIGPIPE for its stage threads, and an interactive
+        // shell ignores the job-control stops; children must not
+        sigset_t defaults;
+        sigemptyset(&defaults);
+        sigaddset(&defaults, SIGPIPE);
+        sigaddset(&defaults, SIGTSTP);
+        sigaddset(&defaults, SIGTTIN);
+        sigaddset(&defaults, SIGTTOU);
+        posix_spawnattr_setsigdefault(&a, &defaults);
+        posix_spawnattr_setflags(&a, POSIX_SPAWN_SETSIGDEF);
+    }
+};
+
+ProcessLauncher& default_launcher() {
+    static PosixSpawnLauncher launcher;
+    return launcher;
+}
+
+#endif
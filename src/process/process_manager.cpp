@@ -1,27 +1,152 @@
 #include "../include/process_manager.h"
-#include <windows.h>
-#include <tlhelp32.h>
+#include "../include/job_table.h"
+#include "../include/reaper.h"
+#include "../include/proc_snapshot.h"
+#include "../include/proc_monitor.h"
+#include "../include/event_log.h"
+#include "../include/proc_tree.h"
+#include <algorithm>
+#include <ctime>
 #include <iostream>
 #include <vector>
+#include <thread> 
+#include <chrono>
+#include <iomanip> 
+#include <sstream>
 
+#ifdef _WIN32
+#include <windows.h>
+#include <tlhelp32.h>
 #include <initguid.h>  
 #include <wbemidl.h>
 #include <comdef.h>
 #include <mutex>
-#include <thread> 
-#include <chrono>
 #include <psapi.h>
-#include <iomanip> 
-
 
 #pragma comment(lib, "wbemuuid.lib")
 #pragma comment(lib, "psapi.lib")
+#else
+#include <signal.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#endif
 
 
-bool monitor_running = true;
+std::atomic<bool> monitor_running(true);
 bool monitor_silent = true; 
-static std::vector<ProcessInfo> process_list;
 
+const char* process_status_name(ProcessStatus status) {
+    switch (status) {
+        case ProcessStatus::Running:   return "Running";
+        case ProcessStatus::Suspended: return "Suspended";
+        case ProcessStatus::Done:      return "Done";
+    }
+    return "?";
+}
+
+ProcessUsage& ProcessUsage::operator+=(const ProcessUsage& o) {
+    user_sec += o.user_sec;
+    sys_sec += o.sys_sec;
+    if (o.max_rss_kb > max_rss_kb) max_rss_kb = o.max_rss_kb;
+    read_chars += o.read_chars;
+    write_chars += o.write_chars;
+    read_bytes += o.read_bytes;
+    write_bytes += o.write_bytes;
+    return *this;
+}
+
+#ifdef _WIN32
+bool sample_process_usage(DWORD pid, ProcessUsage& usage) {
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (hProcess == NULL) return false;
+
+    // FILETIMEs count 100 ns units
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(hProcess, &created, &exited, &kernel, &user)) {
+        auto seconds = [](const FILETIME& t) {
+            return ((ULONGLONG)t.dwHighDateTime << 32 | t.dwLowDateTime) / 1e7;
+        };
+        usage.user_sec = seconds(user);
+        usage.sys_sec = seconds(kernel);
+    }
+    PROCESS_MEMORY_COUNTERS mem;
+    if (GetProcessMemoryInfo(hProcess, &mem, sizeof(mem))) usage.max_rss_kb = (long)(mem.PeakWorkingSetSize / 1024);
+    IO_COUNTERS io;
+    if (GetProcessIoCounters(hProcess, &io)) {
+        // Windows does not tell storage apart from pipes and devices
+        usage.read_chars = usage.read_bytes = io.ReadTransferCount;
+        usage.write_chars = usage.write_bytes = io.WriteTransferCount;
+    }
+    CloseHandle(hProcess);
+    return true;
+}
+#else
+bool sample_process_usage(pid_t pid, ProcessUsage& usage) {
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    if (!std::getline(stat, line)) return false;
+
+    // The name in parentheses may contain spaces: count fields after it.
+    // utime and stime are fields 14 and 15, in clock ticks.
+    std::istringstream fields(line.substr(line.rfind(')') + 2));
+    std::string field;
+    unsigned long long utime = 0, stime = 0;
+    for (int i = 3; i <= 15 && fields >> field; ++i) {
+        if (i == 14) utime = std::strtoull(field.c_str(), nullptr, 10);
+        if (i == 15) stime = std::strtoull(field.c_str(), nullptr, 10);
+    }
+    double tick = (double)sysconf(_SC_CLK_TCK);
+    usage.user_sec = utime / tick;
+    usage.sys_sec = stime / tick;
+
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) usage.max_rss_kb = std::strtol(line.c_str() + 6, nullptr, 10);
+    }
+    read_io_counters(pid, usage);
+    return true;
+}
+#endif
+
+// "12.3M"-style sizes for the accounting columns
+static std::string human_bytes(uint64_t bytes) {
+    const char* units = "BKMGT";
+    double value = (double)bytes;
+    int unit = 0;
+    while (value >= 1024 && unit < 4) {
+        value /= 1024;
+        ++unit;
+    }
+    std::ostringstream out;
+    if (unit == 0) out << bytes << "B";
+    else out << std::fixed << std::setprecision(value < 10 ? 1 : 0) << value << units[unit];
+    return out.str();
+}
+
+static std::string seconds_text(double seconds) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(seconds < 10 ? 3 : 1) << seconds << "s";
+    return out.str();
+}
+
+// Recorded usage once the process is Done, a live sample before that
+static ProcessUsage usage_of(const ProcessInfo& p) {
+    if (p.status == ProcessStatus::Done) return p.usage;
+    ProcessUsage live;
+    sample_process_usage(p.pid, live);
+    return live;
+}
+
+static double wall_seconds(const ProcessInfo& p) {
+    auto end = p.status == ProcessStatus::Done ? p.ended : std::chrono::system_clock::now();
+    return std::chrono::duration<double>(end - p.started).count();
+}
+
+#ifdef _WIN32
 bool is_process_running(DWORD pid) {
     if (pid == 0) return false;
     
@@ -41,15 +166,18 @@ bool is_process_running(DWORD pid) {
 }
 
 // sync_process_list() synchronizes the process list by removing any processes that are no longer running.
+// (On POSIX the reaper records exits as they happen instead.)
 void sync_process_list() {
-    auto it = process_list.begin();
-    while (it != process_list.end()) {
-        if (!is_process_running(it->pid)) {
-            std::cout << "[AUTO REMOVED] PID: " << it->pid 
-                      << " | Name: " << it->name << "\n";
-            it = process_list.erase(it); 
-        } else {
-            ++it; 
+    // Checked on a copy: the table stays free for the shell while we probe
+    for (const auto& p : job_table().snapshot()) {
+        if (is_process_running(p.pid)) continue;
+        if (job_table().remove(p.pid)) {
+            ProcEvent e;
+            e.type = ProcEvent::Removed;
+            e.pid = p.pid;
+            e.when = std::chrono::system_clock::now();
+            e.name = p.name;
+            log_monitor_event(e);
         }
     }
 }
@@ -60,41 +188,73 @@ void sync_thread_function() {
         sync_process_list();
     }
 }
-
-void list_processes() {
-    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (hSnapshot == INVALID_HANDLE_VALUE) {
-        std::cerr << "Failed to create snapshot.\n";
+#endif
+
+void list_processes(const ListOptions& options) {
+    SnapshotOptions snap;
+    snap.cmdline = true;
+    std::vector<ProcSample> procs = take_proc_snapshot(snap);
+    if (procs.empty()) {
+        std::cerr << "Failed to read the process list.\n";
         return;
     }
 
-    PROCESSENTRY32 pe;
-    pe.dwSize = sizeof(PROCESSENTRY32);
-
-    if (Process32First(hSnapshot, &pe)) {
-        std::cout << "PID\tName\n";
-        do {
-            std::wcout << pe.th32ProcessID << "\t" << pe.szExeFile << "\n";
-        } while (Process32Next(hSnapshot, &pe));
-    } else {
-        std::cerr << "Failed to retrieve process list.\n";
+    if (!options.name.empty()) {
+        procs.erase(std::remove_if(procs.begin(), procs.end(), [&](const ProcSample& p) {
+            return !wildcard_match(options.name.c_str(), p.name.c_str());
+        }), procs.end());
     }
 
-    CloseHandle(hSnapshot);
+    // Lifetime CPU share: ticks used over ticks alive, as ps reports it
+    uint64_t now = proc_uptime_ticks();
+    auto cpuPercent = [now](const ProcSample& p) {
+        uint64_t age = now > p.start_ticks ? now - p.start_ticks : 0;
+        return age ? 100.0 * p.cpu_ticks / age : 0.0;
+    };
+    if (options.sort == ListOptions::BY_CPU) {
+        std::stable_sort(procs.begin(), procs.end(), [&](const ProcSample& a, const ProcSample& b) {
+            return cpuPercent(a) > cpuPercent(b);
+        });
+    } else if (options.sort == ListOptions::BY_MEM) {
+        std::stable_sort(procs.begin(), procs.end(), [](const ProcSample& a, const ProcSample& b) {
+            return a.rss_kb > b.rss_kb;
+        });
+    }
+    if (options.top && procs.size() > options.top) procs.resize(options.top);
+
+    double totalKb = (double)proc_total_memory_kb();
+    std::cout << std::left << std::setw(8) << "PID" << std::setw(8) << "PPID" << std::setw(3) << "S"
+              << std::right << std::setw(6) << "CPU%" << std::setw(7) << "MEM%" << std::setw(11) << "RSS"
+              << "  " << "Command" << "\n";
+    for (const auto& p : procs) {
+        std::cout << std::left << std::setw(8) << p.pid << std::setw(8) << p.ppid << std::setw(3) << p.state
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(6) << cpuPercent(p)
+                  << std::setw(7) << (totalKb > 0 ? 100.0 * p.rss_kb / totalKb : 0.0)
+                  << std::setw(11) << human_bytes(p.rss_kb * 1024)
+                  << "  " << (p.cmdline.empty() ? "[" + p.name + "]" : p.cmdline) << "\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
 }
 
-int find_process_index(DWORD pid) {
-    for (size_t i = 0; i < process_list.size(); ++i) {
-        if (process_list[i].pid == pid) return static_cast<int>(i);
-    }
-    return -1;
+#ifdef _WIN32
+// NtSuspendProcess and NtResumeProcess are not in the Windows headers;
+// looked up in ntdll once, on first use
+typedef LONG (NTAPI *NtProcessCall)(HANDLE);
+
+static NtProcessCall ntdll_entry(const char* name) {
+    HMODULE ntdll = GetModuleHandleA("ntdll.dll");
+    return ntdll ? (NtProcessCall)GetProcAddress(ntdll, name) : nullptr;
 }
 
 bool stop_process(DWORD pid) {
-    if (pid == GetCurrentProcessId()) {
+    static const NtProcessCall suspend = ntdll_entry("NtSuspendProcess");
+    if (pid == 0 || pid == GetCurrentProcessId()) {
         std::cerr << "Cannot suspend the shell itself!\n";
         return false;
     }
+    if (!suspend) return false;
 
     HANDLE hProcess = OpenProcess(PROCESS_SUSPEND_RESUME, FALSE, pid);
     if (!hProcess) {
@@ -102,48 +262,37 @@ bool stop_process(DWORD pid) {
         return false;
     }
 
-    typedef LONG (NTAPI *NtSuspendProcess)(HANDLE);
-    HMODULE ntdll = GetModuleHandleA("ntdll.dll");
-    if (!ntdll) return false;
-    NtSuspendProcess suspend = (NtSuspendProcess)GetProcAddress(ntdll, "NtSuspendProcess");
-    if (!suspend) return false;
-
     suspend(hProcess);
     CloseHandle(hProcess);
 
-    int index = find_process_index(pid);
-    if (index != -1) {
-        process_list[index].status = "Suspended";   
-    }
+    job_table().setStatus(pid, ProcessStatus::Suspended);
 
     return true;
 }
 
 bool resume_process(DWORD pid) {
+    static const NtProcessCall resume = ntdll_entry("NtResumeProcess");
+    if (!resume) return false;
+
     HANDLE hProcess = OpenProcess(PROCESS_SUSPEND_RESUME, FALSE, pid);
     if (!hProcess) {
         std::cerr << "Failed to open process.\n";
         return false;
     }
 
-    typedef LONG (NTAPI *NtResumeProcess)(HANDLE);
-    HMODULE ntdll = GetModuleHandleA("ntdll.dll");
-    if (!ntdll) return false;
-    NtResumeProcess resume = (NtResumeProcess)GetProcAddress(ntdll, "NtResumeProcess");
-    if (!resume) return false;
-
     resume(hProcess);
     CloseHandle(hProcess);
 
-    int index = find_process_index(pid);
-    if (index != -1) {
-        process_list[index].status = "Running";
-    }
+    job_table().setStatus(pid, ProcessStatus::Running);
 
     return true;
 }
 
 bool kill_process(DWORD pid) {
+    if (pid == 0 || pid == GetCurrentProcessId()) {
+        std::cerr << "Cannot kill the shell itself!\n";
+        return false;
+    }
     HANDLE hProcess = OpenProcess(PROCESS_TERMINATE, FALSE, pid);
     if (!hProcess) {
         std::cerr << "Failed to open process.\n";
@@ -153,53 +302,335 @@ bool kill_process(DWORD pid) {
     BOOL result = TerminateProcess(hProcess, 0);
     CloseHandle(hProcess);
 
+    // Our own children stay in the table until their exit is reported
     if (result) {
-        int index = find_process_index(pid);
-        if (index != -1) {
-            process_list.erase(process_list.begin() + index);
-        }
         std::cout << "[TERMINATED PROCESS] PID: " << pid << " has been terminated from the system.\n";
     }
 
     return result;
 }
 
-void addProcess(DWORD pid, const std::wstring &cmdline, HANDLE hProcess, bool is_background) {
+int addProcess(DWORD pid, const std::wstring &cmdline, HANDLE hProcess, bool is_background, int job) {
     int len = WideCharToMultiByte(CP_UTF8, 0, cmdline.c_str(), -1, NULL, 0, NULL, NULL);
     std::string name(len, 0);
     WideCharToMultiByte(CP_UTF8, 0, cmdline.c_str(), -1, &name[0], len, NULL, NULL);
-    process_list.push_back({ pid, name, "Running", is_background });
+    name.resize(len > 0 ? len - 1 : 0);   // drop the converted terminator
+    return addProcess(pid, name, is_background, job);
 }
+#else
+// pid 0 and negative pids would signal whole process groups, the shell's included
+bool stop_process(pid_t pid) {
+    if (pid <= 0 || pid == getpid()) {
+        std::cerr << "Cannot suspend the shell itself!\n";
+        return false;
+    }
+
+    if (kill(pid, SIGSTOP) != 0) {
+        perror("stop");
+        return false;
+    }
 
-void print_managed_processes() {
-    std::cout << std::left;
-    std::cout << std::setw(10) << "PID"
-              << std::setw(15) << "Status"
-              << std::setw(15) << "Type"
-              << "Name\n";
-    std::cout << std::string(50, '-') << "\n"; 
+    job_table().setStatus(pid, ProcessStatus::Suspended);
 
-    for (const auto& p : process_list) {
-        std::cout << std::setw(10) << p.pid
-                  << std::setw(15) << p.status
-                  << std::setw(15) << (p.is_background ? "Background" : "Foreground")
-                  << p.name << "\n";
+    return true;
+}
+
+bool resume_process(pid_t pid) {
+    if (pid <= 0) {
+        std::cerr << "resume: bad pid " << pid << "\n";
+        return false;
+    }
+    if (kill(pid, SIGCONT) != 0) {
+        perror("resume");
+        return false;
     }
+
+    job_table().setStatus(pid, ProcessStatus::Running);
+
+    return true;
 }
 
-void print_process_info(DWORD pid) {
-    int index = find_process_index(pid);
-    if (index == -1) {
-        std::cout << "Process with PID " << pid << " not found in managed list.\n";
-        return;
+bool kill_process(pid_t pid) {
+    if (pid <= 0 || pid == getpid()) {
+        std::cerr << "Cannot kill the shell itself!\n";
+        return false;
     }
-    const auto& p = process_list[index];
+    if (kill(pid, SIGKILL) != 0) {
+        perror("kill");
+        return false;
+    }
+
+    // A child of ours stays in the table: the reaper records its exit
+    // (128 + SIGKILL), and `wait` or `jobs` reports and forgets it
+    std::cout << "[TERMINATED PROCESS] PID: " << pid << " has been terminated from the system.\n";
+
+    return true;
+}
+#endif
+
+static bool act_on_pid(ProcessAction action, proc_id pid) {
+    switch (action) {
+        case ProcessAction::Kill: return kill_process(pid);
+        case ProcessAction::Stop: return stop_process(pid);
+        default: return resume_process(pid);
+    }
+}
+
+static proc_id shell_pid() {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return getpid();
+#endif
+}
+
+// A positive pid, digits only
+static bool parse_pid(const std::string& text, proc_id& pid) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    unsigned long value = std::strtoul(text.c_str(), nullptr, 10);
+    pid = (proc_id)value;
+    return value > 0 && (unsigned long)pid == value;
+}
+
+#ifndef _WIN32
+// One killpg() for the whole group; the table follows for the members we manage
+static bool act_on_group(ProcessAction action, pid_t pgid) {
+    if (pgid <= 1 || pgid == getpgrp()) {
+        std::cerr << "Refusing to signal the shell's own process group.\n";
+        return false;
+    }
+    // Who is in it has to be asked before a SIGKILL empties it
+    std::vector<proc_id> members;
+    for (const auto& p : job_table().snapshot()) {
+        if (p.status != ProcessStatus::Done && getpgid(p.pid) == pgid) members.push_back(p.pid);
+    }
+
+    int sig = action == ProcessAction::Kill ? SIGKILL : action == ProcessAction::Stop ? SIGSTOP : SIGCONT;
+    if (killpg(pgid, sig) != 0) {
+        perror("killpg");
+        return false;
+    }
+    for (proc_id pid : members) {
+        if (action == ProcessAction::Kill) {
+            std::cout << "[TERMINATED PROCESS] PID: " << pid << " has been terminated from the system.\n";
+        } else {
+            job_table().setStatus(pid, action == ProcessAction::Stop ? ProcessStatus::Suspended : ProcessStatus::Running);
+        }
+    }
+    if (action == ProcessAction::Kill) std::cout << "[TERMINATED GROUP] PGID: " << pgid << "\n";
+    return true;
+}
+#endif
+
+static bool act_on_job(ProcessAction action, int job) {
+    std::vector<proc_id> live;
+    for (const auto& p : job_table().job(job)) {
+        if (p.status != ProcessStatus::Done) live.push_back(p.pid);
+    }
+    if (live.empty()) {
+        std::cerr << "%" << job << ": no such job, or it has finished.\n";
+        return false;
+    }
+#ifndef _WIN32
+    // A job in a group of its own (its first process leads it) takes one
+    // signal, which also reaches whatever its processes started
+    pid_t leader = job_table().job(job).front().pid;
+    if (leader != getpgrp()) {
+        for (proc_id pid : live) {
+            if (getpgid(pid) == leader) return act_on_group(action, leader);
+        }
+    }
+#endif
+    bool ok = true;
+    for (proc_id pid : live) ok = act_on_pid(action, pid) && ok;
+    return ok;
+}
+
+static bool act_on_tree(ProcessAction action, proc_id root) {
+    std::vector<proc_id> pids = ProcTree(take_proc_snapshot()).subtree(root);
+    if (pids.empty()) {
+        std::cerr << "No process " << root << ".\n";
+        return false;
+    }
+    if (std::find(pids.begin(), pids.end(), shell_pid()) != pids.end()) {
+        std::cerr << "Refusing: the tree under " << root << " includes the shell itself.\n";
+        return false;
+    }
+#ifndef _WIN32
+    // Freeze it top-down first, so no process forks a child we never see
+    if (action == ProcessAction::Kill) {
+        for (proc_id pid : pids) kill(pid, SIGSTOP);
+    }
+#endif
+    // Parents before children, except when waking up
+    if (action == ProcessAction::Resume) std::reverse(pids.begin(), pids.end());
+    bool ok = true;
+    for (proc_id pid : pids) ok = act_on_pid(action, pid) && ok;
+    return ok;
+}
+
+// The shell and every process above it: the shell or terminal that started
+// it, and so on up to init. The snapshot is ordered by pid.
+static std::vector<proc_id> shell_and_ancestors(const std::vector<ProcSample>& procs) {
+    std::vector<proc_id> chain;
+    proc_id pid = shell_pid();
+    while (pid != 0 && std::find(chain.begin(), chain.end(), pid) == chain.end()) {
+        chain.push_back(pid);
+        auto it = std::lower_bound(procs.begin(), procs.end(), pid,
+                                   [](const ProcSample& p, proc_id id) { return p.pid < id; });
+        if (it == procs.end() || it->pid != pid) break;
+        pid = it->ppid;
+    }
+    return chain;
+}
+
+// A pattern such as '*' must not take down the shell, what it runs in, or
+// (on POSIX) the rest of its own process group
+static bool act_on_name(ProcessAction action, const std::string& pattern) {
+    std::vector<ProcSample> procs = take_proc_snapshot();
+    std::vector<proc_id> spared = shell_and_ancestors(procs);
+    size_t matched = 0, skipped = 0;
+    bool ok = true;
+    for (const auto& p : procs) {
+        if (!wildcard_match(pattern.c_str(), p.name.c_str())) continue;
+        bool mine = std::find(spared.begin(), spared.end(), p.pid) != spared.end();
+#ifndef _WIN32
+        mine = mine || getpgid(p.pid) == getpgrp();
+#endif
+        if (mine) {
+            ++skipped;
+            continue;
+        }
+        ++matched;
+        ok = act_on_pid(action, p.pid) && ok;
+    }
+    if (matched == 0) {
+        if (skipped) std::cerr << "'" << pattern << "' only matches the shell, its parents or its process group.\n";
+        else std::cerr << "No process matches '" << pattern << "'.\n";
+        return false;
+    }
+    return ok;
+}
+
+int act_on_processes(ProcessAction action, const std::vector<std::string>& args) {
+    const std::string& verb = args[0];
+    proc_id pid;
+    int job;
+    bool ok;
+    if (args.size() == 3 && (args[1] == "-g" || args[1] == "--tree") && parse_pid(args[2], pid)) {
+        if (args[1] == "--tree") {
+            ok = act_on_tree(action, pid);
+        } else {
+#ifdef _WIN32
+            std::cerr << verb << ": process groups are POSIX only; use %job or --tree\n";
+            return 1;
+#else
+            ok = act_on_group(action, pid);
+#endif
+        }
+    } else if (args.size() == 2 && parse_job_spec(args[1], job)) {
+        ok = act_on_job(action, job);
+    } else if (args.size() == 2 && parse_pid(args[1], pid)) {
+        ok = act_on_pid(action, pid);
+    } else if (args.size() == 2 && !args[1].empty() && args[1][0] != '-' &&
+               args[1].find_first_not_of("0123456789") != std::string::npos) {
+        ok = act_on_name(action, args[1]);
+    } else {
+        std::cerr << "Usage: " << verb << " <pid | %job | -g pgid | --tree pid | 'name*'>\n";
+        return 1;
+    }
+    if (!ok) std::cerr << verb << ": failed on " << args.back() << "\n";
+    return ok ? 0 : 1;
+}
+
+int addProcess(proc_id pid, const std::string &cmdline, bool is_background, int job) {
+    job = job_table().add(pid, cmdline, is_background, job);
+    if (is_background) reaper_watch(pid);
+    return job;
+}
+
+void removeProcess(proc_id pid) {
+    job_table().remove(pid);
+}
+
+static std::string status_text(const ProcessInfo& p) {
+    if (p.status != ProcessStatus::Done) return process_status_name(p.status);
+    return "Done (" + std::to_string(p.exit_status) + ")";
+}
+
+void print_managed_processes(bool long_format) {
+    // Formatted into one buffer: thousands of jobs cost one write, not thousands
+    std::ostringstream out;
+    out << std::left;
+    out << std::setw(10) << "PID"
+        << std::setw(6) << "Job"
+        << std::setw(15) << "Status"
+        << std::setw(15) << "Type";
+    if (long_format) {
+        out << std::setw(10) << "Wall" << std::setw(10) << "CPU" << std::setw(9) << "MaxRSS"
+            << std::setw(9) << "Read" << std::setw(9) << "Written";
+    }
+    out << "Name\n";
+    out << std::string(long_format ? 103 : 56, '-') << "\n"; 
+
+    for (const auto& p : job_table().snapshot()) {
+        out << std::setw(10) << p.pid
+            << std::setw(6) << ("%" + std::to_string(p.job_id))
+            << std::setw(15) << status_text(p)
+            << std::setw(15) << (p.is_background ? "Background" : "Foreground");
+        if (long_format) {
+            ProcessUsage u = usage_of(p);
+            out << std::setw(10) << seconds_text(wall_seconds(p))
+                << std::setw(10) << seconds_text(u.user_sec + u.sys_sec)
+                << std::setw(9) << human_bytes((uint64_t)u.max_rss_kb * 1024)
+                << std::setw(9) << human_bytes(u.read_chars)
+                << std::setw(9) << human_bytes(u.write_chars);
+        }
+        out << p.name << "\n";
+    }
+    std::cout << out.str();
+}
+
+static void print_info(const ProcessInfo& p) {
+    std::time_t started = std::chrono::system_clock::to_time_t(p.started);
+    ProcessUsage u = usage_of(p);
     std::cout << "PID:        " << p.pid << "\n"
-              << "Status:     " << p.status << "\n"
+              << "Job:        %" << p.job_id << "\n"
+              << "Parent PID: " << p.ppid << "\n"
+              << "Status:     " << status_text(p) << "\n"
               << "Type:       " << (p.is_background ? "Background" : "Foreground") << "\n"
-              << "Name:       " << p.name << "\n";
+              << "Name:       " << p.name << "\n"
+              << (p.limits.empty() ? "" : "Limits:     " + p.limits + "\n")
+              << "Started:    " << std::put_time(std::localtime(&started), "%Y-%m-%d %H:%M:%S") << "\n"
+              << (p.status == ProcessStatus::Done ? "Ran for:    " : "Running:    ") << seconds_text(wall_seconds(p)) << "\n"
+              << "CPU:        " << seconds_text(u.user_sec) << " user, " << seconds_text(u.sys_sec) << " sys\n"
+              << "Max RSS:    " << human_bytes((uint64_t)u.max_rss_kb * 1024) << "\n"
+              << "Read:       " << human_bytes(u.read_chars) << " (" << human_bytes(u.read_bytes) << " from storage)\n"
+              << "Written:    " << human_bytes(u.write_chars) << " (" << human_bytes(u.write_bytes) << " to storage)\n";
+}
+
+void print_process_info(proc_id pid) {
+    ProcessInfo p;
+    if (!job_table().find(pid, p)) {
+        std::cout << "Process with PID " << pid << " not found in managed list.\n";
+        return;
+    }
+    print_info(p);
+}
+
+void print_job_info(int job) {
+    std::vector<ProcessInfo> members = job_table().job(job);
+    if (members.empty()) {
+        std::cout << "Job %" << job << " not found in managed list.\n";
+        return;
+    }
+    for (size_t i = 0; i < members.size(); ++i) {
+        if (i > 0) std::cout << "\n";
+        print_info(members[i]);
+    }
 }
 
+#ifdef _WIN32
 class EventSink : public IWbemObjectSink {
     LONG m_lRef;
     std::mutex mtx;
@@ -252,24 +683,18 @@ public:
             std::wstring name = vtName.bstrVal;
             DWORD pid = vtPid.uintVal;
 
-            if (className == L"__InstanceCreationEvent") {
-                if (!monitor_silent) { 
-                    std::string utf8name;
-                    int len = WideCharToMultiByte(CP_UTF8, 0, name.c_str(), -1, nullptr, 0, nullptr, nullptr);
-                    utf8name.resize(len);
-                    WideCharToMultiByte(CP_UTF8, 0, name.c_str(), -1, &utf8name[0], len, nullptr, nullptr);
-
-                    std::cout << "[NEW PROCESS] PID: " << pid << " | Name: " << utf8name << "\n";
-                }
-            } else if (className == L"__InstanceDeletionEvent") {
-                if (!monitor_silent) { 
-                    std::string utf8name;
-                    int len = WideCharToMultiByte(CP_UTF8, 0, name.c_str(), -1, nullptr, 0, nullptr, nullptr);
-                    utf8name.resize(len);
-                    WideCharToMultiByte(CP_UTF8, 0, name.c_str(), -1, &utf8name[0], len, nullptr, nullptr);
-
-                    std::cout << "[TERMINATED PROCESS] PID: " << pid << " | Name: " << utf8name << "\n";
+            // Queued, not printed: the prompt or `events` shows it later
+            if (className == L"__InstanceCreationEvent" || className == L"__InstanceDeletionEvent") {
+                ProcEvent e;
+                e.type = className == L"__InstanceCreationEvent" ? ProcEvent::Fork : ProcEvent::Exit;
+                e.pid = pid;
+                e.when = std::chrono::system_clock::now();
+                int len = WideCharToMultiByte(CP_UTF8, 0, name.c_str(), -1, nullptr, 0, nullptr, nullptr);
+                if (len > 1) {
+                    e.name.resize(len - 1);
+                    WideCharToMultiByte(CP_UTF8, 0, name.c_str(), -1, &e.name[0], len, nullptr, nullptr);
                 }
+                log_monitor_event(e);
             }
 
             VariantClear(&vtName);
@@ -422,4 +847,19 @@ void MonitorProcessCreation() {
     CoUninitialize();
     sync_thread.join();
 
-}
\ No newline at end of file
+}
+#else
+void MonitorProcessCreation() {
+    // One monitor at a time: a `monitor` right after `stopmonitor` waits
+    // here for the old one to wind down
+    static std::mutex running;
+    std::lock_guard<std::mutex> lock(running);
+    if (!monitor_running) return;
+
+    ProcMonitor monitor;
+    if (!monitor.open()) return;
+    std::cout << "Monitoring process creation and deletion (" << proc_monitor_backend_name(monitor.backend()) << ")...\n";
+
+    monitor.run(monitor_running, log_monitor_event);
+}
+#endif
@@ -0,0 +1,211 @@
+#include "../include/reaper.h"
+#include "../include/job_table.h"
+
+#ifdef _WIN32
+
+void reaper_watch(proc_id) {
+    // The monitor's sync thread notices exited children on Windows
+}
+
+#else
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+int open_pidfd(proc_id pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+int exit_status_of(int rawStatus) {
+    if (WIFEXITED(rawStatus)) return WEXITSTATUS(rawStatus);
+    if (WIFSIGNALED(rawStatus)) return 128 + WTERMSIG(rawStatus);
+    return -1;
+}
+
+void read_io_counters(pid_t pid, ProcessUsage& usage) {
+    char path[32];
+    std::snprintf(path, sizeof(path), "/proc/%d/io", (int)pid);
+    FILE* f = std::fopen(path, "r");
+    if (!f) return;
+    char key[32];
+    unsigned long long value;
+    while (std::fscanf(f, "%31[^:]: %llu\n", key, &value) == 2) {
+        if (std::strcmp(key, "rchar") == 0) usage.read_chars = value;
+        else if (std::strcmp(key, "wchar") == 0) usage.write_chars = value;
+        else if (std::strcmp(key, "read_bytes") == 0) usage.read_bytes = value;
+        else if (std::strcmp(key, "write_bytes") == 0) usage.write_bytes = value;
+    }
+    std::fclose(f);
+}
+
+pid_t wait_child(pid_t pid, int options, int& rawStatus, ProcessUsage& usage) {
+    // Wait without reaping first, so the zombie's counters can still be read
+    siginfo_t info{};
+    int flags = WEXITED | WNOWAIT | ((options & WUNTRACED) ? WSTOPPED : 0) | (options & WNOHANG);
+    int r;
+    while ((r = waitid(P_PID, pid, &info, flags)) < 0 && errno == EINTR) {}
+    if (r < 0) return -1;
+    if (info.si_pid == 0) return 0;
+    if (info.si_code == CLD_EXITED || info.si_code == CLD_KILLED || info.si_code == CLD_DUMPED) {
+        read_io_counters(pid, usage);   // the zombie still holds its final totals
+    }
+
+    rusage ru{};
+    pid_t got;
+    while ((got = wait4(pid, &rawStatus, (options & WUNTRACED) | WNOHANG, &ru)) < 0 && errno == EINTR) {}
+    if (got != pid) return -1;   // someone else reaped it in between
+    if (WIFSTOPPED(rawStatus)) return got;
+    usage.user_sec = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6;
+    usage.sys_sec = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+    usage.max_rss_kb = ru.ru_maxrss;
+    return got;
+}
+
+namespace {
+
+int sigchldPipe[2] = {-1, -1};   // fallback: the SIGCHLD handler writes a byte here
+
+void onSigchld(int) {
+    int saved = errno;
+    ssize_t r = write(sigchldPipe[1], "", 1);   // a full pipe already has a wakeup pending
+    (void)r;
+    errno = saved;
+}
+
+// epoll data for a pidfd: the fd in the high half, the pid in the low half
+uint64_t pack(int fd, pid_t pid) { return ((uint64_t)(uint32_t)fd << 32) | (uint32_t)pid; }
+
+const uint64_t kSigchldEvent = ~(uint64_t)0;
+
+class Reaper {
+public:
+    void watch(pid_t pid) {
+        std::call_once(started, [this] { start(); });
+        if (epfd < 0) return;
+
+        if (usePidfd) {
+            int fd = open_pidfd(pid);
+            if (fd < 0) {
+                reap(pid);   // already gone (reaped by someone else) or out of fds
+                return;
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = pack(fd, pid);
+            if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                close(fd);
+                reap(pid);
+            }
+            return;
+        }
+        // The child may have exited before it was in the table: look again
+        onSigchld(SIGCHLD);
+    }
+
+private:
+    std::once_flag started;
+    int epfd = -1;
+    bool usePidfd = false;
+
+    void start() {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (epfd < 0) {
+            perror("reaper: epoll_create1");
+            return;
+        }
+
+        int self = open_pidfd(getpid());
+        usePidfd = self >= 0;
+        if (usePidfd) {
+            close(self);
+        } else if (!startSigchld()) {
+            close(epfd);
+            epfd = -1;
+            return;
+        }
+        std::thread(&Reaper::run, this).detach();
+    }
+
+    bool startSigchld() {
+        if (pipe2(sigchldPipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+            perror("reaper: pipe");
+            return false;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = kSigchldEvent;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, sigchldPipe[0], &ev);
+
+        struct sigaction sa{};
+        sa.sa_handler = onSigchld;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+        return sigaction(SIGCHLD, &sa, nullptr) == 0;
+    }
+
+    void run() {
+        epoll_event events[64];
+        while (true) {
+            int n = epoll_wait(epfd, events, 64, -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                perror("reaper: epoll_wait");
+                return;
+            }
+            for (int i = 0; i < n; ++i) {
+                uint64_t data = events[i].data.u64;
+                if (data == kSigchldEvent) {
+                    drainSigchld();
+                    continue;
+                }
+                int fd = (int)(data >> 32);
+                epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+                close(fd);
+                reap((pid_t)(uint32_t)data);
+            }
+        }
+    }
+
+    // Without pidfds a SIGCHLD only says that some child exited: try each
+    // background entry. Foreground children are left to whoever waits on them.
+    void drainSigchld() {
+        char buf[64];
+        while (read(sigchldPipe[0], buf, sizeof(buf)) > 0) {}
+        for (const auto& p : job_table().snapshot()) {
+            if (p.is_background && p.status != ProcessStatus::Done) reap(p.pid);
+        }
+    }
+
+    static void reap(pid_t pid) {
+        int status;
+        ProcessUsage usage;
+        // Still running, or not (or no longer) our child: nothing to record
+        if (wait_child(pid, WNOHANG, status, usage) != pid) return;
+        job_table().finish(pid, exit_status_of(status), usage);
+    }
+};
+
+} // namespace
+
+void reaper_watch(proc_id pid) {
+    static Reaper reaper;
+    reaper.watch(pid);
+}
+
+#endif
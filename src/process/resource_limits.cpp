@@ -0,0 +1,259 @@
+#include "../include/resource_limits.h"
+#include "../include/builtin.h"
+#include "../include/parser.h"
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// "512M" -> bytes; K, M and G are powers of 1024
+bool parseSize(const std::string& text, uint64_t& bytes) {
+    char* end;
+    errno = 0;
+    unsigned long long n = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str() || errno || text[0] == '-') return false;
+    int shift = 0;
+    switch (*end) {
+        case '\0': break;
+        case 'k': case 'K': shift = 10; ++end; break;
+        case 'm': case 'M': shift = 20; ++end; break;
+        case 'g': case 'G': shift = 30; ++end; break;
+        default: return false;
+    }
+    if (*end == 'B' || *end == 'b') ++end;
+    if (*end || n == 0 || n > (~0ULL >> shift)) return false;
+    bytes = (uint64_t)n << shift;
+    return true;
+}
+
+bool parseNumber(const std::string& text, long long lo, long long hi, long long& value) {
+    char* end;
+    errno = 0;
+    value = std::strtoll(text.c_str(), &end, 10);
+    return end != text.c_str() && !*end && !errno && value >= lo && value <= hi;
+}
+
+// "0-3,6" -> {0, 1, 2, 3, 6}
+bool parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t comma = text.find(',', pos);
+        std::string item = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t dash = item.find('-');
+        long long first, last;
+        if (dash == std::string::npos) {
+            if (!parseNumber(item, 0, 1023, first)) return false;
+            last = first;
+        } else if (!parseNumber(item.substr(0, dash), 0, 1023, first) ||
+                   !parseNumber(item.substr(dash + 1), first, 1023, last)) {
+            return false;
+        }
+        for (long long c = first; c <= last; ++c) cpus.push_back((int)c);
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return !cpus.empty();
+}
+
+std::string sizeText(uint64_t bytes) {
+    static const char units[] = "KMG";
+    for (int i = 2; i >= 0; --i) {
+        uint64_t unit = 1ULL << (10 * (i + 1));
+        if (bytes % unit == 0) return std::to_string(bytes / unit) + units[i];
+    }
+    return std::to_string(bytes);
+}
+
+// {0, 1, 2, 3, 6} -> "0-3,6"
+std::string cpuListText(const std::vector<int>& cpus) {
+    std::string text;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (!text.empty()) text += ',';
+        text += std::to_string(cpus[i]);
+        if (j > i) text += '-' + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return text;
+}
+
+} // namespace
+
+std::string ResourceLimits::describe() const {
+    std::string text;
+    auto add = [&text](const std::string& item) {
+        if (!text.empty()) text += ", ";
+        text += item;
+    };
+    if (memoryBytes) add("mem " + sizeText(memoryBytes));
+    if (cpuSeconds) add("cpu-time " + std::to_string(cpuSeconds) + "s");
+    if (openFiles) add("files " + std::to_string(openFiles));
+    if (hasNice) add("nice " + std::to_string(nice));
+    if (!cpus.empty()) add("cpus " + cpuListText(cpus));
+    return text;
+}
+
+bool parse_run_command(const Command& run, Command& out) {
+    const auto& args = run.argv;
+    ResourceLimits limits = run.limits ? *run.limits : ResourceLimits();
+    size_t i = 1;
+    for (; i < args.size() && args[i].size() > 1 && args[i][0] == '-'; ++i) {
+        const std::string& opt = args[i];
+        if (opt == "--") {
+            ++i;
+            break;
+        }
+        if (i + 1 == args.size()) {
+            std::cerr << "run: " << opt << " needs a value\n";
+            return false;
+        }
+        const std::string& value = args[++i];
+        long long n;
+        bool ok;
+        if (opt == "--mem") {
+            ok = parseSize(value, limits.memoryBytes);
+        } else if (opt == "--cpu-time") {
+            ok = parseNumber(value, 1, 1LL << 40, n);
+            if (ok) limits.cpuSeconds = (uint64_t)n;
+        } else if (opt == "--files") {
+            ok = parseNumber(value, 1, 1 << 24, n);
+            if (ok) limits.openFiles = (uint64_t)n;
+        } else if (opt == "--nice") {
+            ok = parseNumber(value, -20, 19, n);
+            if (ok) {
+                limits.hasNice = true;
+                limits.nice = (int)n;
+            }
+        } else if (opt == "--cpus") {
+            ok = parseCpuList(value, limits.cpus);
+        } else {
+            std::cerr << "run: unknown option " << opt << "\n";
+            return false;
+        }
+        if (!ok) {
+            std::cerr << "run: bad value for " << opt << ": " << value << "\n";
+            return false;
+        }
+    }
+    if (i == args.size()) {
+        std::cerr << "Usage: run [--mem SIZE] [--cpu-time SECS] [--files N] [--nice N] [--cpus LIST] <command> [args...]\n";
+        return false;
+    }
+
+    if (args[i] != "run" && is_builtin(args[i])) {
+        std::cerr << "run: " << args[i] << " is a built-in; limits only apply to programs\n";
+        return false;
+    }
+
+    out = run;
+    out.argv.assign(args.begin() + i, args.end());
+    if (limits.empty()) {
+        out.limits.reset();
+    } else {
+        out.limits = std::make_shared<const ResourceLimits>(std::move(limits));
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool apply_resource_limits(HANDLE process, const ResourceLimits& limits) {
+    if (limits.memoryBytes || limits.cpuSeconds) {
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION info{};
+        if (limits.memoryBytes) {
+            info.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PROCESS_MEMORY;
+            info.ProcessMemoryLimit = (SIZE_T)limits.memoryBytes;
+        }
+        if (limits.cpuSeconds) {
+            // In 100 ns units
+            info.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PROCESS_TIME;
+            info.BasicLimitInformation.PerProcessUserTimeLimit.QuadPart = (LONGLONG)limits.cpuSeconds * 10000000;
+        }
+        // The process keeps the job alive; our handle is not needed past this
+        HANDLE job = CreateJobObjectW(nullptr, nullptr);
+        bool ok = job && SetInformationJobObject(job, JobObjectExtendedLimitInformation, &info, sizeof(info)) &&
+                  AssignProcessToJobObject(job, process);
+        if (job) CloseHandle(job);
+        if (!ok) {
+            std::cerr << "run: cannot set memory/CPU limits (Error code: " << GetLastError() << ")\n";
+            return false;
+        }
+    }
+    if (limits.hasNice) {
+        DWORD priority = limits.nice <= -15 ? HIGH_PRIORITY_CLASS
+                       : limits.nice < 0    ? ABOVE_NORMAL_PRIORITY_CLASS
+                       : limits.nice == 0   ? NORMAL_PRIORITY_CLASS
+                       : limits.nice < 15   ? BELOW_NORMAL_PRIORITY_CLASS
+                                            : IDLE_PRIORITY_CLASS;
+        if (!SetPriorityClass(process, priority)) {
+            std::cerr << "run: cannot set priority (Error code: " << GetLastError() << ")\n";
+            return false;
+        }
+    }
+    if (!limits.cpus.empty()) {
+        DWORD_PTR mask = 0;
+        for (int cpu : limits.cpus) {
+            if (cpu < (int)(8 * sizeof(mask))) mask |= (DWORD_PTR)1 << cpu;
+        }
+        if (!SetProcessAffinityMask(process, mask)) {
+            std::cerr << "run: cannot set CPU affinity (Error code: " << GetLastError() << ")\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+#else
+
+int apply_resource_limits(const ResourceLimits& limits, const char*& what) {
+    struct { int resource; uint64_t value; const char* option; } caps[] = {
+        {RLIMIT_AS, limits.memoryBytes, "--mem"},
+        {RLIMIT_CPU, limits.cpuSeconds, "--cpu-time"},
+        {RLIMIT_NOFILE, limits.openFiles, "--files"},
+    };
+    for (const auto& cap : caps) {
+        if (!cap.value) continue;
+        // Only ever lowered: the hard limit drops too, so the program cannot
+        // raise it back
+        rlimit current;
+        if (getrlimit(cap.resource, &current) != 0) {
+            what = cap.option;
+            return errno;
+        }
+        rlim_t value = (rlim_t)cap.value;
+        if (current.rlim_max != RLIM_INFINITY && value > current.rlim_max) value = current.rlim_max;
+        rlimit capped = {value, value};
+        if (setrlimit(cap.resource, &capped) != 0) {
+            what = cap.option;
+            return errno;
+        }
+    }
+    if (limits.hasNice && setpriority(PRIO_PROCESS, 0, limits.nice) != 0) {
+        what = "--nice";
+        return errno;
+    }
+#ifdef __linux__
+    if (!limits.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : limits.cpus) {
+            if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            what = "--cpus";
+            return errno;
+        }
+    }
+#endif
+    return 0;
+}
+
+#endif
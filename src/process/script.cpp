@@ -0,0 +1,348 @@
+#include "../include/script.h"
+#include "../include/builtin.h"
+#include "../include/execute.h"
+#include "../include/parser.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <climits>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// One line of a script, ready to run
+struct ScriptOp {
+    const BuiltinInfo* builtin = nullptr;   // Lone built-in: its handler is called directly
+    CommandList list;
+    std::string error;                      // Syntax error, reported when the line is reached
+    uint32_t line = 0;                      // 1-based, for that report
+};
+
+struct FileStamp {
+    int64_t mtime = 0;   // nanoseconds where the platform has them
+    int64_t size = 0;
+
+    bool operator==(const FileStamp& o) const { return mtime == o.mtime && size == o.size; }
+};
+
+struct CompiledScript {
+    FileStamp stamp;
+    std::vector<ScriptOp> ops;
+};
+typedef std::shared_ptr<const CompiledScript> ScriptPtr;
+
+const size_t kMaxScripts = 32;
+
+std::mutex cacheMutex;
+std::list<std::pair<std::string, ScriptPtr>> lru;   // most recently run first
+std::unordered_map<std::string, std::list<std::pair<std::string, ScriptPtr>>::iterator> byPath;
+
+bool stampOf(const std::string& path, FileStamp& stamp) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+#ifdef _WIN32
+    stamp.mtime = (int64_t)st.st_mtime * 1000000000;
+#else
+    stamp.mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    stamp.size = st.st_size;
+    return true;
+}
+
+// The command of a line that is a single simple command, else nullptr
+const Command* loneCommand(const CommandList& list) {
+    if (list.items.size() != 1 || list.items[0].group) return nullptr;
+    const Pipeline& pl = list.items[0].pipeline;
+    if (pl.stages.size() != 1 || pl.stages[0].argv.empty()) return nullptr;
+    return &pl.stages[0];
+}
+
+void bind(ScriptOp& op) {
+    // `run` hands its '&' and redirections on to the command it starts, so
+    // it goes through executeCommand like a program
+    const Command* cmd = loneCommand(op.list);
+    if (cmd && cmd->argv[0] != "run") op.builtin = find_builtin(cmd->argv[0]);
+}
+
+std::shared_ptr<CompiledScript> compile(const std::string& text) {
+    auto script = std::make_shared<CompiledScript>();
+    Arena arena;
+    size_t start = 0;
+    uint32_t number = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) end = text.size();
+        std::string_view line(text.data() + start, end - start);
+        start = end + 1;
+        ++number;
+        if (line.empty()) continue;
+
+        arena.reset();
+        ScriptOp op;
+        op.line = number;
+        if (!parseCommandList(line, arena, op.list, &op.error)) op.list = CommandList{};
+        else if (op.list.items.empty()) continue;
+        bind(op);
+        script->ops.push_back(std::move(op));
+    }
+    return script;
+}
+
+// --- On-disk cache ---
+//
+// <dir>/<hash of absolute path>.tsc holds a header (magic, source path,
+// mtime, size) and the ops as length-prefixed strings; a line that did not
+// parse is kept as its line number and error. Handlers are bound
+// again after loading, so the file never holds anything process-specific.
+
+const char kMagic[4] = {'T', 'S', 'C', '3'};
+const int kMaxGroupDepth = 64;   // `{ { ... } }` nesting accepted from a cache file
+
+std::string cacheFileFor(const std::string& fullPath) {
+    const char* dir = std::getenv("TINYSHELL_CACHE_DIR");
+    if (!dir || !*dir) return "";
+
+    uint64_t h = 14695981039346656037ull;   // FNV-1a
+    for (unsigned char c : fullPath) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.tsc", (unsigned long long)h);
+    return std::string(dir) + "/" + name;
+}
+
+std::string absolutePath(const std::string& path) {
+#ifdef _WIN32
+    char full[_MAX_PATH];
+    return _fullpath(full, path.c_str(), sizeof(full)) ? std::string(full) : path;
+#else
+    char full[PATH_MAX];
+    return realpath(path.c_str(), full) ? std::string(full) : path;
+#endif
+}
+
+void putU32(std::string& out, uint32_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+void putI64(std::string& out, int64_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+void putStr(std::string& out, const std::string& s) {
+    putU32(out, (uint32_t)s.size());
+    out += s;
+}
+
+void putList(std::string& out, const CommandList& list) {
+    putU32(out, (uint32_t)list.items.size());
+    for (const auto& item : list.items) {
+        putU32(out, (uint32_t)item.connector);
+        putU32(out, item.group ? 1 : 0);
+        if (item.group) {
+            putList(out, *item.group);
+            continue;
+        }
+        putU32(out, item.pipeline.background ? 1 : 0);
+        putU32(out, (uint32_t)item.pipeline.stages.size());
+        for (const auto& stage : item.pipeline.stages) {
+            putU32(out, (uint32_t)stage.argv.size());
+            for (const auto& arg : stage.argv) putStr(out, arg);
+            putStr(out, stage.infile);
+            putStr(out, stage.outfile);
+            putU32(out, stage.appendMode ? 1 : 0);
+        }
+    }
+}
+
+class Reader {
+public:
+    explicit Reader(const std::string& data) : p(data.data()), end(data.data() + data.size()) {}
+
+    bool u32(uint32_t& v) { return raw(&v, sizeof(v)); }
+    bool i64(int64_t& v) { return raw(&v, sizeof(v)); }
+    bool str(std::string& s) {
+        uint32_t n;
+        if (!u32(n) || (size_t)(end - p) < n) return false;
+        s.assign(p, n);
+        p += n;
+        return true;
+    }
+    bool raw(void* v, size_t n) {
+        if ((size_t)(end - p) < n) return false;
+        std::memcpy(v, p, n);
+        p += n;
+        return true;
+    }
+
+    size_t left() const { return end - p; }
+
+private:
+    const char* p;
+    const char* end;
+};
+
+// Counts larger than what is left of the file can only come from a damaged file
+bool readList(Reader& in, CommandList& list, int depth) {
+    uint32_t count;
+    if (depth > kMaxGroupDepth || !in.u32(count) || count > in.left()) return false;
+    list.items.resize(count);
+    for (auto& item : list.items) {
+        uint32_t connector, isGroup;
+        if (!in.u32(connector) || connector > ListItem::IF_FAILURE || !in.u32(isGroup)) return false;
+        item.connector = (ListItem::Connector)connector;
+        if (isGroup) {
+            item.group = std::make_shared<CommandList>();
+            if (!readList(in, *item.group, depth + 1)) return false;
+            continue;
+        }
+
+        uint32_t background, stages;
+        if (!in.u32(background) || !in.u32(stages) || stages > in.left()) return false;
+        item.pipeline.background = background != 0;
+        item.pipeline.stages.resize(stages);
+        for (auto& stage : item.pipeline.stages) {
+            uint32_t argc, append;
+            if (!in.u32(argc) || argc > in.left()) return false;
+            stage.argv.resize(argc);
+            for (auto& arg : stage.argv) {
+                if (!in.str(arg)) return false;
+            }
+            if (!in.str(stage.infile) || !in.str(stage.outfile) || !in.u32(append)) return false;
+            stage.appendMode = append != 0;
+        }
+    }
+    return true;
+}
+
+void writeDiskCache(const std::string& file, const std::string& fullPath, const CompiledScript& script) {
+    std::string out(kMagic, sizeof(kMagic));
+    putStr(out, fullPath);
+    putI64(out, script.stamp.mtime);
+    putI64(out, script.stamp.size);
+    putU32(out, (uint32_t)script.ops.size());
+    for (const auto& op : script.ops) {
+        putU32(out, op.line);
+        putStr(out, op.error);
+        if (op.error.empty()) putList(out, op.list);
+    }
+
+    // Write then rename, so a reader never sees half a file
+    std::string tmp = file + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f.write(out.data(), out.size())) return;
+    }
+#ifdef _WIN32
+    std::remove(file.c_str());
+#endif
+    if (std::rename(tmp.c_str(), file.c_str()) != 0) std::remove(tmp.c_str());
+}
+
+std::shared_ptr<CompiledScript> readDiskCache(const std::string& file, const std::string& fullPath, const FileStamp& stamp) {
+    std::ifstream f(file, std::ios::binary | std::ios::ate);
+    if (!f) return nullptr;
+    std::string data((size_t)f.tellg(), '\0');
+    f.seekg(0);
+    if (!f.read(&data[0], data.size())) return nullptr;
+
+    Reader in(data);
+    char magic[sizeof(kMagic)];
+    std::string source;
+    FileStamp cached;
+    uint32_t count;
+    if (!in.raw(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !in.str(source) || source != fullPath ||
+        !in.i64(cached.mtime) || !in.i64(cached.size) || !(cached == stamp) ||
+        !in.u32(count) || count > data.size()) {
+        return nullptr;
+    }
+
+    auto script = std::make_shared<CompiledScript>();
+    script->ops.resize(count);
+    for (auto& op : script->ops) {
+        if (!in.u32(op.line) || !in.str(op.error)) return nullptr;
+        if (op.error.empty() && !readList(in, op.list, 0)) return nullptr;
+        bind(op);
+    }
+    return script;
+}
+
+// --- In-memory LRU ---
+
+// Keyed by the absolute path: `./x.sh` names another file after a `cd`
+ScriptPtr load(const std::string& path) {
+    FileStamp stamp;
+    if (!stampOf(path, stamp)) return nullptr;
+
+    std::string fullPath = absolutePath(path);
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = byPath.find(fullPath);
+        if (it != byPath.end()) {
+            if (it->second->second->stamp == stamp) {
+                lru.splice(lru.begin(), lru, it->second);
+                return it->second->second;
+            }
+            lru.erase(it->second);   // the file changed since it was compiled
+            byPath.erase(it);
+        }
+    }
+
+    std::string cacheFile = cacheFileFor(fullPath);
+    std::shared_ptr<CompiledScript> script;
+    if (!cacheFile.empty()) script = readDiskCache(cacheFile, fullPath, stamp);
+    if (!script) {
+        std::ifstream f(path, std::ios::binary);
+        if (!f) return nullptr;
+        std::ostringstream text;
+        text << f.rdbuf();
+        script = compile(text.str());
+        script->stamp = stamp;
+        if (!cacheFile.empty()) writeDiskCache(cacheFile, fullPath, *script);
+    }
+    script->stamp = stamp;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (byPath.count(fullPath) == 0) {
+        lru.emplace_front(fullPath, script);
+        byPath[fullPath] = lru.begin();
+        if (lru.size() > kMaxScripts) {
+            byPath.erase(lru.back().first);
+            lru.pop_back();
+        }
+    }
+    return script;
+}
+
+} // namespace
+
+int run_script(const std::string &path) {
+    // Held for the whole run: a nested script may evict this one from the LRU
+    ScriptPtr script = load(path);
+    if (!script) return -1;
+
+    int status = 0;
+    for (const auto& op : script->ops) {
+        if (!op.error.empty()) {
+            // As sh does, a syntax error ends the script
+            std::cerr << path << ": line " << op.line << ": Syntax error: " << op.error << "\n";
+            set_last_status(2);
+            return 2;
+        }
+        if (op.builtin) status = executeBuiltin(*op.builtin, *loneCommand(op.list));
+        else status = executeList(op.list);
+    }
+    return status;
+}
@@ -0,0 +1,282 @@
+#include "../include/stream_pipe.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// --- ChunkRing ---
+
+ChunkRing::ChunkRing(size_t slotCount) : slots(slotCount ? slotCount : 1) {}
+
+ChunkPtr ChunkRing::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!freeList.empty()) {
+            ChunkPtr chunk = freeList.back();
+            freeList.pop_back();
+            chunk->size = 0;
+            return chunk;
+        }
+    }
+    return std::make_shared<Chunk>();
+}
+
+bool ChunkRing::push(ChunkPtr chunk) {
+    std::unique_lock<std::mutex> lock(mtx);
+    notFull.wait(lock, [this] { return count < slots.size() || readClosed; });
+    if (readClosed) return false;
+
+    slots[(head + count) % slots.size()] = std::move(chunk);
+    ++count;
+    notEmpty.notify_one();
+    return true;
+}
+
+ChunkPtr ChunkRing::pop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    notEmpty.wait(lock, [this] { return count > 0 || writeClosed; });
+    if (count == 0) return nullptr;
+
+    ChunkPtr chunk = std::move(slots[head]);
+    head = (head + 1) % slots.size();
+    --count;
+    notFull.notify_one();
+    return chunk;
+}
+
+void ChunkRing::recycle(ChunkPtr chunk) {
+    // Only reuse a chunk nobody else still references
+    if (!chunk || chunk.use_count() != 1) return;
+    std::lock_guard<std::mutex> lock(mtx);
+    if (freeList.size() < 2) freeList.push_back(std::move(chunk));
+}
+
+void ChunkRing::closeWrite() {
+    std::lock_guard<std::mutex> lock(mtx);
+    writeClosed = true;
+    notEmpty.notify_all();
+}
+
+void ChunkRing::closeRead() {
+    std::lock_guard<std::mutex> lock(mtx);
+    readClosed = true;
+    for (auto& slot : slots) slot.reset();
+    count = 0;
+    notFull.notify_all();
+}
+
+// --- RingOutBuf ---
+
+RingOutBuf::RingOutBuf(std::shared_ptr<ChunkRing> r) : ring(std::move(r)) {}
+
+RingOutBuf::~RingOutBuf() {
+    close();
+}
+
+bool RingOutBuf::flushChunk() {
+    if (!current) return true;
+    current->size = pptr() - pbase();
+    setp(nullptr, nullptr);
+    if (current->size == 0) return true; // keep the empty chunk for next time
+
+    ChunkPtr full = std::move(current);
+    return ring->push(std::move(full));
+}
+
+RingOutBuf::int_type RingOutBuf::overflow(int_type ch) {
+    if (closed || !flushChunk()) return traits_type::eof();
+
+    if (!current) current = ring->acquire();
+    setp(current->data.get(), current->data.get() + Chunk::kCapacity);
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int RingOutBuf::sync() {
+    if (closed) return -1;
+    return flushChunk() ? 0 : -1;
+}
+
+bool RingOutBuf::forward(ChunkPtr chunk) {
+    if (closed || !flushChunk()) return false;
+    return ring->push(std::move(chunk));
+}
+
+void RingOutBuf::close() {
+    if (closed) return;
+    flushChunk();
+    closed = true;
+    current.reset();
+    ring->closeWrite();
+}
+
+// --- RingInBuf ---
+
+RingInBuf::RingInBuf(std::shared_ptr<ChunkRing> r) : ring(std::move(r)) {}
+
+RingInBuf::~RingInBuf() {
+    close();
+}
+
+RingInBuf::int_type RingInBuf::underflow() {
+    if (closed) return traits_type::eof();
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    ring->recycle(std::move(current));
+    do {
+        current = ring->pop();
+        if (!current) {
+            setg(nullptr, nullptr, nullptr);
+            return traits_type::eof();
+        }
+    } while (current->size == 0);
+
+    char* base = current->data.get();
+    setg(base, base, base + current->size);
+    return traits_type::to_int_type(*gptr());
+}
+
+bool RingInBuf::forwardTo(RingOutBuf& out) {
+    if (closed) return true;
+
+    // Whatever was already partly read goes the ordinary way
+    std::streamsize rest = egptr() - gptr();
+    if (rest > 0 && out.sputn(gptr(), rest) != rest) return false;
+    setg(nullptr, nullptr, nullptr);
+    current.reset();
+
+    while (ChunkPtr chunk = ring->pop()) {
+        if (!out.forward(std::move(chunk))) return false;
+    }
+    return true;
+}
+
+void RingInBuf::close() {
+    if (closed) return;
+    closed = true;
+    setg(nullptr, nullptr, nullptr);
+    current.reset();
+    ring->closeRead();
+}
+
+// --- HandleBuf ---
+
+HandleBuf::HandleBuf(os_handle h, bool out) : handle(h), output(out) {
+    if (output) {
+        setp(buffer.get(), buffer.get() + Chunk::kCapacity);
+    }
+}
+
+HandleBuf::~HandleBuf() {
+    close();
+}
+
+bool HandleBuf::flushBuffer() {
+    const char* p = pbase();
+    size_t left = pptr() - pbase();
+    setp(buffer.get(), buffer.get() + Chunk::kCapacity);
+
+    while (left > 0) {
+#ifdef _WIN32
+        DWORD written = 0;
+        if (!WriteFile(handle, p, (DWORD)left, &written, nullptr)) return false;
+#else
+        ssize_t written = write(handle, p, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false; // EPIPE: the reader went away
+        }
+#endif
+        p += written;
+        left -= written;
+    }
+    return true;
+}
+
+HandleBuf::int_type HandleBuf::overflow(int_type ch) {
+    if (!output || closed || !flushBuffer()) return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+HandleBuf::int_type HandleBuf::underflow() {
+    if (output || closed) return traits_type::eof();
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+#ifdef _WIN32
+    DWORD got = 0;
+    // A broken pipe is just end of stream for the reader
+    if (!ReadFile(handle, buffer.get(), (DWORD)Chunk::kCapacity, &got, nullptr)) got = 0;
+#else
+    ssize_t got;
+    do {
+        got = read(handle, buffer.get(), Chunk::kCapacity);
+    } while (got < 0 && errno == EINTR);
+    if (got < 0) got = 0;
+#endif
+    if (got == 0) return traits_type::eof();
+
+    setg(buffer.get(), buffer.get(), buffer.get() + got);
+    return traits_type::to_int_type(*gptr());
+}
+
+int HandleBuf::sync() {
+    if (!output || closed) return 0;
+    return flushBuffer() ? 0 : -1;
+}
+
+void HandleBuf::close() {
+    if (closed) return;
+    if (output) flushBuffer();
+    closed = true;
+#ifdef _WIN32
+    CloseHandle(handle);
+#else
+    ::close(handle);
+#endif
+}
+
+// std::cout's own buffer, taken before anything can redirect it
+static std::streambuf* const console = std::cout.rdbuf();
+
+os_handle stream_output_handle(std::ostream& out) {
+    os_handle handle = kNoHandle;
+    if (auto* hb = dynamic_cast<HandleBuf*>(out.rdbuf())) {
+        handle = hb->native();
+    } else if (out.rdbuf() == console) {
+#ifdef _WIN32
+        handle = GetStdHandle(STD_OUTPUT_HANDLE);
+#else
+        handle = STDOUT_FILENO;
+#endif
+    }
+    if (handle != kNoHandle && !out.flush()) return kNoHandle;
+    return handle;
+}
+
+bool copy_stream(std::istream& in, std::ostream& out) {
+    auto* ringIn = dynamic_cast<RingInBuf*>(in.rdbuf());
+    auto* ringOut = dynamic_cast<RingOutBuf*>(out.rdbuf());
+    if (ringIn && ringOut) {
+        if (ringIn->forwardTo(*ringOut)) return true;
+        out.setstate(std::ios::badbit);
+        return false;
+    }
+
+    // operator<< would flag an empty source as a failed insertion
+    if (in.rdbuf()->sgetc() == std::streambuf::traits_type::eof()) return true;
+
+    // Streambuf-to-streambuf insertion moves whole get areas into the put area
+    out << in.rdbuf();
+    return static_cast<bool>(out);
+}
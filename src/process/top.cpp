@@ -0,0 +1,263 @@
+#include "../include/top.h"
+#include "../include/job_table.h"
+#include "../include/key_reader.h"
+#include "../include/proc_snapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int kHeaderLines = 4;
+
+struct TopRow {
+    ProcSample sample;
+    double cpu = 0;                 // percent of one CPU since the last frame
+    int job = 0;                    // managed job id, 0 if not ours
+};
+
+bool stdoutIsTerminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdout)) != 0;
+#else
+    return isatty(STDOUT_FILENO) != 0;
+#endif
+}
+
+void terminalSize(int& width, int& height) {
+    width = 80;
+    height = 24;
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+        width = info.srWindow.Right - info.srWindow.Left + 1;
+        height = info.srWindow.Bottom - info.srWindow.Top + 1;
+    }
+#else
+    winsize ws{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0) {
+        width = ws.ws_col;
+        height = ws.ws_row;
+    }
+#endif
+}
+
+// Keeps what is on the screen and turns a new frame into the escape codes
+// that change only the cells that differ
+class Screen {
+public:
+    std::string update(const std::vector<std::string>& lines) {
+        std::string out;
+        size_t rows = std::max(lines.size(), shown.size());
+        for (size_t row = 0; row < rows; ++row) {
+            const std::string& now = row < lines.size() ? lines[row] : empty;
+            const std::string& was = row < shown.size() ? shown[row] : empty;
+            if (now == was) continue;
+
+            size_t first = 0;
+            while (first < now.size() && first < was.size() && now[first] == was[first]) ++first;
+            size_t end = now.size();
+            if (now.size() == was.size()) {
+                while (end > first && now[end - 1] == was[end - 1]) --end;
+            }
+            out += "\033[" + std::to_string(row + 1) + ";" + std::to_string(first + 1) + "H";
+            out.append(now, first, end - first);
+            if (now.size() < was.size()) out += "\033[K";
+        }
+        shown = lines;
+        return out;
+    }
+
+    // The screen was cleared behind our back
+    void forget() { shown.clear(); }
+
+private:
+    std::vector<std::string> shown;
+    std::string empty;
+};
+
+class TopView {
+public:
+    explicit TopView(const TopOptions& options) : jobsOnly(options.jobsOnly), interval(options.interval) {}
+
+    // A new snapshot; CPU% is measured against the previous one
+    void sample() {
+        std::vector<ProcSample> procs = take_proc_snapshot();
+        auto now = Clock::now();
+        double ticks = proc_ticks_per_second();
+        double elapsed = std::chrono::duration<double>(now - lastSample).count() * ticks;
+        uint64_t uptime = first ? proc_uptime_ticks() : 0;
+
+        std::unordered_map<proc_id, int> managed;
+        for (const auto& p : job_table().snapshot()) managed[p.pid] = p.job_id;
+
+        std::unordered_map<proc_id, uint64_t> ticksNow;
+        ticksNow.reserve(procs.size());
+        rows.clear();
+        rows.reserve(procs.size());
+        running = 0;
+        totalCpu = 0;
+        for (auto& p : procs) {
+            TopRow row;
+            if (first) {
+                // Nothing to compare with yet: the lifetime average, as `list` shows
+                uint64_t age = uptime > p.start_ticks ? uptime - p.start_ticks : 0;
+                row.cpu = age ? 100.0 * p.cpu_ticks / age : 0;
+            } else {
+                auto it = lastTicks.find(p.pid);
+                // A pid not seen last frame started since then: all its ticks are new
+                uint64_t before = it == lastTicks.end() || it->second > p.cpu_ticks ? 0 : it->second;
+                row.cpu = elapsed > 0 ? 100.0 * (p.cpu_ticks - before) / elapsed : 0;
+            }
+            auto job = managed.find(p.pid);
+            row.job = job == managed.end() ? 0 : job->second;
+            running += p.state == 'R';
+            totalCpu += row.cpu;
+            ticksNow.emplace(p.pid, p.cpu_ticks);
+            row.sample = std::move(p);
+            rows.push_back(std::move(row));
+        }
+        lastTicks.swap(ticksNow);
+        lastSample = now;
+        first = false;
+    }
+
+    // false to quit
+    bool key(int c) {
+        switch (c) {
+            case 'c': case 'P': sort = ListOptions::BY_CPU; break;
+            case 'm': case 'M': sort = ListOptions::BY_MEM; break;
+            case 'p': case 'N': sort = ListOptions::BY_PID; break;
+            case 'j': jobsOnly = !jobsOnly; break;
+            case 'q': case 'Q': case 3: case KeyReader::kClosed: return false;
+        }
+        return true;
+    }
+
+    // The frame as screen lines, at most `height` of them and `width` wide
+    std::vector<std::string> render(int width, int height) {
+        std::vector<const TopRow*> shown;
+        for (const auto& row : rows) {
+            if (!jobsOnly || row.job) shown.push_back(&row);
+        }
+        size_t space = height > kHeaderLines ? height - kHeaderLines : 0;
+        auto order = [this](const TopRow* a, const TopRow* b) {
+            if (sort == ListOptions::BY_CPU && a->cpu != b->cpu) return a->cpu > b->cpu;
+            if (sort == ListOptions::BY_MEM && a->sample.rss_kb != b->sample.rss_kb) return a->sample.rss_kb > b->sample.rss_kb;
+            return a->sample.pid < b->sample.pid;
+        };
+        if (shown.size() > space) {
+            std::partial_sort(shown.begin(), shown.begin() + space, shown.end(), order);
+            shown.resize(space);
+        } else {
+            std::sort(shown.begin(), shown.end(), order);
+        }
+
+        std::vector<std::string> lines;
+        char buf[256];
+        std::time_t now = std::time(nullptr);
+        char clock[16];
+        std::strftime(clock, sizeof(clock), "%H:%M:%S", std::localtime(&now));
+        unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        std::snprintf(buf, sizeof(buf), "top - %s   %zu processes, %d running   CPU %.1f%% of %u   every %.1fs",
+                      clock, rows.size(), running, totalCpu / cpus, cpus, interval);
+        lines.push_back(buf);
+        static const char* sortNames[] = {"pid", "cpu", "mem"};
+        std::snprintf(buf, sizeof(buf), "Sort: %s   Showing: %s   [c]pu [m]em [p]id  [j]obs only  [q]uit",
+                      sortNames[sort], jobsOnly ? "shell jobs" : "all");
+        lines.push_back(buf);
+        lines.push_back("");
+        lines.push_back("PID     PPID    JOB  S   CPU%   MEM%       RSS  THR  NAME");
+
+        double totalKb = (double)proc_total_memory_kb();
+        for (const TopRow* row : shown) {
+            const ProcSample& p = row->sample;
+            std::string job = row->job ? "%" + std::to_string(row->job) : "";
+            std::snprintf(buf, sizeof(buf), "%-7d %-7d %-4s %c %6.1f %6.1f %9.1fM %4d  %s",
+                          (int)p.pid, (int)p.ppid, job.c_str(), p.state, row->cpu,
+                          totalKb > 0 ? 100.0 * p.rss_kb / totalKb : 0.0, p.rss_kb / 1024.0, p.threads, p.name.c_str());
+            lines.push_back(buf);
+        }
+
+        for (auto& line : lines) {
+            // One byte per column, so that the diff's cursor positions hold
+            for (auto& c : line) {
+                if ((unsigned char)c < ' ' || (unsigned char)c > '~') c = '?';
+            }
+            if ((int)line.size() > width) line.resize(width);
+        }
+        return lines;
+    }
+
+private:
+    std::vector<TopRow> rows;
+    std::unordered_map<proc_id, uint64_t> lastTicks;
+    Clock::time_point lastSample;
+    bool first = true;
+    bool jobsOnly;
+    double interval;
+    ListOptions::Sort sort = ListOptions::BY_CPU;
+    int running = 0;
+    double totalCpu = 0;
+};
+
+} // namespace
+
+int run_top(const TopOptions& options) {
+    TopView view(options);
+    bool terminal = stdoutIsTerminal();
+    KeyReader keys;
+    Screen screen;
+    auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.interval));
+
+    if (terminal) std::cout << "\033[?1049h\033[?25l\033[2J" << std::flush;   // alternate screen, no cursor
+    int width = 0, height = 0;
+    bool quit = false;
+    for (int frame = 0; !quit && (options.frames == 0 || frame < options.frames); ++frame) {
+        auto deadline = Clock::now() + interval;
+        view.sample();
+        while (true) {
+            if (terminal) {
+                int w, h;
+                terminalSize(w, h);
+                if (w != width || h != height) {
+                    // Resized: what the diff remembers is no longer on the screen
+                    width = w;
+                    height = h;
+                    screen.forget();
+                    std::cout << "\033[2J";
+                }
+                std::cout << screen.update(view.render(width, height)) << std::flush;
+            } else {
+                for (const auto& line : view.render(200, 1 << 30)) std::cout << line << "\n";
+                std::cout << std::endl;
+            }
+            if (options.frames && frame + 1 == options.frames) break;
+
+            int c = keys.next(deadline);
+            if (c == KeyReader::kNone) break;
+            if (!view.key(c)) {
+                quit = true;
+                break;
+            }
+        }
+    }
+    if (terminal) std::cout << "\033[?25h\033[?1049l" << std::flush;
+    return 0;
+}
@@ -0,0 +1,511 @@
+#include "../include/watch.h"
+#include "../include/job_table.h"
+#include "../include/proc_snapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+static_assert(sizeof(WatchFileHeader) == 16, "WatchFileHeader is part of the file format");
+static_assert(sizeof(WatchRecord) == 64, "WatchRecord is part of the file format");
+
+const char kMagic[4] = {'T', 'S', 'W', '1'};
+const uint32_t kMinIntervalUs = 10000;
+const auto kFlushEvery = std::chrono::seconds(1);
+
+typedef std::chrono::steady_clock Clock;
+
+// One watched process and what stays open for it
+struct Target {
+    proc_id pid = 0;
+#ifdef _WIN32
+    HANDLE process = NULL;
+#else
+    int statFd = -1;
+    int ioFd = -1;                  // -1 when /proc/<pid>/io is not ours to read
+#endif
+};
+
+#ifdef _WIN32
+
+bool openTarget(Target& t) {
+    t.process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, t.pid);
+    return t.process != NULL;
+}
+
+void closeTarget(Target& t) {
+    if (t.process) CloseHandle(t.process);
+    t.process = NULL;
+}
+
+// false once the process has exited
+bool sampleTarget(const Target& t, WatchRecord& r) {
+    DWORD code;
+    if (!GetExitCodeProcess(t.process, &code) || code != STILL_ACTIVE) return false;
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(t.process, &created, &exited, &kernel, &user)) {
+        auto ticks = [](const FILETIME& f) { return (uint64_t)f.dwHighDateTime << 32 | f.dwLowDateTime; };
+        r.cpu_ticks = ticks(kernel) + ticks(user);
+    }
+    PROCESS_MEMORY_COUNTERS mem;
+    if (GetProcessMemoryInfo(t.process, &mem, sizeof(mem))) r.rss_kb = mem.WorkingSetSize / 1024;
+    IO_COUNTERS io;
+    if (GetProcessIoCounters(t.process, &io)) {
+        // Windows does not tell storage apart from pipes and devices
+        r.read_chars = r.read_bytes = io.ReadTransferCount;
+        r.write_chars = r.write_bytes = io.WriteTransferCount;
+    }
+    return true;
+}
+
+#else
+
+bool openTarget(Target& t) {
+    char path[48];
+    std::snprintf(path, sizeof(path), "/proc/%d/stat", (int)t.pid);
+    t.statFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (t.statFd < 0) return false;
+    std::snprintf(path, sizeof(path), "/proc/%d/io", (int)t.pid);
+    t.ioFd = open(path, O_RDONLY | O_CLOEXEC);
+    return true;
+}
+
+void closeTarget(Target& t) {
+    if (t.statFd >= 0) close(t.statFd);
+    if (t.ioFd >= 0) close(t.ioFd);
+    t.statFd = t.ioFd = -1;
+}
+
+// false once the process has exited. The descriptors stay bound to the
+// process they were opened for: a recycled pid reads as gone, not as a
+// stranger.
+bool sampleTarget(const Target& t, WatchRecord& r) {
+    static const uint64_t pageKb = sysconf(_SC_PAGESIZE) / 1024;
+    char buf[1024];
+    ssize_t n = pread(t.statFd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return false;
+    buf[n] = '\0';
+    char* p = std::strrchr(buf, ')');   // the name itself may contain ')'
+    if (!p || p + 2 >= buf + n || p[2] == 'Z' || p[2] == 'X') return false;
+    p += 3;
+    uint64_t utime = 0;
+    for (int field = 4; field <= 24; ++field) {
+        uint64_t value = std::strtoull(p, &p, 10);
+        switch (field) {
+            case 14: utime = value; break;
+            case 15: r.cpu_ticks = utime + value; break;
+            case 20: r.threads = (uint32_t)value; break;
+            case 24: r.rss_kb = value * pageKb; break;
+        }
+    }
+
+    if (t.ioFd >= 0 && (n = pread(t.ioFd, buf, sizeof(buf) - 1, 0)) > 0) {
+        buf[n] = '\0';
+        char* line = buf;
+        while (char* colon = std::strchr(line, ':')) {
+            *colon = '\0';
+            uint64_t value = std::strtoull(colon + 1, &p, 10);
+            if (!std::strcmp(line, "rchar")) r.read_chars = value;
+            else if (!std::strcmp(line, "wchar")) r.write_chars = value;
+            else if (!std::strcmp(line, "read_bytes")) r.read_bytes = value;
+            else if (!std::strcmp(line, "write_bytes")) r.write_bytes = value;
+            line = p + (*p == '\n');
+        }
+    }
+    return true;
+}
+
+#endif
+
+struct Watch {
+    int id = 0;
+    std::string what;               // the target as given: "1234" or "%2"
+    std::string file;
+    std::chrono::microseconds interval;
+    Clock::time_point due;
+    Clock::time_point flushed;
+    std::ofstream out;
+    std::vector<Target> targets;
+    std::vector<WatchRecord> pending;
+    uint64_t samples = 0;
+
+    ~Watch() {
+        flush();
+        for (auto& t : targets) closeTarget(t);
+    }
+
+    void flush() {
+        if (!pending.empty()) {
+            out.write(reinterpret_cast<const char*>(pending.data()), pending.size() * sizeof(WatchRecord));
+            out.flush();
+            pending.clear();
+        }
+        flushed = Clock::now();
+    }
+
+    // Samples every process still alive; false once none is
+    bool sample() {
+        int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        for (size_t i = 0; i < targets.size();) {
+            WatchRecord r{};
+            r.when_us = now;
+            r.pid = (uint32_t)targets[i].pid;
+            if (sampleTarget(targets[i], r)) {
+                pending.push_back(r);
+                ++i;
+            } else {
+                closeTarget(targets[i]);
+                targets.erase(targets.begin() + i);
+            }
+        }
+        ++samples;
+        return !targets.empty();
+    }
+};
+
+// The one thread that samples for every watch
+class Sampler {
+public:
+    ~Sampler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_one();
+        if (thread.joinable()) thread.join();
+    }
+
+    int add(std::unique_ptr<Watch> w) {
+        std::lock_guard<std::mutex> lock(mutex);
+        w->id = nextId++;
+        w->due = w->flushed = Clock::now();
+        int id = w->id;
+        watches.push_back(std::move(w));
+        if (!thread.joinable()) thread = std::thread(&Sampler::loop, this);
+        wake.notify_one();
+        return id;
+    }
+
+    // 0 ends every watch; false when there is no such watch
+    bool stop(int id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t before = watches.size();
+        watches.erase(std::remove_if(watches.begin(), watches.end(),
+                                     [id](const std::unique_ptr<Watch>& w) { return id == 0 || w->id == id; }),
+                      watches.end());
+        return watches.size() != before;
+    }
+
+    void list(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (watches.empty()) {
+            out << "No watches running.\n";
+            return;
+        }
+        out << std::left << std::setw(5) << "ID" << std::setw(10) << "Target" << std::setw(11) << "Processes"
+            << std::setw(10) << "Interval" << std::setw(10) << "Samples" << "File\n";
+        for (const auto& w : watches) {
+            out << std::setw(5) << w->id << std::setw(10) << w->what << std::setw(11) << w->targets.size()
+                << std::setw(10) << (std::to_string(w->interval.count() / 1000) + "ms") << std::setw(10) << w->samples
+                << w->file << "\n";
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::unique_ptr<Watch>> watches;
+    std::thread thread;
+    bool quit = false;
+    int nextId = 1;
+
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!quit) {
+            if (watches.empty()) {
+                wake.wait(lock);
+                continue;
+            }
+            Clock::time_point next = watches[0]->due;
+            for (const auto& w : watches) next = std::min(next, w->due);
+            if (Clock::now() < next) {
+                wake.wait_until(lock, next);
+                continue;
+            }
+
+            Clock::time_point now = Clock::now();
+            for (size_t i = 0; i < watches.size();) {
+                Watch& w = *watches[i];
+                if (w.due > now) {
+                    ++i;
+                    continue;
+                }
+                bool alive = w.sample();
+                // A late wake-up skips the samples it missed rather than bunching them
+                w.due += w.interval;
+                if (w.due <= now) w.due = now + w.interval;
+                if (!alive) {
+                    watches.erase(watches.begin() + i);   // flushes and closes
+                    continue;
+                }
+                if (now - w.flushed >= kFlushEvery) w.flush();
+                ++i;
+            }
+        }
+    }
+};
+
+Sampler& sampler() {
+    static Sampler instance;
+    return instance;
+}
+
+// "100ms", "2s", "1m"; a bare number is seconds
+bool parseInterval(const std::string& text, std::chrono::microseconds& interval) {
+    char* end;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value <= 0) return false;
+    std::string unit(end);
+    double us;
+    if (unit == "ms") us = value * 1e3;
+    else if (unit == "s" || unit.empty()) us = value * 1e6;
+    else if (unit == "m") us = value * 60e6;
+    else return false;
+    if (us < kMinIntervalUs || us > 3600e6) return false;
+    interval = std::chrono::microseconds((int64_t)us);
+    return true;
+}
+
+// Opens `file` for appending, writing the header when it is new; false
+// (after printing why) if it exists but is not a watch file
+bool openOutput(const std::string& file, uint32_t intervalUs, std::ofstream& out) {
+    WatchFileHeader header{};
+    bool fresh = true;
+    {
+        std::ifstream in(file, std::ios::binary);
+        if (in && in.peek() != std::ifstream::traits_type::eof()) {
+            fresh = false;
+            if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+                std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.recordSize != sizeof(WatchRecord)) {
+                std::cerr << "watch: " << file << " exists and is not a watch file\n";
+                return false;
+            }
+        }
+    }
+    out.open(file, std::ios::binary | std::ios::app);
+    if (!out) {
+        std::cerr << "watch: cannot write " << file << "\n";
+        return false;
+    }
+    if (fresh) {
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.recordSize = sizeof(WatchRecord);
+        header.ticksPerSecond = (uint32_t)proc_ticks_per_second();
+        header.intervalUs = intervalUs;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.flush();
+    }
+    return true;
+}
+
+int startWatch(const std::vector<std::string>& args) {
+    std::string what, file;
+    std::chrono::microseconds interval(1000000);
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "--interval" && i + 1 < args.size()) {
+            if (!parseInterval(args[++i], interval)) {
+                std::cerr << "watch: bad interval '" << args[i] << "' (use e.g. 100ms or 2s; at least 10ms)\n";
+                return 1;
+            }
+        } else if (args[i] == "--out" && i + 1 < args.size()) {
+            file = args[++i];
+        } else if (what.empty() && args[i][0] != '-') {
+            what = args[i];
+        } else {
+            what.clear();
+            break;
+        }
+    }
+    if (what.empty() || file.empty()) {
+        std::cerr << "Usage: watch <pid|%job> [--interval T] --out FILE | watch --summary FILE | watch --stop <id|all>\n";
+        return 1;
+    }
+
+    std::vector<proc_id> pids;
+    int job;
+    if (parse_job_spec(what, job)) {
+        for (const auto& p : job_table().job(job)) {
+            if (p.status != ProcessStatus::Done) pids.push_back(p.pid);
+        }
+    } else {
+        char* end;
+        long pid = std::strtol(what.c_str(), &end, 10);
+        if (*end != '\0' || pid <= 0) {
+            std::cerr << "watch: '" << what << "' is neither a pid nor a %job\n";
+            return 1;
+        }
+        pids.push_back((proc_id)pid);
+    }
+
+    auto w = std::unique_ptr<Watch>(new Watch);
+    w->what = what;
+    w->file = file;
+    w->interval = interval;
+    for (proc_id pid : pids) {
+        Target t;
+        t.pid = pid;
+        if (openTarget(t)) w->targets.push_back(t);
+    }
+    if (w->targets.empty()) {
+        std::cerr << "watch: no running process for " << what << "\n";
+        return 1;
+    }
+    if (!openOutput(file, (uint32_t)interval.count(), w->out)) return 1;
+
+    size_t count = w->targets.size();
+    int id = sampler().add(std::move(w));
+    std::cout << "[watch " << id << "] " << what << " (" << count << (count == 1 ? " process" : " processes")
+              << ") every " << interval.count() / 1000 << "ms into " << file << "\n";
+    return 0;
+}
+
+// --- Summary ---
+
+std::string bytesText(uint64_t bytes) {
+    const char* units = "BKMGT";
+    double value = (double)bytes;
+    int unit = 0;
+    while (value >= 1024 && unit < 4) {
+        value /= 1024;
+        ++unit;
+    }
+    std::ostringstream out;
+    if (unit == 0) out << bytes << "B";
+    else out << std::fixed << std::setprecision(value < 10 ? 1 : 0) << value << units[unit];
+    return out.str();
+}
+
+// Nearest-rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double pct) {
+    size_t rank = (size_t)std::ceil(pct / 100 * sorted.size());
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+// `decimals` < 0 prints the values as sizes in KiB
+void printRow(std::ostream& out, const char* label, std::vector<double> values, int decimals) {
+    if (values.empty()) return;
+    std::sort(values.begin(), values.end());
+    double columns[] = {values.front(), percentile(values, 50), percentile(values, 90), percentile(values, 99), values.back()};
+    out << std::left << std::setw(10) << label << std::right;
+    for (double v : columns) {
+        std::ostringstream cell;
+        if (decimals < 0) cell << bytesText((uint64_t)v * 1024);
+        else cell << std::fixed << std::setprecision(decimals) << v;
+        out << std::setw(9) << cell.str();
+    }
+    out << "\n";
+}
+
+int summarize(const std::string& file) {
+    std::ifstream in(file, std::ios::binary);
+    WatchFileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.recordSize != sizeof(WatchRecord)) {
+        std::cerr << "watch: " << file << (in ? " is not a watch file\n" : ": cannot read\n");
+        return 1;
+    }
+
+    std::map<uint32_t, std::vector<WatchRecord>> byPid;
+    WatchRecord r;
+    while (in.read(reinterpret_cast<char*>(&r), sizeof(r))) byPid[r.pid].push_back(r);
+    if (byPid.empty()) {
+        std::cout << file << ": no samples\n";
+        return 0;
+    }
+
+    std::ostringstream out;
+    for (auto& entry : byPid) {
+        auto& samples = entry.second;
+        std::sort(samples.begin(), samples.end(),
+                  [](const WatchRecord& a, const WatchRecord& b) { return a.when_us < b.when_us; });
+        const WatchRecord& first = samples.front();
+        const WatchRecord& last = samples.back();
+        double span = (last.when_us - first.when_us) / 1e6;
+
+        std::vector<double> cpu, rss, threads;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            rss.push_back((double)samples[i].rss_kb);
+            threads.push_back((double)samples[i].threads);
+            if (i == 0) continue;
+            double seconds = (samples[i].when_us - samples[i - 1].when_us) / 1e6;
+            uint64_t ticks = samples[i].cpu_ticks - std::min(samples[i].cpu_ticks, samples[i - 1].cpu_ticks);
+            if (seconds > 0) cpu.push_back(100.0 * ticks / header.ticksPerSecond / seconds);
+        }
+
+        out << "PID " << entry.first << ": " << samples.size() << " samples over " << std::fixed
+            << std::setprecision(1) << span << "s\n";
+        out << std::left << std::setw(10) << "" << std::right;
+        for (const char* h : {"min", "p50", "p90", "p99", "max"}) out << std::setw(9) << h;
+        out << "\n";
+        printRow(out, "CPU%", cpu, 1);
+        printRow(out, "RSS", rss, -1);
+        if (last.threads) printRow(out, "Threads", threads, 0);
+        out << std::left << std::setw(10) << "I/O" << "read " << bytesText(last.read_chars - first.read_chars)
+            << " (" << bytesText(last.read_bytes - first.read_bytes) << " from storage), written "
+            << bytesText(last.write_chars - first.write_chars) << " (" << bytesText(last.write_bytes - first.write_bytes)
+            << " to storage)\n\n";
+    }
+    std::cout << out.str();
+    return 0;
+}
+
+} // namespace
+
+int run_watch(const std::vector<std::string>& args) {
+    if (args.size() == 1) {
+        sampler().list(std::cout);
+        return 0;
+    }
+    if (args[1] == "--summary") {
+        if (args.size() != 3) {
+            std::cerr << "Usage: watch --summary FILE\n";
+            return 1;
+        }
+        return summarize(args[2]);
+    }
+    if (args[1] == "--stop") {
+        char* end = nullptr;
+        long id = args.size() == 3 ? (args[2] == "all" ? 0 : std::strtol(args[2].c_str(), &end, 10)) : -1;
+        if (id < 0 || (end && (*end != '\0' || id == 0))) {
+            std::cerr << "Usage: watch --stop <id|all>\n";
+            return 1;
+        }
+        if (!sampler().stop((int)id) && id != 0) {
+            std::cerr << "watch: no such watch: " << args[2] << "\n";
+            return 1;
+        }
+        return 0;
+    }
+    return startWatch(args);
+}
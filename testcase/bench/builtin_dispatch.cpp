@@ -0,0 +1,90 @@
+// Cost of deciding what a command name is and finding its handler, per line
+// of a 1M-line script: the old `is_builtin` + `run_builtin` string chains
+// against the registry's perfect-hash lookup. Handlers are not run; only the
+// lookup is timed. Lines mix built-ins from across the table with external
+// commands, which walk the whole chain before falling through.
+//
+// Built and run by builtin_dispatch.sh.
+
+#include "builtin.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+// The shell's main.cpp provides these; the benchmark never calls them
+pid_t g_currentProcess = 0;
+void animateFirework() {}
+void clear_all_command_history() {}
+const std::vector<std::string>& get_command_history() {
+    static std::vector<std::string> none;
+    return none;
+}
+
+// The dispatch as it was before the registry
+static bool legacy_is_builtin(const std::string& cmd) {
+    return cmd == "cd" || cmd == "exit" || cmd == "pwd" || cmd == "echo" ||
+           cmd == "help" || cmd == "list" || cmd == "kill" || cmd == "stop" ||
+           cmd == "resume" || cmd == "date" || cmd == "dir" || cmd == "cls" ||
+           cmd == "path" || cmd == "addpath" || cmd == "hash" || cmd == "mlist" || cmd == "pinfo" ||
+           cmd == "monitor" || cmd == "stopmonitor" || cmd == "monitor_silent" ||
+           cmd == "mkdir" || cmd == "rmdir" || cmd == "touch" || cmd == "rm" || cmd == "cat" || cmd == "REM" ||
+           cmd == "fireworks" || cmd == "snake" ||
+           cmd == "worktime" || cmd == "cpuinfo" || cmd == "meminfo" || cmd == "diskinfo" ||
+           cmd == "history" || cmd == "clear_history" ||
+           cmd == "calculate" || cmd == "convert" ||
+           cmd == "location" || cmd == "weather" ||
+           cmd == "mines" || cmd == "hangman" || cmd == "nyancat";
+}
+
+static int legacy_run_builtin(const std::string& cmd) {
+    static const char* const order[] = {
+        "cd", "exit", "pwd", "echo", "help", "list", "kill", "stop", "resume", "date", "dir",
+        "path", "addpath", "hash", "mlist", "pinfo", "monitor", "stopmonitor", "monitor_silent",
+        "mkdir", "rmdir", "touch", "rm", "cat", "REM", "cls", "fireworks", "snake", "worktime",
+        "cpuinfo", "meminfo", "diskinfo", "history", "clear_history", "calculate", "convert",
+        "location", "weather", "mines", "hangman", "nyancat"};
+    for (int i = 0; i < (int)(sizeof(order) / sizeof(order[0])); ++i) {
+        if (cmd == order[i]) return i;
+    }
+    return -1;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char** argv) {
+    size_t lines = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    // Command names of the script, as the parser hands them over
+    size_t count = 0;
+    const BuiltinInfo* table = builtin_table(count);
+    const char* externals[] = {"ls", "grep", "sort", "gcc", "make", "python3", "tar", "sed"};
+    std::mt19937 rng(42);
+    std::vector<std::string> script;
+    script.reserve(lines);
+    for (size_t i = 0; i < lines; ++i) {
+        if (rng() % 4 == 0) script.push_back(externals[rng() % 8]);
+        else script.push_back(table[rng() % count].name);
+    }
+
+    long sink = 0;
+    auto t0 = Clock::now();
+    for (const auto& name : script) {
+        if (legacy_is_builtin(name)) sink += legacy_run_builtin(name);
+    }
+    auto t1 = Clock::now();
+    for (const auto& name : script) {
+        if (const BuiltinInfo* b = find_builtin(name)) sink += b->flags + 1;
+    }
+    auto t2 = Clock::now();
+
+    double legacy = std::chrono::duration<double, std::nano>(t1 - t0).count() / lines;
+    double registry = std::chrono::duration<double, std::nano>(t2 - t1).count() / lines;
+    std::printf("%zu lines, %zu built-ins, 1 in 4 lines external\n", lines, count);
+    std::printf("%-28s %7.1f ns/command\n", "is_builtin + run_builtin", legacy);
+    std::printf("%-28s %7.1f ns/command\n", "registry (perfect hash)", registry);
+    return sink == 0; // keep the loops from being optimised away
+}
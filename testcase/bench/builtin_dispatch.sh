@@ -0,0 +1,14 @@
+#!/bin/sh
+# Built-in dispatch cost per command on a 1M-line script: the old string
+# chains against the registry lookup.
+#
+# Usage: testcase/bench/builtin_dispatch.sh [lines]
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -I"$ROOT/src/include" -o "$WORK/builtin_dispatch" \
+    "$ROOT/testcase/bench/builtin_dispatch.cpp" "$ROOT"/src/process/*.cpp \
+    "$ROOT/src/calculator.cpp" "$ROOT/src/converter.cpp" -lpthread || exit 1
+"$WORK/builtin_dispatch" "${1:-1000000}"
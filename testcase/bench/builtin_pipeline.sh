@@ -0,0 +1,34 @@
+#!/bin/sh
+# Compare `cat big.txt | cat` with both stages in-process (chunk ring, no
+# kernel pipe) against the same data going through external processes.
+#
+# Usage: testcase/bench/builtin_pipeline.sh [path/to/myShell] [size-in-MiB]
+
+SHELL_BIN=${1:-./build/myShell}
+SIZE_MB=${2:-1024}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+CAT=$(command -v cat)
+DATE=$(command -v date)
+head -c $((SIZE_MB * 1024 * 1024)) /dev/urandom | base64 > "$WORK/big.txt"
+SIZE_MB=$(( $(wc -c < "$WORK/big.txt") / 1024 / 1024 ))
+
+# Time the command between two timestamps taken inside the same session, so
+# the shell's startup and exit banners are not part of the measurement
+bench() {
+    printf '%s\n' "$DATE +%s%N" "$2" "$DATE +%s%N" "exit" | "$SHELL_BIN" 2>/dev/null |
+        grep -ao '[0-9]\{19\}' | tr '\n' ' ' |
+        awk -v label="$1" -v mb="$SIZE_MB" \
+            '{ s = ($2 - $1) / 1e9; printf "%-32s %8.3f s  %8.1f MiB/s\n", label, s, mb / s }'
+}
+
+echo "cat of $SIZE_MB MiB"
+bench "builtin | builtin"                "cat $WORK/big.txt | cat > /dev/null"
+bench "builtin | builtin | builtin"      "cat $WORK/big.txt | cat | cat > /dev/null"
+bench "builtin | external"               "cat $WORK/big.txt | $CAT > /dev/null"
+bench "external | external"              "$CAT $WORK/big.txt | $CAT > /dev/null"
+bench "external | external | external"   "$CAT $WORK/big.txt | $CAT | $CAT > /dev/null"
+
+printf '%s\n' "cat $WORK/big.txt | cat | cat > $WORK/out.txt" "exit" | "$SHELL_BIN" > /dev/null 2>&1
+cmp -s "$WORK/big.txt" "$WORK/out.txt" && echo "in-process output verified" || echo "in-process output MISMATCH"
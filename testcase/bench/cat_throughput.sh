@@ -0,0 +1,49 @@
+#!/bin/sh
+# Throughput of the `cat` built-in against the system cat, copying a
+# cached file to a file, into a pipe, and with -n.
+#
+# Usage: testcase/bench/cat_throughput.sh [path/to/myShell] [size-in-MiB]
+
+SHELL_BIN=${1:-./build/myShell}
+SIZE_MB=${2:-512}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+now() { date +%s.%N; }
+
+report() {
+    awk -v label="$1" -v t0="$2" -v t1="$3" -v base="$4" -v mb="$SIZE_MB" \
+        'BEGIN { s = t1 - t0 - base; if (s < 0.001) s = 0.001; printf "  %-8s %8.3f s  %8.0f MiB/s\n", label, s, mb / s }'
+}
+
+# Text with 100-byte lines, so -n has lines to number; read once to warm the cache
+head -c $((SIZE_MB * 1024 * 1024)) /dev/urandom | base64 -w 99 > "$WORK/in"
+cat "$WORK/in" > /dev/null
+
+# The shell's own start and exit are not part of the measurement
+t0=$(now)
+"$SHELL_BIN" -c "echo" > /dev/null
+t1=$(now)
+BASE=$(awk -v t0="$t0" -v t1="$t1" 'BEGIN { print t1 - t0 }')
+
+echo "cat of $SIZE_MB MiB (shell start-up ${BASE}s subtracted)"
+
+echo "to a file:"
+t0=$(now); cat "$WORK/in" > "$WORK/out"; t1=$(now)
+report "system" "$t0" "$t1" 0
+t0=$(now); "$SHELL_BIN" -c "cat $WORK/in" > "$WORK/out"; t1=$(now)
+report "myShell" "$t0" "$t1" "$BASE"
+cmp -s "$WORK/in" "$WORK/out" || echo "  OUTPUT DIFFERS"
+
+echo "into a pipe:"
+t0=$(now); cat "$WORK/in" | cat > /dev/null; t1=$(now)
+report "system" "$t0" "$t1" 0
+t0=$(now); "$SHELL_BIN" -c "cat $WORK/in" | cat > /dev/null; t1=$(now)
+report "myShell" "$t0" "$t1" "$BASE"
+
+echo "-n to a file:"
+t0=$(now); cat -n "$WORK/in" > "$WORK/out"; t1=$(now)
+report "system" "$t0" "$t1" 0
+t0=$(now); "$SHELL_BIN" -c "cat -n $WORK/in" > "$WORK/out2"; t1=$(now)
+report "myShell" "$t0" "$t1" "$BASE"
+cmp -s "$WORK/out" "$WORK/out2" || echo "  OUTPUT DIFFERS"
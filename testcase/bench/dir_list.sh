@@ -0,0 +1,37 @@
+#!/bin/sh
+# Listing one huge directory with the `dir` built-in against the system ls:
+# names only, sorted by size (size only), and the long format (everything).
+#
+# Usage: testcase/bench/dir_list.sh [path/to/myShell] [entries]
+
+SHELL_BIN=${1:-./build/myShell}
+ENTRIES=${2:-1000000}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+now() { date +%s.%N; }
+
+report() {
+    awk -v label="$1" -v t0="$2" -v t1="$3" -v base="$4" \
+        'BEGIN { s = t1 - t0 - base; printf "  %-8s %8.3f s\n", label, s }'
+}
+
+mkdir "$WORK/d"
+(cd "$WORK/d" && seq -f "f%07g" 1 "$ENTRIES" | xargs touch)
+ls -f "$WORK/d" > /dev/null
+
+# The shell's own start and exit are not part of the measurement
+t0=$(now)
+"$SHELL_BIN" -c "echo" > /dev/null
+t1=$(now)
+BASE=$(awk -v t0="$t0" -v t1="$t1" 'BEGIN { print t1 - t0 }')
+
+echo "$ENTRIES entries (shell start-up ${BASE}s subtracted)"
+for flags in "" "-S" "-l"; do
+    echo "ls $flags:"
+    t0=$(now); ls $flags "$WORK/d" > "$WORK/system.txt"; t1=$(now)
+    report "system" "$t0" "$t1" 0
+    t0=$(now); "$SHELL_BIN" -c "dir $flags $WORK/d" > "$WORK/shell.txt"; t1=$(now)
+    report "myShell" "$t0" "$t1" "$BASE"
+    cmp -s "$WORK/system.txt" "$WORK/shell.txt" || echo "  OUTPUT DIFFERS"
+done
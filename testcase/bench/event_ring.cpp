@@ -0,0 +1,74 @@
+// What one monitor event costs its producer: queued on the lock-free ring
+// by log_monitor_event(), against formatting it onto std::cout the way the
+// monitor threads used to.
+//
+// P producer threads log events as fast as they can while one reader
+// drains, as the prompt or `events --follow` would. The cout figure is for
+// wherever stdout points (the script sends it to /dev/null); a real console
+// is much slower than that.
+//
+// Built and run by event_ring.sh.
+
+#include "event_log.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+std::atomic<bool> monitor_running(true);
+bool monitor_silent = true;
+
+typedef std::chrono::steady_clock Clock;
+
+static ProcEvent sample(int i) {
+    ProcEvent e;
+    e.type = ProcEvent::Fork;
+    e.pid = 1000 + i;
+    e.ppid = 1;
+    e.when = std::chrono::system_clock::now();
+    e.name = "worker";
+    return e;
+}
+
+int main(int argc, char** argv) {
+    int perThread = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    for (int producers : {1, 2, 4}) {
+        std::atomic<bool> done(false);
+        std::thread reader([&] {
+            while (!done) {
+                report_monitor_events();   // silent: drains without printing
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        uint64_t droppedBefore = monitor_events_dropped();
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                ProcEvent e = sample(p);
+                for (int i = 0; i < perThread; ++i) log_monitor_event(e);
+            });
+        }
+        for (auto& t : threads) t.join();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        done = true;
+        reader.join();
+        std::fprintf(stderr, "ring, %d producer(s): %6.1f ns/event (%llu dropped)\n", producers,
+                     ns / ((double)perThread * producers),
+                     (unsigned long long)(monitor_events_dropped() - droppedBefore));
+    }
+
+    int lines = perThread / 10;
+    ProcEvent e = sample(0);
+    auto start = Clock::now();
+    for (int i = 0; i < lines; ++i) {
+        std::cout << "[NEW PROCESS] PID: " << e.pid << " | Name: " << e.name << "\n";
+    }
+    std::cout << std::flush;
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    std::fprintf(stderr, "std::cout line:          %6.1f ns/event\n", ns / lines);
+    return 0;
+}
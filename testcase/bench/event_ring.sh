@@ -0,0 +1,14 @@
+#!/bin/sh
+# Cost of logging one monitor event on the lock-free ring, with 1, 2 and 4
+# producer threads, against printing it with std::cout.
+#
+# Usage: testcase/bench/event_ring.sh [events-per-thread]
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -pthread -I"$ROOT/src/include" -o "$WORK/event_ring" \
+    "$ROOT/testcase/bench/event_ring.cpp" "$ROOT/src/process/event_log.cpp" \
+    "$ROOT/src/process/key_reader.cpp" "$ROOT/src/process/proc_snapshot.cpp" || exit 1
+"$WORK/event_ring" "${1:-1000000}" > /dev/null
@@ -0,0 +1,45 @@
+#!/bin/sh
+# How `find` scales with walker threads on a tree of ENTRIES files
+# (100 x 100 directories), for a names-only search and for one that has
+# to stat every file, against the system find as a baseline.
+#
+# Usage: testcase/bench/find_scaling.sh [path/to/myShell] [entries] [max threads]
+
+SHELL_BIN=${1:-./build/myShell}
+ENTRIES=${2:-2000000}
+MAX_THREADS=${3:-$(nproc)}
+WORK=$(mktemp -d)
+set -f   # the -name pattern is for find, not for this shell
+trap 'rm -rf "$WORK"' EXIT
+
+now() { date +%s.%N; }
+
+PER_DIR=$((ENTRIES / 10000))
+[ "$PER_DIR" -gt 0 ] || PER_DIR=1
+for i in $(seq 0 99); do
+    mkdir -p $(seq -f "$WORK/t/d$i/e%g" 0 99)
+    # One touch per top directory: ~100 names per subdirectory at a time
+    for j in $(seq 0 99); do
+        seq -f "$WORK/t/d$i/e$j/f%g" 1 "$PER_DIR"
+    done | xargs touch
+done
+find "$WORK/t" > /dev/null   # warm the dentry and inode caches
+
+echo "$((PER_DIR * 10000)) files in 10100 directories, $(nproc) CPUs"
+for test in "-name *7" "-size +0"; do
+    echo "find $test:"
+    t0=$(now); find "$WORK/t" $test > "$WORK/system.txt"; t1=$(now)
+    awk -v t0="$t0" -v t1="$t1" 'BEGIN { printf "  %-9s %8.3f s\n", "system", t1 - t0 }'
+    sort -o "$WORK/system.txt" "$WORK/system.txt"
+    base=
+    n=1
+    while [ "$n" -le "$MAX_THREADS" ]; do
+        t0=$(now); "$SHELL_BIN" -c "find -j $n $WORK/t $test" > "$WORK/shell.txt"; t1=$(now)
+        [ -n "$base" ] || base=$(awk -v t0="$t0" -v t1="$t1" 'BEGIN { print t1 - t0 }')
+        awk -v n="$n" -v t0="$t0" -v t1="$t1" -v base="$base" \
+            'BEGIN { s = t1 - t0; printf "  -j %-6d %8.3f s  x%.2f\n", n, s, base / s }'
+        sort -o "$WORK/shell.txt" "$WORK/shell.txt"
+        cmp -s "$WORK/system.txt" "$WORK/shell.txt" || echo "  OUTPUT DIFFERS"
+        n=$((n * 2))
+    done
+done
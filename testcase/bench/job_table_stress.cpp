@@ -0,0 +1,138 @@
+// Hammers the JobTable from several threads at once and checks that it ends
+// up consistent. Writers launch and retire "pipelines" of 1-3 fake pids
+// (disjoint pid ranges per writer), sometimes flipping their status, while
+// readers run lookups by pid and by job id and take `mlist` snapshots and
+// check them. Afterwards the table must be empty.
+//
+// Also reports lookup cost with many live jobs next to the linear scan over
+// a vector that the table replaced.
+//
+// Built and run by job_table_stress.sh.
+
+#include "job_table.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+static std::atomic<bool> failed{false};
+
+static void check(bool ok, const char* what) {
+    if (!ok && !failed.exchange(true)) std::fprintf(stderr, "FAILED: %s\n", what);
+}
+
+static void writer(JobTable& table, int index, int rounds) {
+    std::mt19937 rng(index);
+    proc_id base = (proc_id)(1000000 + index * 10000000);
+    std::vector<proc_id> live;
+    for (int r = 0; r < rounds; ++r) {
+        if (live.size() < 64 && (live.empty() || rng() % 2)) {
+            int stages = 1 + rng() % 3;
+            int job = 0;
+            for (int s = 0; s < stages; ++s) {
+                proc_id pid = base++;
+                int got = table.add(pid, "stress", s % 2 == 0, job);
+                check(job == 0 || got == job, "pipeline stage joined another job");
+                job = got;
+                live.push_back(pid);
+            }
+        } else {
+            size_t i = rng() % live.size();
+            if (rng() % 4 == 0) {
+                check(table.setStatus(live[i], ProcessStatus::Suspended), "setStatus on a live pid");
+            }
+            check(table.remove(live[i]), "remove of a live pid");
+            live[i] = live.back();
+            live.pop_back();
+        }
+    }
+    for (proc_id pid : live) check(table.remove(pid), "final remove");
+}
+
+static void reader(JobTable& table, const std::atomic<bool>& done, long& ops) {
+    std::mt19937 rng(12345);
+    ProcessInfo info;
+    while (!done) {
+        std::vector<ProcessInfo> all = table.snapshot();
+        for (size_t i = 1; i < all.size(); ++i) {
+            check(all[i - 1].job_id <= all[i].job_id, "snapshot ordered by job");
+        }
+        if (!all.empty()) {
+            const ProcessInfo& p = all[rng() % all.size()];
+            if (table.find(p.pid, info)) check(info.pid == p.pid, "find returns the asked pid");
+            for (const auto& m : table.job(p.job_id)) check(m.job_id == p.job_id, "job() members");
+        }
+        ops += 3;
+    }
+}
+
+static double nsPer(std::chrono::steady_clock::duration d, long n) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+}
+
+int main(int argc, char** argv) {
+    int writers = argc > 1 ? std::atoi(argv[1]) : 4;
+    int readers = argc > 2 ? std::atoi(argv[2]) : 4;
+    int rounds = argc > 3 ? std::atoi(argv[3]) : 200000;
+
+    JobTable table;
+    std::atomic<bool> done{false};
+    std::vector<long> readOps(readers);
+    std::vector<std::thread> threads;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < readers; ++i) threads.emplace_back(reader, std::ref(table), std::cref(done), std::ref(readOps[i]));
+    std::vector<std::thread> writing;
+    for (int i = 0; i < writers; ++i) writing.emplace_back(writer, std::ref(table), i, rounds);
+    for (auto& t : writing) t.join();
+    auto t1 = std::chrono::steady_clock::now();
+    done = true;
+    for (auto& t : threads) t.join();
+
+    check(table.size() == 0, "table empty at the end");
+    check(table.snapshot().empty(), "snapshot empty at the end");
+    check(table.add(1, "after", false) == 1, "job ids start over once the table is empty");
+
+    long reads = 0;
+    for (long n : readOps) reads += n;
+    std::printf("%d writers x %d rounds, %d readers: %.2f s, %ld reader ops\n",
+                writers, rounds, readers, std::chrono::duration<double>(t1 - t0).count(), reads);
+
+    // Lookup cost with many live jobs
+    const int kJobs = 10000, kLookups = 1000000;
+    JobTable big;
+    std::vector<ProcessInfo> vec;
+    for (int i = 0; i < kJobs; ++i) {
+        big.add(100 + i, "job", true);
+        vec.push_back(ProcessInfo{(proc_id)(100 + i), i + 1, ProcessStatus::Running, true, "job"});
+    }
+    std::mt19937 rng(7);
+    ProcessInfo info;
+    long hits = 0;
+    auto a = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; ++i) hits += big.find((proc_id)(100 + rng() % kJobs), info);
+    auto b = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; ++i) {
+        proc_id pid = (proc_id)(100 + rng() % kJobs);
+        hits += std::find_if(vec.begin(), vec.end(), [pid](const ProcessInfo& p) { return p.pid == pid; }) != vec.end();
+    }
+    auto c = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; ++i) hits += !big.job(1 + rng() % kJobs).empty();
+    auto d = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i) hits += big.snapshot().size() == kJobs;
+    auto e = std::chrono::steady_clock::now();
+
+    std::printf("%d live jobs (%ld hits)\n", kJobs, hits);
+    std::printf("find by pid (table)        %10.1f ns\n", nsPer(b - a, kLookups));
+    std::printf("find by pid (vector scan)  %10.1f ns\n", nsPer(c - b, kLookups));
+    std::printf("job by id (%%N)             %10.1f ns\n", nsPer(d - c, kLookups));
+    std::printf("snapshot (mlist)           %10.1f us\n", nsPer(e - d, 100) / 1000);
+
+    if (failed) return 1;
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Concurrent stress test of the job table, plus lookup cost with 10k live jobs.
+# Exits non-zero if the table was ever seen inconsistent.
+#
+# Usage: testcase/bench/job_table_stress.sh [writers] [readers] [rounds]
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -pthread -I"$ROOT/src/include" -o "$WORK/job_table_stress" \
+    "$ROOT/testcase/bench/job_table_stress.cpp" "$ROOT/src/process/job_table.cpp" || exit 1
+"$WORK/job_table_stress" "${1:-4}" "${2:-4}" "${3:-200000}"
@@ -0,0 +1,77 @@
+// How many short-lived processes each monitor backend notices.
+//
+// Forks N children that exit at once (each reaped before the next fork)
+// while a ProcMonitor runs, then counts the children whose start and exit
+// the monitor reported. The proc connector should see all of them; the
+// /proc scan only sees a child that is alive during a scan, so it catches
+// next to none. The old WMI monitor polled once a second and would do the
+// same.
+//
+// Built and run by monitor_catch.sh.
+
+#include "proc_monitor.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+static void trial(ProcMonitorBackend backend, int children) {
+    ProcMonitor monitor;
+    if (!monitor.open(backend)) {
+        std::printf("%-24s unavailable here\n", proc_monitor_backend_name(backend));
+        return;
+    }
+
+    std::mutex mutex;
+    std::unordered_set<pid_t> forks, exits;
+    std::atomic<bool> running(true);
+    std::thread watcher([&] {
+        monitor.run(running, [&](const ProcEvent& e) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (e.type == ProcEvent::Fork) forks.insert(e.pid);
+            else if (e.type == ProcEvent::Exit) exits.insert(e.pid);
+        });
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));   // let it take its first look
+
+    std::vector<pid_t> pids;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < children; ++i) {
+        pid_t pid = fork();
+        if (pid == 0) _exit(0);
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        waitpid(pid, nullptr, 0);
+        pids.push_back(pid);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));   // a full scan interval and then some
+    running = false;
+    watcher.join();
+
+    // pids repeat once pid_max wraps; count distinct ones on both sides
+    std::unordered_set<pid_t> launched(pids.begin(), pids.end());
+    size_t sawFork = 0, sawExit = 0;
+    for (pid_t pid : launched) {
+        sawFork += forks.count(pid);
+        sawExit += exits.count(pid);
+    }
+    std::printf("%-24s %zu distinct children in %.2fs: saw %zu starts (%.1f%%), %zu exits (%.1f%%), %lu overruns\n",
+                proc_monitor_backend_name(backend), launched.size(), seconds,
+                sawFork, 100.0 * sawFork / launched.size(), sawExit, 100.0 * sawExit / launched.size(), monitor.lost());
+}
+
+int main(int argc, char** argv) {
+    int children = argc > 1 ? std::atoi(argv[1]) : 10000;
+    trial(ProcMonitorBackend::Netlink, children);
+    trial(ProcMonitorBackend::ProcScan, children);
+    return 0;
+}
@@ -0,0 +1,14 @@
+#!/bin/sh
+# Fork N short-lived children and report how many of them each process
+# monitor backend (proc connector, /proc scan) caught.
+#
+# Usage: testcase/bench/monitor_catch.sh [children]
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -pthread -I"$ROOT/src/include" -o "$WORK/monitor_catch" \
+    "$ROOT/testcase/bench/monitor_catch.cpp" "$ROOT/src/process/proc_monitor.cpp" \
+    "$ROOT/src/process/proc_snapshot.cpp" "$ROOT/src/process/reaper.cpp" "$ROOT/src/process/job_table.cpp" || exit 1
+"$WORK/monitor_catch" "${1:-10000}"
@@ -0,0 +1,17 @@
+#!/bin/sh
+# Wall time of `parallel` running JOBS `sleep 0.1` jobs at several slot
+# counts. The jobs only sleep, so the time should fall close to
+# JOBS * 0.1 / N until start-up and reaping costs show through.
+#
+# Usage: testcase/bench/parallel_jobs.sh [path/to/myShell] [jobs]
+
+SHELL_BIN=${1:-./build/myShell}
+JOBS=${2:-64}
+DATE=$(command -v date)
+ARGS=$(yes 0.1 | head -n "$JOBS" | tr '\n' ' ')
+
+for n in 1 8 32 "$JOBS"; do
+    printf '%s\n' "$DATE +%s%N" "parallel -j $n sleep {} ::: $ARGS" "$DATE +%s%N" exit |
+        "$SHELL_BIN" 2>/dev/null | grep -ao '[0-9]\{19\}' |
+        awk -v n="$n" -v jobs="$JOBS" 'NR == 2 { printf "%4d jobs, -j %-4d %8.3f s\n", jobs, n, ($1 - prev) / 1e9 } { prev = $1 }'
+done
@@ -0,0 +1,126 @@
+// Parse throughput (lines/sec) and heap allocations per line for a generated
+// script: the old string-copying tokenizer, parsePipeline (views, then owned
+// strings), and parsePipelineView into an arena that is reset every line.
+//
+// Built and run by parse_throughput.sh.
+
+#include "parser.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+static size_t g_allocs = 0;
+
+void* operator new(size_t size) {
+    ++g_allocs;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// --- The parser as it was: a std::string per token, copied twice ---
+
+static std::vector<std::string> legacySplitTokens(const std::string &s) {
+    std::vector<std::string> tokens;
+    bool inQuotes = false;
+    std::string token;
+    for (char c : s) {
+        if (c == '"') {
+            inQuotes = !inQuotes;
+        } else if (std::isspace(static_cast<unsigned char>(c)) && !inQuotes) {
+            if (!token.empty()) {
+                tokens.push_back(token);
+                token.clear();
+            }
+        } else {
+            token.push_back(c);
+        }
+    }
+    if (!token.empty()) tokens.push_back(token);
+    return tokens;
+}
+
+static Command legacyParseCommand(const std::string &line) {
+    Command cmd;
+    auto tokens = legacySplitTokens(line);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const std::string &t = tokens[i];
+        if (t == "&" && i == tokens.size() - 1) cmd.background = true;
+        else if (t == ">>" && i + 1 < tokens.size()) { cmd.outfile = tokens[++i]; cmd.appendMode = true; }
+        else if (t == ">" && i + 1 < tokens.size()) { cmd.outfile = tokens[++i]; cmd.appendMode = false; }
+        else if (t == "<" && i + 1 < tokens.size()) cmd.infile = tokens[++i];
+        else cmd.argv.push_back(t);
+    }
+    return cmd;
+}
+
+static Pipeline legacyParsePipeline(const std::string &line) {
+    std::vector<std::string> texts;
+    bool inQuotes = false;
+    std::string current;
+    for (char c : line) {
+        if (c == '"') { inQuotes = !inQuotes; current.push_back(c); }
+        else if (c == '|' && !inQuotes) { texts.push_back(current); current.clear(); }
+        else current.push_back(c);
+    }
+    texts.push_back(current);
+
+    Pipeline pl;
+    for (const auto &text : texts) pl.stages.push_back(legacyParseCommand(text));
+    pl.background = pl.stages.back().background;
+    return pl;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+template <typename Fn>
+static void run(const char* label, const std::vector<std::string>& script, Fn parse) {
+    size_t sink = 0;
+    size_t allocs = g_allocs;
+    auto t0 = Clock::now();
+    for (const auto& line : script) sink += parse(line);
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    allocs = g_allocs - allocs;
+    std::printf("%-30s %10.0f lines/s  %6.2f allocs/line  (%zu tokens)\n",
+                label, script.size() / secs, (double)allocs / script.size(), sink);
+}
+
+int main(int argc, char** argv) {
+    size_t lines = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    const char* templates[] = {
+        "ls -la /tmp",
+        "echo \"hello world\" >> log.txt",
+        "grep -n \"needle in\" haystack.txt | sort | uniq -c > counts.txt",
+        "cat < input.txt | tr a-z A-Z | wc -l",
+        "calculate \"2 ^ 10 + 5!\"",
+        "sleep 1 &",
+        "convert 255 from 10 to 16",
+        "find . -name *.cpp -size +10 | head -20",
+    };
+    std::vector<std::string> script;
+    script.reserve(lines);
+    for (size_t i = 0; i < lines; ++i) script.push_back(templates[i % 8]);
+    std::printf("%zu lines\n", lines);
+
+    run("old tokenizer (owned)", script, [](const std::string& line) {
+        Pipeline pl = legacyParsePipeline(line);
+        return pl.stages.front().argv.size();
+    });
+    run("parsePipeline (owned)", script, [](const std::string& line) {
+        Pipeline pl = parsePipeline(line);
+        return pl.stages.front().argv.size();
+    });
+    Arena arena;
+    run("parsePipelineView (arena)", script, [&arena](const std::string& line) {
+        arena.reset();
+        PipelineView view;
+        parsePipelineView(line, arena, view);
+        return view.stages[0].argc;
+    });
+    return 0;
+}
@@ -0,0 +1,12 @@
+#!/bin/sh
+# Parse throughput and allocations per line on a generated script.
+#
+# Usage: testcase/bench/parse_throughput.sh [lines]
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -I"$ROOT/src/include" -o "$WORK/parse_throughput" \
+    "$ROOT/testcase/bench/parse_throughput.cpp" "$ROOT/src/process/parser.cpp" || exit 1
+"$WORK/parse_throughput" "${1:-1000000}"
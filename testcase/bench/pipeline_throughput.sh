@@ -0,0 +1,49 @@
+#!/bin/sh
+# Stream a multi-GB input through a 4-stage pipeline inside myShell and
+# compare it with the old "> tmp / < tmp" round trip through disk.
+#
+# Usage: testcase/bench/pipeline_throughput.sh [path/to/myShell] [size-in-MiB]
+
+SHELL_BIN=${1:-./build/myShell}
+SIZE_MB=${2:-4096}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+BYTES=$((SIZE_MB * 1024 * 1024))
+
+now() { date +%s.%N; }
+
+run() {
+    printf '%s\nexit\n' "$1" | "$SHELL_BIN" > "$WORK/shell.log" 2>&1
+}
+
+report() {
+    awk -v label="$1" -v t0="$2" -v t1="$3" -v base="$BASE" -v mb="$SIZE_MB" \
+        'BEGIN { s = t1 - t0 - base; printf "%-10s %8.2f s  %8.1f MiB/s\n", label, s, mb / s }'
+}
+
+# Startup and exit banners are not part of the measurement
+t0=$(now)
+run ""
+t1=$(now)
+BASE=$(awk -v t0="$t0" -v t1="$t1" 'BEGIN { print t1 - t0 }')
+
+echo "Streaming $SIZE_MB MiB through 4 stages (session overhead ${BASE}s subtracted)"
+
+t0=$(now)
+run "head -c $BYTES /dev/zero | tr \\000 a | tr a b | wc -c > $WORK/piped.txt"
+t1=$(now)
+report "pipeline" "$t0" "$t1"
+
+t0=$(now)
+printf '%s\n' \
+    "head -c $BYTES /dev/zero > $WORK/s1" \
+    "tr \\000 a < $WORK/s1 > $WORK/s2" \
+    "tr a b < $WORK/s2 > $WORK/s3" \
+    "wc -c < $WORK/s3 > $WORK/staged.txt" \
+    "exit" | "$SHELL_BIN" > "$WORK/shell.log" 2>&1
+t1=$(now)
+report "tmp files" "$t0" "$t1"
+
+echo "pipeline bytes:  $(cat "$WORK/piped.txt")"
+echo "tmp-file bytes:  $(cat "$WORK/staged.txt")"
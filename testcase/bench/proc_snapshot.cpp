@@ -0,0 +1,109 @@
+// How long one `list` snapshot takes as the process count grows.
+//
+// Parks extra children in pause() to grow the table, then times three ways
+// of reading every process's stat, memory and command line:
+//   naive    what `list` used to grow into: a path string and an ifstream
+//            per file (stat, statm, cmdline), parsed with >>
+//   serial   take_proc_snapshot() with one reader
+//   auto     take_proc_snapshot() with one reader per kSnapshotChunk pids,
+//            up to the CPU count
+// Each figure is the median of several runs.
+//
+// Built and run by proc_snapshot.sh.
+
+#include "proc_snapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <signal.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static size_t naiveSnapshot() {
+    size_t count = 0;
+    DIR* proc = opendir("/proc");
+    if (!proc) return 0;
+    while (struct dirent* entry = readdir(proc)) {
+        char* end;
+        std::strtol(entry->d_name, &end, 10);
+        if (*end != '\0') continue;
+        std::string dir = std::string("/proc/") + entry->d_name;
+
+        std::ifstream stat(dir + "/stat");
+        std::string line;
+        if (!std::getline(stat, line)) continue;
+        std::istringstream fields(line.substr(line.rfind(')') + 2));
+        std::vector<std::string> values;
+        for (std::string v; fields >> v;) values.push_back(v);
+
+        std::ifstream statm(dir + "/statm");
+        unsigned long size = 0, resident = 0;
+        statm >> size >> resident;
+
+        std::ifstream cmd(dir + "/cmdline");
+        std::string cmdline((std::istreambuf_iterator<char>(cmd)), std::istreambuf_iterator<char>());
+        count += values.size() > 20 && resident + cmdline.size() + 1 > 0;
+    }
+    closedir(proc);
+    return count;
+}
+
+template <typename F>
+static double medianMs(int runs, F f) {
+    std::vector<double> ms;
+    for (int i = 0; i < runs; ++i) {
+        auto start = Clock::now();
+        f();
+        ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    std::sort(ms.begin(), ms.end());
+    return ms[ms.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? std::atoi(argv[1]) : 5;
+    std::vector<int> extras;
+    for (int i = 2; i < argc; ++i) extras.push_back(std::atoi(argv[i]));
+    if (extras.empty()) extras = {0, 1000, 4000};
+
+    std::vector<pid_t> children;
+    std::printf("%10s %10s %10s %10s %10s %8s\n", "processes", "naive ms", "serial ms", "auto ms", "per-pid us", "speedup");
+    for (int extra : extras) {
+        while ((int)children.size() < extra) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                pause();
+                _exit(0);
+            }
+            if (pid < 0) {
+                perror("fork");
+                break;
+            }
+            children.push_back(pid);
+        }
+
+        SnapshotOptions serial;
+        serial.cmdline = true;
+        serial.threads = 1;
+        SnapshotOptions automatic;
+        automatic.cmdline = true;
+
+        size_t processes = take_proc_snapshot(automatic).size();
+        double naive = medianMs(runs, naiveSnapshot);
+        double one = medianMs(runs, [&] { take_proc_snapshot(serial); });
+        double many = medianMs(runs, [&] { take_proc_snapshot(automatic); });
+        std::printf("%10zu %10.2f %10.2f %10.2f %10.2f %7.1fx\n", processes, naive, one, many,
+                    1000.0 * many / std::max<size_t>(processes, 1), naive / many);
+    }
+
+    for (pid_t pid : children) kill(pid, SIGKILL);
+    for (pid_t pid : children) waitpid(pid, nullptr, 0);
+    return 0;
+}
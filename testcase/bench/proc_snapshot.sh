@@ -0,0 +1,13 @@
+#!/bin/sh
+# Time to snapshot every process (stat, memory, command line) for `list`,
+# at the current process count and with extra parked children.
+#
+# Usage: testcase/bench/proc_snapshot.sh [runs] [extra-children ...]
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -pthread -I"$ROOT/src/include" -o "$WORK/proc_snapshot" \
+    "$ROOT/testcase/bench/proc_snapshot.cpp" "$ROOT/src/process/proc_snapshot.cpp" || exit 1
+"$WORK/proc_snapshot" "$@"
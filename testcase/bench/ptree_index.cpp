@@ -0,0 +1,61 @@
+// How long `ptree` spends on the tree itself: building the children index
+// over a snapshot and walking every process's subtree from the root.
+//
+// Synthetic snapshots of N processes, each the child of a random earlier
+// one (so the depth is about ln N), plus the real system for reference.
+// Each figure is the median of several runs.
+//
+// Built and run by ptree_index.sh.
+
+#include "proc_tree.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+
+typedef std::chrono::steady_clock Clock;
+
+static std::vector<ProcSample> synthetic(int n) {
+    std::mt19937 rng(42);
+    std::vector<ProcSample> procs(n);
+    for (int i = 0; i < n; ++i) {
+        procs[i].pid = i + 1;
+        procs[i].ppid = i == 0 ? 0 : 1 + rng() % i;
+        procs[i].name = "proc";
+    }
+    return procs;
+}
+
+template <typename F>
+static double medianMs(F f) {
+    std::vector<double> ms;
+    for (int i = 0; i < 7; ++i) {
+        auto start = Clock::now();
+        f();
+        ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    std::sort(ms.begin(), ms.end());
+    return ms[ms.size() / 2];
+}
+
+static void report(const char* label, const std::vector<ProcSample>& procs, proc_id root) {
+    size_t walked = 0;
+    double build = medianMs([&] { ProcTree tree(procs); });
+    ProcTree tree(procs);
+    double walk = medianMs([&] { walked = tree.subtree(root).size(); });
+    double print = medianMs([&] {
+        std::ostringstream out;
+        tree.print(root, out);
+    });
+    std::printf("%-10s %8zu processes: index %7.3f ms, subtree %7.3f ms (%zu), print %7.3f ms\n",
+                label, procs.size(), build, walk, walked, print);
+}
+
+int main() {
+    for (int n : {1000, 10000, 100000}) report("synthetic", synthetic(n), 1);
+    std::vector<ProcSample> real = take_proc_snapshot();
+    if (!real.empty()) report("this host", real, real.front().pid);
+    return 0;
+}
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Time to index a process snapshot by parent and walk a subtree, for
+# `ptree`, at 1k, 10k and 100k processes.
+#
+# Usage: testcase/bench/ptree_index.sh
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -pthread -I"$ROOT/src/include" -o "$WORK/ptree_index" \
+    "$ROOT/testcase/bench/ptree_index.cpp" "$ROOT/src/process/proc_tree.cpp" "$ROOT/src/process/proc_snapshot.cpp" || exit 1
+"$WORK/ptree_index"
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Time from a background child's death to its job entry turning Done, and
+# the shell's CPU use while it only waits on children.
+#
+# Usage: testcase/bench/reap_latency.sh [kills] [idle-children]
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -pthread -I"$ROOT/src/include" -o "$WORK/reap_latency" \
+    "$ROOT/testcase/bench/reap_latency.cpp" "$ROOT/src/process/job_table.cpp" "$ROOT/src/process/reaper.cpp" || exit 1
+"$WORK/reap_latency" "${1:-200}" "${2:-100}"
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Cost of `source` on a large script: first run (read + compile), a repeat
+# run from the in-memory cache, and the first run of a fresh shell that finds
+# the compiled script in TINYSHELL_CACHE_DIR. The script is all REM lines, so
+# the time is parsing and dispatch rather than the commands themselves.
+#
+# Usage: testcase/bench/script_cache.sh [path/to/myShell] [lines]
+
+SHELL_BIN=${1:-./build/myShell}
+LINES=${2:-200000}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+mkdir "$WORK/cache"
+
+DATE=$(command -v date)
+awk -v n="$LINES" 'BEGIN { for (i = 0; i < n; i++) printf "REM step %d \"quoted words\" and more arguments\n", i }' > "$WORK/script.txt"
+
+# Print the gaps between consecutive in-session timestamps, one per label
+session() {
+    printf '%s\n' "$@" exit | TINYSHELL_CACHE_DIR="$WORK/cache" "$SHELL_BIN" 2>/dev/null |
+        grep -ao '[0-9]\{19\}' | awk 'NR > 1 { printf "%.3f\n", ($1 - prev) / 1e9 } { prev = $1 }'
+}
+
+echo "source of a $LINES-line script"
+session "$DATE +%s%N" "source $WORK/script.txt" "$DATE +%s%N" "source $WORK/script.txt" "$DATE +%s%N" |
+    paste - - | awk '{ printf "%-28s %8s s\n%-28s %8s s\n", "first run (compile)", $1, "repeat (in-memory cache)", $2 }'
+session "$DATE +%s%N" "source $WORK/script.txt" "$DATE +%s%N" |
+    awk '{ printf "%-28s %8s s\n", "new shell (on-disk cache)", $1 }'
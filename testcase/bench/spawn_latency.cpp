@@ -0,0 +1,91 @@
+// Fork-to-exec latency of the shell's ProcessLauncher against plain
+// fork() + execvp(). Each spawn runs /bin/true and is reaped before the next,
+// so the numbers are per-launch cost, not throughput under concurrency.
+// The parent first touches `heap-MiB` of memory to stand in for a long-running
+// shell: fork() has to copy its page tables, posix_spawn's vfork does not.
+//
+// Built and run by spawn_latency.sh.
+
+#include "process_launcher.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// The launcher reaches the built-in table through the `run` limits, so the
+// whole of src/process is linked in; the shell's main.cpp provides these,
+// and the benchmark never calls them
+pid_t g_currentProcess = 0;
+void animateFirework() {}
+void clear_all_command_history() {}
+const std::vector<std::string>& get_command_history() {
+    static std::vector<std::string> none;
+    return none;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double micros(Clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+static void report(const char* label, std::vector<double>& launch, double totalSec) {
+    std::sort(launch.begin(), launch.end());
+    double p50 = launch[launch.size() / 2];
+    double p99 = launch[std::min(launch.size() - 1, launch.size() * 99 / 100)];
+    std::printf("%-22s p50 %8.1f us   p99 %8.1f us   %8.0f spawns/s\n",
+                label, p50, p99, launch.size() / totalSec);
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? std::atoi(argv[1]) : 2000;
+    size_t heapMiB = argc > 2 ? std::atoi(argv[2]) : 256;
+
+    std::vector<char> heap(heapMiB * 1024 * 1024);
+    for (size_t i = 0; i < heap.size(); i += 4096) heap[i] = 1;
+
+    Command cmd;
+    cmd.argv = {"/bin/true"};
+    std::vector<double> launch;
+    launch.reserve(runs);
+
+    // Launch latency: time until launch() returns with the child started
+    ProcessLauncher& launcher = default_launcher();
+    auto start = Clock::now();
+    for (int i = 0; i < runs; ++i) {
+        LaunchedProcess proc;
+        auto t0 = Clock::now();
+        if (!launcher.launch(cmd, kNoHandle, kNoHandle, proc)) return 1;
+        launch.push_back(micros(Clock::now() - t0));
+        launcher.wait(proc);
+    }
+    std::printf("%d spawns of /bin/true, %zu MiB resident parent\n", runs, heapMiB);
+    report("posix_spawn launcher", launch,
+           std::chrono::duration<double>(Clock::now() - start).count());
+
+    // Baseline: the parent side of fork() returns once the page tables
+    // are copied; exec happens afterwards in the child
+    launch.clear();
+    start = Clock::now();
+    for (int i = 0; i < runs; ++i) {
+        auto t0 = Clock::now();
+        pid_t pid = fork();
+        if (pid == 0) {
+            char* args[] = {const_cast<char*>("/bin/true"), nullptr};
+            execvp(args[0], args);
+            _exit(127);
+        }
+        launch.push_back(micros(Clock::now() - t0));
+        int status;
+        waitpid(pid, &status, 0);
+    }
+    report("fork + execvp", launch,
+           std::chrono::duration<double>(Clock::now() - start).count());
+    return 0;
+}
@@ -0,0 +1,14 @@
+#!/bin/sh
+# Per-spawn latency (p50/p99) and spawns/sec of the ProcessLauncher used for
+# external commands, compared with fork() + execvp() from the same process.
+#
+# Usage: testcase/bench/spawn_latency.sh [spawns] [parent-heap-MiB]
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -I"$ROOT/src/include" -o "$WORK/spawn_latency" \
+    "$ROOT/testcase/bench/spawn_latency.cpp" "$ROOT"/src/process/*.cpp \
+    "$ROOT/src/calculator.cpp" "$ROOT/src/converter.cpp" -lpthread || exit 1
+"$WORK/spawn_latency" "${1:-2000}" "${2:-256}"
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Time to first command: from starting myShell to its first command running,
+# which is `date` printing a timestamp. The non-interactive modes are
+# averaged over RUNS starts. The interactive start-up (forced with -i, with
+# banner animations and the monitor thread) is only timed once.
+#
+# Usage: testcase/bench/startup.sh [path/to/myShell] [runs]
+
+SHELL_BIN=${1:-./build/myShell}
+RUNS=${2:-200}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+DATE=$(command -v date)
+echo "$DATE +%s%N" > "$WORK/script.txt"
+
+# Mean gap between the start timestamp and the one printed by the shell
+measure() {
+    label=$1
+    runs=$2
+    shift 2
+    i=0
+    while [ "$i" -lt "$runs" ]; do
+        start=$("$DATE" +%s%N)
+        first=$("$@" 2>/dev/null | grep -ao '[0-9]\{19\}' | head -n 1)
+        echo $((first - start))
+        i=$((i + 1))
+    done | awk -v label="$label" -v runs="$runs" \
+        '{ sum += $1 } END { printf "%-26s %10.3f ms  (%d runs)\n", label, sum / NR / 1e6, runs }'
+}
+
+stdin_mode() { echo "$DATE +%s%N" | "$SHELL_BIN"; }
+interactive() { printf '%s\n' "$DATE +%s%N" exit | "$SHELL_BIN" -i; }
+
+measure "myShell -c"            "$RUNS" "$SHELL_BIN" -c "$DATE +%s%N"
+measure "myShell script"        "$RUNS" "$SHELL_BIN" "$WORK/script.txt"
+measure "commands on stdin"     "$RUNS" stdin_mode
+measure "interactive (-i)"      1 interactive
@@ -0,0 +1,12 @@
+#!/bin/sh
+# Cost of one `watch` sample with the /proc files reopened every time
+# against kept open, and the CPU share of 50 watches at 100 ms.
+#
+# Usage: testcase/bench/watch_sample.sh
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+${CXX:-c++} -O2 -std=c++17 -o "$WORK/watch_sample" "$ROOT/testcase/bench/watch_sample.cpp" || exit 1
+"$WORK/watch_sample"